@@ -0,0 +1,607 @@
+/*
+    Benchmarks for DependencyInjected Pattern
+
+    Compares the cost of calling through the wrappers and dependency handles
+    against raw pointers and references, and reports the sizes of the
+    wrappers and of typical Dependencies structs so layout regressions show
+    up next to the timings.
+
+    Must be built in Release mode, e.g.:
+
+        MSVC:   DependencyInjectedBenchmark.vcxproj (Release|x64)
+        GCC:    g++ -O2 -std=c++17 -pthread Benchmark.cpp -o benchmark
+        Clang:  clang++ -O2 -std=c++17 -pthread Benchmark.cpp -o benchmark
+
+    Add -DDI_HARDENED to measure the cost of the release-mode checks: The
+    "Cost of the checks" rows compare each checked access against the same
+    access through Get() in the same build.  CMakeLists.txt builds this as
+    DependencyInjectedBenchmarkHardened.  Likewise -DDI_COUNT_ACCESSES for
+    the cost of the per-edge access counters.
+*/
+
+#include "DependencyInjected.h"
+#include "DependencyContainer.h"
+#include "DependencyRegistry.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+
+
+//------------------------------------------------------------------------------
+// Benchmark harness
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+    #define BENCH_NOINLINE __declspec(noinline)
+#else // _MSC_VER
+    #define BENCH_NOINLINE __attribute__((noinline))
+#endif // _MSC_VER
+
+// Keeps the compiler from discarding a value
+template<class T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(_MSC_VER)
+    static volatile const void* sink;
+    sink = &value;
+#else // _MSC_VER
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif // _MSC_VER
+}
+
+// Keeps the compiler from folding a loop of stores, e.g. into one multiply
+inline void ClobberMemory()
+{
+#if defined(_MSC_VER)
+    _ReadWriteBarrier();
+#else // _MSC_VER
+    asm volatile("" : : : "memory");
+#endif // _MSC_VER
+}
+
+static const int kRepeats = 7;
+
+// Best of kRepeats, in nanoseconds per iteration
+template<class F>
+double Measure(uint64_t iterations, F&& body)
+{
+    double best = 1e30;
+
+    for (int r = 0; r < kRepeats; ++r)
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        body(iterations);
+        const auto t1 = std::chrono::steady_clock::now();
+
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+        if (best > ns)
+            best = ns;
+    }
+
+    return best;
+}
+
+// Below this the baseline loop was folded or is timer noise, and a
+// percentage against it means nothing
+static const double kMinBaselineNs = 0.05;
+
+static void Report(const char* name, double ns, double baselineNs, const char* baselineName = "raw")
+{
+    if (baselineNs < kMinBaselineNs)
+        printf("  %-44s %8.3f ns/op  (baseline too small to compare)\n", name, ns);
+    else
+        printf("  %-44s %8.3f ns/op  (%+6.1f%% vs %s)\n", name, ns,
+            (ns - baselineNs) * 100. / baselineNs, baselineName);
+}
+
+static void ReportSize(const char* name, size_t bytes)
+{
+    printf("  %-44s %6u bytes\n", name, static_cast<unsigned>(bytes));
+}
+
+
+//------------------------------------------------------------------------------
+// Benchmark objects
+
+class Counter
+{
+public:
+    struct Dependencies
+    {
+    };
+
+    bool Initialize(const Dependencies& deps)
+    {
+        Count = 0;
+        return true;
+    }
+    void Shutdown()
+    {
+    }
+
+    DI_FORCE_INLINE void Add(uint64_t x)
+    {
+        Count += x;
+    }
+    uint64_t Get() const
+    {
+        return Count;
+    }
+
+private:
+    uint64_t Count = 0;
+};
+
+class CounterUser
+{
+public:
+    struct Dependencies
+    {
+        RequiredDependency<Counter> counter;
+        OptionalDependency<Counter> optionalCounter;
+    };
+
+    bool Initialize(const Dependencies& deps)
+    {
+        Deps = deps;
+        return true;
+    }
+    void Shutdown()
+    {
+    }
+
+    Dependencies Deps;
+};
+
+class ICounter
+{
+public:
+    virtual ~ICounter() {}
+
+    virtual void Add(uint64_t x) = 0;
+    virtual uint64_t Get() const = 0;
+};
+
+class CounterImplementation final : public ICounter
+{
+public:
+    struct Dependencies
+    {
+    };
+
+    bool Initialize(const Dependencies& deps)
+    {
+        Count = 0;
+        return true;
+    }
+    void Shutdown()
+    {
+    }
+
+    void Add(uint64_t x) override
+    {
+        Count += x;
+    }
+    uint64_t Get() const override
+    {
+        return Count;
+    }
+
+private:
+    uint64_t Count = 0;
+};
+
+struct InterfaceDependencies
+{
+    // Explicitly unbound, so calls are virtual
+    RequiredDependency<ICounter, ICounter> virtualCounter;
+
+    // Bound to the implementation, so calls are direct
+    RequiredDependency<ICounter, CounterImplementation> boundCounter;
+};
+
+// Typical Dependencies structs
+struct ThreeDependencies
+{
+    RequiredDependency<Counter> a;
+    RequiredDependency<Counter> b;
+    OptionalDependency<Counter> c;
+};
+
+struct SixDependencies
+{
+    RequiredDependency<Counter> a;
+    RequiredDependency<Counter> b;
+    RequiredDependency<Counter> c;
+    OptionalDependency<Counter> d;
+    OptionalDependency<Counter> e;
+    OptionalDependency<Counter> f;
+};
+
+// The tester always builds with DEBUG, so the release layout is checked here
+#if !defined(DI_DEPENDENCY_WRAPPER) && !defined(DI_COUNT_ACCESSES)
+// Optionals keep their wrapper, so Initialize() can tell whether it is up
+static_assert(sizeof(RequiredDependency<Counter>) == sizeof(void*), "Must be pointer-sized");
+static_assert(sizeof(LateBound<RequiredDependency<Counter>>) == sizeof(void*), "Must be pointer-sized");
+static_assert(sizeof(OptionalDependency<Counter>) == 2 * sizeof(void*), "Must be two pointers");
+static_assert(sizeof(SixDependencies) == 9 * sizeof(void*), "Must not be padded");
+#endif // DI_DEPENDENCY_WRAPPER && DI_COUNT_ACCESSES
+
+
+//------------------------------------------------------------------------------
+// Call-through benchmarks
+
+static const uint64_t kCallIterations = 200000000;
+
+BENCH_NOINLINE void Bench_RawPointer(Counter* counter, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        counter->Add(i);
+        ClobberMemory();
+    }
+    DoNotOptimize(counter->Get());
+}
+
+BENCH_NOINLINE void Bench_Reference(Counter& counter, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        counter.Add(i);
+        ClobberMemory();
+    }
+    DoNotOptimize(counter.Get());
+}
+
+BENCH_NOINLINE void Bench_Wrapper(DependencyInjected<Counter>& counter, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        counter->Add(i);
+        ClobberMemory();
+    }
+    DoNotOptimize(counter->Get());
+}
+
+BENCH_NOINLINE void Bench_Required(const CounterUser::Dependencies& deps, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        deps.counter->Add(i);
+        ClobberMemory();
+    }
+    DoNotOptimize(deps.counter->Get());
+}
+
+BENCH_NOINLINE void Bench_RawNullCheck(Counter* counter, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        if (counter)
+            counter->Add(i);
+        ClobberMemory();
+    }
+    DoNotOptimize(counter->Get());
+}
+
+BENCH_NOINLINE void Bench_Optional(const CounterUser::Dependencies& deps, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        if (deps.optionalCounter)
+            deps.optionalCounter->Add(i);
+        ClobberMemory();
+    }
+    DoNotOptimize(deps.optionalCounter->Get());
+}
+
+
+BENCH_NOINLINE void Bench_Virtual(const InterfaceDependencies& deps, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        deps.virtualCounter->Add(i);
+        ClobberMemory();
+    }
+    DoNotOptimize(deps.virtualCounter->Get());
+}
+
+BENCH_NOINLINE void Bench_Bound(const InterfaceDependencies& deps, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        deps.boundCounter->Add(i);
+        ClobberMemory();
+    }
+    DoNotOptimize(deps.boundCounter->Get());
+}
+
+
+// One access per call, as from a typical member function, so any checks
+// are paid on every call instead of being hoisted out of the loop
+BENCH_NOINLINE void Step_RawPointer(Counter* counter, uint64_t i)
+{
+    counter->Add(i);
+}
+
+BENCH_NOINLINE void Step_Wrapper(DependencyInjected<Counter>& counter, uint64_t i)
+{
+    counter->Add(i);
+}
+
+BENCH_NOINLINE void Step_Required(const CounterUser::Dependencies& deps, uint64_t i)
+{
+    deps.counter->Add(i);
+}
+
+BENCH_NOINLINE void Step_Optional(const CounterUser::Dependencies& deps, uint64_t i)
+{
+    if (deps.optionalCounter)
+        deps.optionalCounter->Add(i);
+}
+
+// Same accesses through the unchecked accessors, so a checked build can
+// compare against itself with the same layout
+BENCH_NOINLINE void Step_WrapperUnchecked(DependencyInjected<Counter>& counter, uint64_t i)
+{
+    counter.GetObjectPtr()->Add(i);
+}
+
+BENCH_NOINLINE void Step_RequiredUnchecked(const CounterUser::Dependencies& deps, uint64_t i)
+{
+    deps.counter.Get()->Add(i);
+}
+
+BENCH_NOINLINE void Step_OptionalUnchecked(const CounterUser::Dependencies& deps, uint64_t i)
+{
+    if (deps.optionalCounter.Get())
+        deps.optionalCounter.Get()->Add(i);
+}
+
+
+//------------------------------------------------------------------------------
+// Lookup benchmarks
+
+typedef DependencyRegistry<CounterUser, CounterImplementation, Counter> CounterRegistry;
+typedef std::unordered_map<std::type_index, void*> TypeMap;
+
+static const uint64_t kLookupIterations = 50000000;
+
+BENCH_NOINLINE void Bench_RegistryLookup(const CounterRegistry& registry, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        registry.Get<Counter>()->Add(i);
+        DoNotOptimize(registry);
+    }
+}
+
+BENCH_NOINLINE void Bench_MapLookup(const TypeMap& map, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        static_cast<Counter*>(map.find(std::type_index(typeid(Counter)))->second)->Add(i);
+        DoNotOptimize(map);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Lifetime benchmarks
+
+static const uint64_t kCycleIterations = 20000000;
+
+BENCH_NOINLINE void Bench_RawLifetime(uint64_t n)
+{
+    alignas(Counter) unsigned char memory[sizeof(Counter)];
+    Counter::Dependencies deps;
+
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        Counter* counter = new (memory) Counter();
+        counter->Initialize(deps);
+        counter->Add(i);
+        DoNotOptimize(counter->Get());
+        counter->Shutdown();
+        counter->~Counter();
+    }
+}
+
+BENCH_NOINLINE void Bench_WrapperLifetime(DependencyInjected<Counter>& counter, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        counter.Initialize();
+        counter->Add(i);
+        DoNotOptimize(counter->Get());
+        counter.Shutdown();
+    }
+}
+
+BENCH_NOINLINE void Bench_FastResetLifetime(DependencyInjected<Counter, FastReset>& counter, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        counter.Initialize();
+        counter->Add(i);
+        DoNotOptimize(counter->Get());
+        counter.Shutdown();
+    }
+}
+
+BENCH_NOINLINE void Bench_HeapLifetime(uint64_t n)
+{
+    Counter::Dependencies deps;
+
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        std::unique_ptr<Counter> counter(new Counter());
+        counter->Initialize(deps);
+        counter->Add(i);
+        DoNotOptimize(counter->Get());
+        counter->Shutdown();
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Entrypoint
+
+int main()
+{
+#if defined(DI_DEBUG)
+    printf("Warning: Benchmarks should be built in Release mode\n\n");
+#endif // DI_DEBUG
+
+#if defined(DI_DEBUG)
+    printf("Checks: debug asserts\n\n");
+#elif defined(DI_HARDENED)
+    printf("Checks: hardened\n\n");
+#else // DI_HARDENED
+    printf("Checks: none\n\n");
+#endif // DI_HARDENED
+
+#if defined(DI_COUNT_ACCESSES)
+    printf("Access counters: on\n\n");
+#endif // DI_COUNT_ACCESSES
+
+    DependencyInjected<Counter> counter;
+    DependencyInjected<CounterUser> user;
+
+    counter.SetDependencies({
+    });
+    user.SetDependencies({
+        counter,
+        counter
+    });
+    counter.Initialize();
+    user.Initialize();
+
+    Counter raw;
+    raw.Initialize({});
+
+    // Warm up clocks and caches before the first measurement
+    Measure(kCallIterations, [&](uint64_t n) { Bench_RawPointer(&raw, n); });
+
+    printf("Call-through:\n");
+
+    const double rawNs = Measure(kCallIterations, [&](uint64_t n) { Bench_RawPointer(&raw, n); });
+    Report("raw pointer", rawNs, rawNs);
+    Report("reference", Measure(kCallIterations, [&](uint64_t n) { Bench_Reference(raw, n); }), rawNs);
+    Report("DependencyInjected<T>::operator->", Measure(kCallIterations, [&](uint64_t n) { Bench_Wrapper(counter, n); }), rawNs);
+    Report("RequiredDependency<T>::operator->", Measure(kCallIterations, [&](uint64_t n) { Bench_Required(user->Deps, n); }), rawNs);
+
+    const double rawCheckNs = Measure(kCallIterations, [&](uint64_t n) { Bench_RawNullCheck(&raw, n); });
+    Report("raw pointer with null check", rawCheckNs, rawCheckNs);
+    Report("OptionalDependency<T> check + operator->", Measure(kCallIterations, [&](uint64_t n) { Bench_Optional(user->Deps, n); }), rawCheckNs);
+
+    DependencyInjected<CounterImplementation> implementation;
+    implementation.SetDependencies({
+    });
+    implementation.Initialize();
+
+    InterfaceDependencies interfaceDeps = {
+        implementation,
+        implementation
+    };
+
+    const double virtualNs = Measure(kCallIterations, [&](uint64_t n) { Bench_Virtual(interfaceDeps, n); });
+    Report("RequiredDependency<I> virtual call", virtualNs, rawNs);
+    Report("RequiredDependency<I> bound to final impl", Measure(kCallIterations, [&](uint64_t n) { Bench_Bound(interfaceDeps, n); }), virtualNs, "virtual");
+
+    printf("\nCall-through, one access per call:\n");
+
+    const double rawStepNs = Measure(kCallIterations, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            Step_RawPointer(&raw, i);
+    });
+    Report("raw pointer", rawStepNs, rawStepNs);
+    Report("DependencyInjected<T>::operator->", Measure(kCallIterations, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            Step_Wrapper(counter, i);
+    }), rawStepNs);
+    Report("RequiredDependency<T>::operator->", Measure(kCallIterations, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            Step_Required(user->Deps, i);
+    }), rawStepNs);
+    Report("OptionalDependency<T> check + operator->", Measure(kCallIterations, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            Step_Optional(user->Deps, i);
+    }), rawStepNs);
+
+    printf("\nCost of the checks, one access per call:\n");
+
+    const double wrapperUncheckedNs = Measure(kCallIterations, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            Step_WrapperUnchecked(counter, i);
+    });
+    Report("DependencyInjected<T>::operator->", Measure(kCallIterations, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            Step_Wrapper(counter, i);
+    }), wrapperUncheckedNs, "unchecked");
+    const double requiredUncheckedNs = Measure(kCallIterations, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            Step_RequiredUnchecked(user->Deps, i);
+    });
+    Report("RequiredDependency<T>::operator->", Measure(kCallIterations, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            Step_Required(user->Deps, i);
+    }), requiredUncheckedNs, "unchecked");
+    const double optionalUncheckedNs = Measure(kCallIterations, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            Step_OptionalUnchecked(user->Deps, i);
+    });
+    Report("OptionalDependency<T> check + operator->", Measure(kCallIterations, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            Step_Optional(user->Deps, i);
+    }), optionalUncheckedNs, "unchecked");
+
+    printf("\nLookup by type:\n");
+
+    CounterRegistry registry;
+    registry.Add(user);
+    registry.Add(implementation);
+    registry.Add(counter);
+
+    TypeMap map;
+    map[std::type_index(typeid(CounterUser))] = user.GetObjectPtr();
+    map[std::type_index(typeid(CounterImplementation))] = implementation.GetObjectPtr();
+    map[std::type_index(typeid(Counter))] = counter.GetObjectPtr();
+
+    const double mapNs = Measure(kLookupIterations, [&](uint64_t n) { Bench_MapLookup(map, n); });
+    Report("unordered_map<type_index>", mapNs, mapNs);
+    Report("DependencyRegistry::Get<T>()", Measure(kLookupIterations, [&](uint64_t n) { Bench_RegistryLookup(registry, n); }), mapNs);
+
+    implementation.Shutdown();
+    user.Shutdown();
+    counter.Shutdown();
+
+    printf("\nInitialize/Shutdown cycle:\n");
+
+    DependencyInjected<Counter, FastReset> fastCounter;
+    fastCounter.SetDependencies({
+    });
+
+    const double rawLifetimeNs = Measure(kCycleIterations, [&](uint64_t n) { Bench_RawLifetime(n); });
+    Report("placement new + delete", rawLifetimeNs, rawLifetimeNs);
+    Report("DependencyInjected<T>", Measure(kCycleIterations, [&](uint64_t n) { Bench_WrapperLifetime(counter, n); }), rawLifetimeNs);
+    Report("DependencyInjected<T, FastReset>", Measure(kCycleIterations, [&](uint64_t n) { Bench_FastResetLifetime(fastCounter, n); }), rawLifetimeNs);
+    Report("std::unique_ptr<T>", Measure(kCycleIterations, [&](uint64_t n) { Bench_HeapLifetime(n); }), rawLifetimeNs);
+
+    printf("\nLayout:\n");
+
+    ReportSize("Counter", sizeof(Counter));
+    ReportSize("DependencyInjected<Counter>", sizeof(DependencyInjected<Counter>));
+    ReportSize("DependencyInjected<Counter, CacheLineAligned>", sizeof(DependencyInjected<Counter, CacheLineAligned>));
+    ReportSize("DependencyInjected<Counter, HeapStorage>", sizeof(DependencyInjected<Counter, HeapStorage>));
+    ReportSize("OptionalDependency<Counter>", sizeof(OptionalDependency<Counter>));
+    ReportSize("RequiredDependency<Counter>", sizeof(RequiredDependency<Counter>));
+    ReportSize("Dependencies with 3 members", sizeof(ThreeDependencies));
+    ReportSize("Dependencies with 6 members", sizeof(SixDependencies));
+
+    return 0;
+}
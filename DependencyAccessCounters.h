@@ -0,0 +1,334 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    DependencyAccessCounters
+
+    Counts calls through each dependency edge, to find the hot ones worth
+    devirtualizing (see DependencyBinding) or colocating.
+
+    Define DI_COUNT_ACCESSES for the whole build.  SetDependencies() then
+    gives each RequiredDependency<> and OptionalDependency<> member an edge
+    id for (consumer type, dependency type), and every operator->() and
+    operator*() through it bumps a counter for that edge.
+
+    The counters are per thread: The owning thread does a plain load and
+    store, with no shared cache lines and no locked instructions.  Tables
+    of threads that exit are folded into a process-wide total.  The edge id
+    is carried in the dependency, so copies made by T::Initialize() keep it.
+
+    Dependencies that were not set through a wrapper, and edges past
+    DI_ACCESS_EDGE_CAPACITY, are counted under one unknown edge.
+
+    Without DI_COUNT_ACCESSES the hooks in DependencyInjected.h compile to
+    nothing and dependencies stay pointer-sized.
+*/
+
+/*
+    Example Usage:
+
+
+    // With DI_COUNT_ACCESSES defined for the whole build:
+    RunWorkload();
+
+    for (const DependencyAccessCount& edge : DependencyAccessCounters::Get().GetCounts())
+    {
+        // edge.ConsumerType -> edge.DependencyType : edge.Count
+    }
+
+    DependencyAccessCounters::Get().WriteReport(stdout);
+*/
+
+#include "DependencyTypeName.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <cstdint>
+#include <cstdio>
+
+// Number of distinct edges counted, including the unknown edge 0
+#if !defined(DI_ACCESS_EDGE_CAPACITY)
+    #define DI_ACCESS_EDGE_CAPACITY 1024
+#endif // DI_ACCESS_EDGE_CAPACITY
+
+
+//------------------------------------------------------------------------------
+// DependencyAccessCount
+
+struct DependencyAccessCount
+{
+    // Both are nullptr for the unknown edge
+    const char* ConsumerType = nullptr;
+    const char* DependencyType = nullptr;
+
+    uint64_t Count = 0;
+};
+
+
+namespace DependencyDetail {
+
+static const unsigned kAccessEdgeCapacity = DI_ACCESS_EDGE_CAPACITY;
+
+struct AccessCounterTable
+{
+    std::atomic<uint64_t> Counts[kAccessEdgeCapacity];
+};
+
+// Trivial so that the fast path needs no thread_local init guard
+inline AccessCounterTable*& GetThreadAccessCounters()
+{
+    static thread_local AccessCounterTable* table = nullptr;
+    return table;
+}
+
+inline AccessCounterTable* AttachAccessCounters();
+
+inline void CountAccess(uint32_t edge)
+{
+    AccessCounterTable* table = GetThreadAccessCounters();
+    if (!table)
+        table = AttachAccessCounters();
+
+    // Only this thread writes the counter, so no read-modify-write is needed
+    std::atomic<uint64_t>& counter = table->Counts[edge];
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+inline uint32_t RegisterAccessEdge(const char* consumerType, const char* dependencyType);
+
+template<class M, class = void>
+struct HasAccessEdge : std::false_type {};
+
+template<class M>
+struct HasAccessEdge<M, std::void_t<decltype(std::declval<M&>().AssignAccessEdge(""))>> : std::true_type {};
+
+// Called by SetDependencies() for each dependency member
+template<class Consumer, class M>
+void AssignAccessEdge(M& member)
+{
+    if constexpr (HasAccessEdge<M>::value)
+        member.AssignAccessEdge(GetTypeName<Consumer>());
+}
+
+} // namespace DependencyDetail
+
+
+//------------------------------------------------------------------------------
+// DependencyAccessCounters
+//
+// Process-wide registry of edges and per-thread counter tables
+
+class DependencyAccessCounters
+{
+public:
+    static DependencyAccessCounters& Get()
+    {
+        static DependencyAccessCounters counters;
+        return counters;
+    }
+
+    // Edges with a non-zero count, hottest first.  Counts from running
+    // threads may be slightly behind
+    std::vector<DependencyAccessCount> GetCounts() const
+    {
+        std::lock_guard<std::mutex> locker(Lock);
+
+        std::vector<DependencyAccessCount> counts;
+        for (unsigned edge = 0; edge < Edges.size(); ++edge)
+        {
+            uint64_t count = Retired[edge];
+            for (const DependencyDetail::AccessCounterTable* table : Tables)
+                count += table->Counts[edge].load(std::memory_order_relaxed);
+
+            if (count == 0)
+                continue;
+
+            DependencyAccessCount entry;
+            entry.ConsumerType = Edges[edge].first;
+            entry.DependencyType = Edges[edge].second;
+            entry.Count = count;
+            counts.push_back(entry);
+        }
+
+        std::stable_sort(counts.begin(), counts.end(),
+            [](const DependencyAccessCount& a, const DependencyAccessCount& b) {
+                return a.Count > b.Count;
+            });
+        return counts;
+    }
+
+    // Zeroes the counts but keeps the edge ids.  Accesses that race with
+    // it may survive the reset
+    void Reset()
+    {
+        std::lock_guard<std::mutex> locker(Lock);
+
+        for (uint64_t& count : Retired)
+            count = 0;
+        for (DependencyDetail::AccessCounterTable* table : Tables)
+            for (auto& counter : table->Counts)
+                counter.store(0, std::memory_order_relaxed);
+    }
+
+    // "Consumer -> Dependency: count" lines, hottest first
+    void WriteReport(FILE* file) const
+    {
+        const std::vector<DependencyAccessCount> counts = GetCounts();
+
+        fprintf(file, "Dependency accesses by edge:\n");
+        for (const DependencyAccessCount& edge : counts)
+        {
+            fprintf(file, "  %s -> %s: %llu\n",
+                edge.ConsumerType ? edge.ConsumerType : "(unknown)",
+                edge.DependencyType ? edge.DependencyType : "(unknown)",
+                static_cast<unsigned long long>(edge.Count));
+        }
+    }
+
+    size_t GetEdgeCount() const
+    {
+        std::lock_guard<std::mutex> locker(Lock);
+        return Edges.size();
+    }
+
+protected:
+    friend DependencyDetail::AccessCounterTable* DependencyDetail::AttachAccessCounters();
+    friend uint32_t DependencyDetail::RegisterAccessEdge(const char*, const char*);
+
+    struct EdgeHash
+    {
+        size_t operator()(const std::pair<const char*, const char*>& edge) const
+        {
+            const size_t a = std::hash<const char*>()(edge.first);
+            return a ^ (std::hash<const char*>()(edge.second) + 0x9e3779b97f4a7c15ull + (a << 6) + (a >> 2));
+        }
+    };
+
+    mutable std::mutex Lock;
+
+    // Index is the edge id.  Edge 0 is the unknown edge
+    std::vector<std::pair<const char*, const char*>> Edges;
+    std::unordered_map<std::pair<const char*, const char*>, uint32_t, EdgeHash> EdgeIds;
+
+    std::vector<DependencyDetail::AccessCounterTable*> Tables;
+
+    // Folded in from the tables of threads that exited
+    uint64_t Retired[DependencyDetail::kAccessEdgeCapacity] = {};
+
+    // Takes accesses made after a thread's table was released
+    DependencyDetail::AccessCounterTable Discarded = {};
+
+    DependencyAccessCounters()
+    {
+        Edges.emplace_back(nullptr, nullptr);
+    }
+
+    uint32_t Register(const char* consumerType, const char* dependencyType)
+    {
+        std::lock_guard<std::mutex> locker(Lock);
+
+        const std::pair<const char*, const char*> edge(consumerType, dependencyType);
+        auto it = EdgeIds.find(edge);
+        if (it != EdgeIds.end())
+            return it->second;
+
+        if (Edges.size() >= DependencyDetail::kAccessEdgeCapacity)
+            return 0;
+
+        const uint32_t id = static_cast<uint32_t>(Edges.size());
+        Edges.push_back(edge);
+        EdgeIds.emplace(edge, id);
+        return id;
+    }
+
+    DependencyDetail::AccessCounterTable* Attach()
+    {
+        DependencyDetail::AccessCounterTable* table = new DependencyDetail::AccessCounterTable();
+
+        std::lock_guard<std::mutex> locker(Lock);
+        Tables.push_back(table);
+        return table;
+    }
+
+    void Release(DependencyDetail::AccessCounterTable* table)
+    {
+        {
+            std::lock_guard<std::mutex> locker(Lock);
+
+            for (unsigned edge = 0; edge < DependencyDetail::kAccessEdgeCapacity; ++edge)
+                Retired[edge] += table->Counts[edge].load(std::memory_order_relaxed);
+
+            Tables.erase(std::find(Tables.begin(), Tables.end(), table));
+        }
+
+        delete table;
+    }
+
+    struct ThreadReleaser
+    {
+        ~ThreadReleaser()
+        {
+            DependencyDetail::AccessCounterTable*& table = DependencyDetail::GetThreadAccessCounters();
+            Get().Release(table);
+            table = &Get().Discarded;
+        }
+    };
+
+    // Deleted methods
+    DependencyAccessCounters(const DependencyAccessCounters&) = delete;
+    DependencyAccessCounters& operator=(const DependencyAccessCounters&) = delete;
+};
+
+
+namespace DependencyDetail {
+
+inline AccessCounterTable* AttachAccessCounters()
+{
+    static thread_local DependencyAccessCounters::ThreadReleaser releaser;
+    (void)releaser;
+
+    AccessCounterTable*& table = GetThreadAccessCounters();
+    table = DependencyAccessCounters::Get().Attach();
+    return table;
+}
+
+inline uint32_t RegisterAccessEdge(const char* consumerType, const char* dependencyType)
+{
+    return DependencyAccessCounters::Get().Register(consumerType, dependencyType);
+}
+
+} // namespace DependencyDetail
@@ -0,0 +1,108 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    DependencyArenaStorage
+
+    ArenaStorage policy: Object memory is allocated from a
+    std::pmr::memory_resource passed to the wrapper constructor.  With a
+    std::pmr::monotonic_buffer_resource the objects of a whole subsystem
+    are packed together and freed by a single release() after they are all
+    shut down and destroyed.
+
+    Kept apart from DependencyInjected.h so that only its users include
+    <memory_resource>.
+*/
+
+/*
+    Example Usage:
+
+
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+    DependencyInjected<Cog, ArenaStorage> cog(arena);
+    DependencyInjected<Widget, ArenaStorage> widget(arena);
+
+    ...
+
+    // After all of them are shut down and destroyed:
+    arena.release();
+*/
+
+#include "DependencyInjected.h"
+
+#include <memory_resource>
+
+
+//------------------------------------------------------------------------------
+// ArenaStorage
+
+struct ArenaStorage
+{
+};
+
+namespace DependencyDetail {
+
+template<class LayoutT>
+class ArenaObjectStorage
+{
+public:
+    explicit ArenaObjectStorage(std::pmr::memory_resource& resource)
+        : Resource(resource)
+    {
+        Memory = static_cast<unsigned char*>(
+            Resource.allocate(LayoutT::Bytes, LayoutT::Alignment));
+    }
+    ~ArenaObjectStorage()
+    {
+        // No-op for a monotonic_buffer_resource
+        Resource.deallocate(Memory, LayoutT::Bytes, LayoutT::Alignment);
+    }
+
+    DI_FORCE_INLINE unsigned char* Get()
+    {
+        return Memory;
+    }
+
+protected:
+    std::pmr::memory_resource& Resource;
+    unsigned char* Memory;
+
+    ArenaObjectStorage(const ArenaObjectStorage&) = delete;
+    ArenaObjectStorage& operator=(const ArenaObjectStorage&) = delete;
+};
+
+template<class LayoutT>
+struct PolicyStorage<ArenaStorage, LayoutT>
+{
+    typedef ArenaObjectStorage<LayoutT> Type;
+};
+
+} // namespace DependencyDetail
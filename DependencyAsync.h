@@ -0,0 +1,345 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    DependencyAsync
+
+    Asynchronous Initialize() and Shutdown() with C++20 coroutines.
+
+    T::Initialize() may be a coroutine returning DependencyTask<bool>, so
+    I/O-bound objects (connecting to a database, loading files) do not
+    block a thread while they wait.  DependencyInjected<T>::Initialize()
+    returns the task, which runs when it is awaited.  T::Shutdown() may
+    likewise return DependencyTask<void>; ShutdownAsync() awaits it before
+    the object is destroyed.
+
+    DependencyContainer::InitializeAll() starts each object as soon as the
+    objects it depends on are ready, so the I/O of all independent objects
+    overlaps, and it stops starting objects after the first failure.
+
+    Only available when the compiler supports coroutines (DI_COROUTINES).
+*/
+
+/*
+    Example Usage:
+
+
+    class Database
+    {
+    public:
+        struct Dependencies
+        {
+        };
+
+        DependencyTask<bool> Initialize(const Dependencies& deps, const char* address)
+        {
+            co_return co_await Connection.Connect(address);
+        }
+        void Shutdown()
+        {
+        }
+    };
+
+    DependencyContainer container;
+    container.Add(database, "db.local");
+    container.Add(cache); // Synchronous objects can be mixed in
+
+    if (!container.InitializeAll())
+    {
+        // Handle failure
+    }
+*/
+
+#include "DependencyInjected.h"
+
+#if defined(__has_include)
+    #if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+        #define DI_COROUTINES
+    #endif
+#endif // __has_include
+
+#if defined(DI_COROUTINES)
+
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+
+
+//------------------------------------------------------------------------------
+// DependencyTask
+//
+// Lazily started coroutine task.  Awaiting it starts it and resumes the
+// awaiting coroutine when it finishes
+
+template<class R>
+class DependencyTask;
+
+namespace DependencyDetail {
+
+template<class R>
+struct TaskPromiseBase
+{
+    std::coroutine_handle<> Continuation;
+
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept
+        {
+            return false;
+        }
+        template<class P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept
+        {
+            std::coroutine_handle<> continuation = handle.promise().Continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept
+        {
+        }
+    };
+
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+    FinalAwaiter final_suspend() noexcept
+    {
+        return {};
+    }
+};
+
+template<class R>
+struct TaskPromise : TaskPromiseBase<R>
+{
+    R Result{};
+
+    DependencyTask<R> get_return_object();
+
+    void return_value(R result)
+    {
+        Result = std::move(result);
+    }
+    void unhandled_exception()
+    {
+        // Exceptions are not used for errors in this library
+        std::terminate();
+    }
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase<void>
+{
+    DependencyTask<void> get_return_object();
+
+    void return_void()
+    {
+    }
+    void unhandled_exception()
+    {
+        std::terminate();
+    }
+};
+
+} // namespace DependencyDetail
+
+template<class R = bool>
+class DependencyTask
+{
+public:
+    typedef DependencyDetail::TaskPromise<R> promise_type;
+    typedef std::coroutine_handle<promise_type> HandleT;
+
+    explicit DependencyTask(HandleT handle)
+        : Handle(handle)
+    {
+    }
+    DependencyTask(DependencyTask&& other) noexcept
+        : Handle(other.Handle)
+    {
+        other.Handle = nullptr;
+    }
+    DependencyTask& operator=(DependencyTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (Handle)
+                Handle.destroy();
+            Handle = other.Handle;
+            other.Handle = nullptr;
+        }
+        return *this;
+    }
+    ~DependencyTask()
+    {
+        if (Handle)
+            Handle.destroy();
+    }
+
+    bool await_ready() const noexcept
+    {
+        return !Handle || Handle.done();
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        Handle.promise().Continuation = awaiting;
+        return Handle;
+    }
+    R await_resume()
+    {
+        if constexpr (!std::is_void<R>::value)
+            return std::move(Handle.promise().Result);
+    }
+
+protected:
+    HandleT Handle;
+
+    // Deleted methods
+    DependencyTask(const DependencyTask&) = delete;
+    DependencyTask& operator=(const DependencyTask&) = delete;
+};
+
+namespace DependencyDetail {
+
+template<class R>
+DependencyTask<R> TaskPromise<R>::get_return_object()
+{
+    return DependencyTask<R>(std::coroutine_handle<TaskPromise<R>>::from_promise(*this));
+}
+
+inline DependencyTask<void> TaskPromise<void>::get_return_object()
+{
+    return DependencyTask<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+template<class R>
+struct IsDependencyTask : std::false_type {};
+
+template<class R>
+struct IsDependencyTask<DependencyTask<R>> : std::true_type {};
+
+// Coroutine that starts immediately and frees itself when done
+struct DetachedCoroutine
+{
+    struct promise_type
+    {
+        DetachedCoroutine get_return_object()
+        {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void()
+        {
+        }
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+// Starts the task and calls done(result) on the thread that finishes it
+template<class R, class F>
+DetachedCoroutine AwaitThen(DependencyTask<R> task, F done)
+{
+    if constexpr (std::is_void<R>::value)
+    {
+        co_await task;
+        done();
+    }
+    else
+        done(co_await task);
+}
+
+} // namespace DependencyDetail
+
+
+//------------------------------------------------------------------------------
+// Helpers
+
+// Blocks the calling thread until the task is done
+template<class R>
+R SyncWait(DependencyTask<R> task)
+{
+    std::mutex lock;
+    std::condition_variable condition;
+    bool done = false;
+
+    if constexpr (std::is_void<R>::value)
+    {
+        DependencyDetail::AwaitThen(std::move(task), [&]() {
+            std::lock_guard<std::mutex> locker(lock);
+            done = true;
+            condition.notify_all();
+        });
+
+        std::unique_lock<std::mutex> locker(lock);
+        condition.wait(locker, [&] { return done; });
+    }
+    else
+    {
+        R result{};
+        DependencyDetail::AwaitThen(std::move(task), [&](R r) {
+            std::lock_guard<std::mutex> locker(lock);
+            result = std::move(r);
+            done = true;
+            condition.notify_all();
+        });
+
+        std::unique_lock<std::mutex> locker(lock);
+        condition.wait(locker, [&] { return done; });
+        return result;
+    }
+}
+
+// Awaits T::Shutdown() if it is a coroutine, then destroys the object
+template<class T, class... Policies>
+DependencyTask<void> ShutdownAsync(DependencyInjected<T, Policies...>& wrapper)
+{
+    if (!wrapper.IsInitialized())
+        co_return;
+
+    if constexpr (DependencyDetail::IsDependencyTask<decltype(wrapper->Shutdown())>::value)
+        co_await wrapper->Shutdown();
+    else
+        wrapper->Shutdown();
+
+    wrapper.ShutdownWith([](T&) {});
+}
+
+#endif // DI_COROUTINES
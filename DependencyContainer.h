@@ -0,0 +1,1534 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    DependencyContainer
+
+    Initializes a set of DependencyInjected<> objects in dependency order.
+
+    The edges of the graph are read from each object's Dependencies struct:
+    A RequiredDependency<> or OptionalDependency<> that refers to another
+    registered wrapper means that wrapper must be initialized first.
+    Objects are grouped into topological levels, and all objects in the
+    same level are initialized concurrently on a thread pool.  Shutdown
+    runs in reverse, each object as soon as the objects that depend on it
+    are shut down.
+
+    Startup time scales with the depth of the graph instead of the number
+    of objects in it.
+
+    Cycles (like peer objects Cog and Widget) must be broken by marking
+    one of the edges LateBound<>, otherwise InitializeAll() fails.
+
+    Objects with a Drain() method have it called right before Shutdown(),
+    so they can stop accepting work and flush it into their dependencies
+    while those are still up.  ShutdownAll() times Drain() plus Shutdown()
+    for each object and reports the ones that took longer than their
+    shutdown deadline.
+
+    With C++20 coroutines (see DependencyAsync.h), objects whose
+    Initialize() returns a DependencyTask<bool> are awaited instead of
+    occupying a thread.  InitializeAll() then starts every object as soon as
+    the objects it depends on are ready instead of level by level, and stops
+    starting objects after the first one fails.
+
+    Reinitialize() restarts one object and the objects that transitively
+    depend on it, leaving the rest of the graph up.
+
+    InitializeAllOrRollback() is all or nothing: An object whose
+    Initialize() fails is shut down and retried on its own with the backoff
+    from SetRetryPolicy(), while the objects that are already up stay up
+    and its dependents wait.  If it runs out of attempts, the objects that
+    were brought up are shut down in reverse level order.  Reinitialize()
+    retries failed objects the same way.
+
+    SetNumaNode() places an object on a NUMA node (see DependencyNuma.h):
+    Its Initialize() runs on a thread bound to that node, so the memory it
+    first touches lands there.  Objects placed on the same node in the same
+    level share one thread.  The async graph path ignores placement.
+
+    InitializeAll() times each Initialize().  GetStartupReport() returns the
+    graph with those times and its critical path: The chain of Initialize()
+    calls that bounds startup time no matter how many threads run it.  The
+    report can be written as Graphviz DOT or JSON.
+
+    AutoWireAll() sets the Dependencies of every object that does not have
+    them yet, matching each RequiredDependency<X> or OptionalDependency<X>
+    member against the types of the added objects, plus any interfaces
+    given to Provide<I>().  The match is by exact type at runtime.  For a
+    fixed set of types, DependencyGraph::AutoWireAll() does the same at
+    compile time.
+*/
+
+/*
+    Example Usage:
+
+
+    DependencyInjected<MyImplementation> branch;
+    DependencyInjected<InterfaceUser> user;
+
+    branch.SetDependencies({
+    });
+    user.SetDependencies({
+        branch
+    });
+
+    DependencyContainer container;
+    container.Add(user);
+    container.Add(branch, 10); // Arguments for Initialize()
+
+    if (!container.InitializeAll())
+    {
+        // Handle failure
+    }
+
+    user->DoThing();
+
+    DependencyStartupReport startup = container.GetStartupReport();
+    startup.WriteDot("startup.dot"); // dot -Tsvg startup.dot -o startup.svg
+    // startup.CriticalPath: Slowest chain of objects, first to last
+
+    container.SetShutdownDeadline(branch, std::chrono::milliseconds(50));
+
+    DependencyShutdownReport report = container.ShutdownAll();
+    for (const auto& overrun : report.Overruns)
+    {
+        // Log overrun.TypeName and overrun.Elapsed
+    }
+
+
+    Auto-wiring:
+
+
+    DependencyContainer container;
+    container.Add(user);
+    container.Add(branch, 10);
+    container.Provide<IMyInterface>(branch);
+
+    if (!container.AutoWireAll() || !container.InitializeAll())
+    {
+        // Handle failure
+    }
+
+
+    Retrying transient failures:
+
+
+    DependencyRetryPolicy retry;
+    retry.MaxAttempts = 5;
+    container.SetRetryPolicy(retry);
+
+    if (!container.InitializeAllOrRollback())
+    {
+        // Every object is down again
+    }
+*/
+
+#include "DependencyInjected.h"
+#include "DependencyTypeName.h"
+#include "DependencyAsync.h"
+#include "DependencyNuma.h"
+
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <tuple>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <ostream>
+#include <fstream>
+#include <cstdint>
+
+
+//------------------------------------------------------------------------------
+// DependencyThreadPool
+//
+// Minimal fork-join pool: The calling thread participates in each batch and
+// ParallelFor() returns when the whole batch is done.
+
+class DependencyThreadPool
+{
+public:
+    // threadCount includes the calling thread.  0 = hardware concurrency
+    explicit DependencyThreadPool(unsigned threadCount = 0)
+    {
+        if (threadCount == 0)
+            threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0)
+            threadCount = 1;
+        ThreadCount = threadCount;
+    }
+
+    ~DependencyThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> locker(Lock);
+            Stopping = true;
+        }
+        WorkCondition.notify_all();
+
+        for (auto& worker : Workers)
+            worker.join();
+    }
+
+    unsigned GetThreadCount() const
+    {
+        return ThreadCount;
+    }
+
+    // Invoke fn(i) for i in [0, count)
+    template<class F>
+    void ParallelFor(size_t count, F&& fn)
+    {
+        if (count <= 1 || ThreadCount <= 1)
+        {
+            for (size_t i = 0; i < count; ++i)
+                fn(i);
+            return;
+        }
+
+        const std::function<void(size_t)> job(std::ref(fn));
+
+        {
+            std::unique_lock<std::mutex> locker(Lock);
+
+            StartWorkers();
+
+            // Wait for stragglers from the previous batch
+            DoneCondition.wait(locker, [this] { return BusyWorkers == 0; });
+
+            Job = &job;
+            JobCount = count;
+            NextIndex = 0;
+            PendingCount = count;
+            ++Generation;
+        }
+        WorkCondition.notify_all();
+
+        RunJob(&job, count);
+
+        std::unique_lock<std::mutex> locker(Lock);
+        DoneCondition.wait(locker, [this] {
+            return PendingCount == 0 && BusyWorkers == 0;
+        });
+        Job = nullptr;
+    }
+
+protected:
+    unsigned ThreadCount = 1;
+    std::vector<std::thread> Workers;
+
+    std::mutex Lock;
+    std::condition_variable WorkCondition;
+    std::condition_variable DoneCondition;
+    bool Stopping = false;
+    uint64_t Generation = 0;
+    unsigned BusyWorkers = 0;
+
+    const std::function<void(size_t)>* Job = nullptr;
+    size_t JobCount = 0;
+    std::atomic<size_t> NextIndex{ 0 };
+    std::atomic<size_t> PendingCount{ 0 };
+
+    // Lock must be held
+    void StartWorkers()
+    {
+        if (!Workers.empty())
+            return;
+
+        for (unsigned i = 1; i < ThreadCount; ++i)
+            Workers.emplace_back([this] { WorkerLoop(); });
+    }
+
+    void WorkerLoop()
+    {
+        uint64_t seen = 0;
+
+        std::unique_lock<std::mutex> locker(Lock);
+        for (;;)
+        {
+            WorkCondition.wait(locker, [&] { return Stopping || Generation != seen; });
+            if (Stopping)
+                return;
+
+            seen = Generation;
+            const std::function<void(size_t)>* job = Job;
+            const size_t count = JobCount;
+            ++BusyWorkers;
+
+            locker.unlock();
+            if (job)
+                RunJob(job, count);
+            locker.lock();
+
+            if (--BusyWorkers == 0)
+                DoneCondition.notify_all();
+        }
+    }
+
+    void RunJob(const std::function<void(size_t)>* job, size_t count)
+    {
+        for (;;)
+        {
+            const size_t i = NextIndex.fetch_add(1);
+            if (i >= count)
+                break;
+
+            (*job)(i);
+
+            if (PendingCount.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> locker(Lock);
+                DoneCondition.notify_all();
+            }
+        }
+    }
+
+    // Deleted methods
+    DependencyThreadPool(const DependencyThreadPool&) = delete;
+    DependencyThreadPool& operator=(const DependencyThreadPool&) = delete;
+};
+
+
+//------------------------------------------------------------------------------
+// DependencyShutdownReport
+
+struct DependencyShutdownOverrun
+{
+    IDependencyInjected* Wrapper = nullptr;
+    const char* TypeName = nullptr;
+
+    // Time spent in Drain() and Shutdown()
+    std::chrono::nanoseconds Elapsed{ 0 };
+    std::chrono::nanoseconds Deadline{ 0 };
+};
+
+struct DependencyShutdownReport
+{
+    // Wall time of ShutdownAll()
+    std::chrono::nanoseconds Elapsed{ 0 };
+
+    // Objects that missed their deadline, in shutdown order
+    std::vector<DependencyShutdownOverrun> Overruns;
+
+    bool MetDeadlines() const
+    {
+        return Overruns.empty();
+    }
+};
+
+
+//------------------------------------------------------------------------------
+// DependencyRetryPolicy
+//
+// How InitializeAllOrRollback() and Reinitialize() retry an object whose
+// Initialize() failed, e.g. because a backend was briefly unreachable
+
+struct DependencyRetryPolicy
+{
+    // Initialize() calls per object, including the first.  1 = no retries
+    unsigned MaxAttempts = 1;
+
+    // Wait before the first retry, doubled after each failed retry
+    std::chrono::nanoseconds InitialBackoff = std::chrono::milliseconds(10);
+    std::chrono::nanoseconds MaxBackoff = std::chrono::seconds(1);
+};
+
+
+//------------------------------------------------------------------------------
+// DependencyStartupReport
+
+struct DependencyStartupNode
+{
+    IDependencyInjected* Wrapper = nullptr;
+    const char* TypeName = nullptr;
+
+    // Topological level, 0 = no dependencies
+    size_t Level = 0;
+
+    // Indices of the nodes this one depends on
+    std::vector<size_t> DependsOn;
+
+    // Start of Initialize() relative to the start of InitializeAll(), and
+    // time until it completed.  Objects that were restarted by
+    // Reinitialize() report their latest Initialize()
+    std::chrono::nanoseconds Start{ 0 };
+    std::chrono::nanoseconds Elapsed{ 0 };
+
+    // Earliest completion if each object started as soon as its
+    // dependencies were up
+    std::chrono::nanoseconds EarliestFinish{ 0 };
+
+    // Initialize() calls, more than one after retries.  Failed is set if
+    // the latest one failed
+    unsigned Attempts = 0;
+    bool Failed = false;
+
+    bool OnCriticalPath = false;
+};
+
+struct DependencyStartupReport
+{
+    // Wall time of InitializeAll()
+    std::chrono::nanoseconds Elapsed{ 0 };
+
+    // In the order they were added to the container
+    std::vector<DependencyStartupNode> Nodes;
+
+    // Node indices of the slowest dependency chain, first to last.
+    // Its total is a lower bound on startup time with unlimited threads
+    std::vector<size_t> CriticalPath;
+    std::chrono::nanoseconds CriticalPathElapsed{ 0 };
+
+    // Graphviz: Edges point from each object to its dependencies, and the
+    // critical path is drawn in red
+    void WriteDot(std::ostream& out) const
+    {
+        out << "digraph DependencyGraph {\n"
+            << "    rankdir=LR;\n"
+            << "    node [shape=box, fontname=\"Helvetica\"];\n";
+
+        for (size_t i = 0; i < Nodes.size(); ++i)
+        {
+            const DependencyStartupNode& node = Nodes[i];
+
+            out << "    n" << i << " [label=\"";
+            WriteDotEscaped(out, node.TypeName);
+            out << "\\n";
+            WriteMilliseconds(out, node.Elapsed);
+            out << " ms\"";
+            if (node.OnCriticalPath)
+                out << ", color=red, penwidth=2";
+            out << "];\n";
+        }
+
+        for (size_t i = 0; i < Nodes.size(); ++i)
+        {
+            for (size_t j : Nodes[i].DependsOn)
+            {
+                out << "    n" << i << " -> n" << j;
+                if (IsCriticalEdge(i, j))
+                    out << " [color=red, penwidth=2]";
+                out << ";\n";
+            }
+        }
+
+        out << "}\n";
+    }
+    bool WriteDot(const char* path) const
+    {
+        std::ofstream file(path);
+        if (!file)
+            return false;
+        WriteDot(file);
+        return static_cast<bool>(file);
+    }
+
+    void WriteJson(std::ostream& out) const
+    {
+        out << "{\"elapsedNsec\":" << Elapsed.count()
+            << ",\"criticalPathNsec\":" << CriticalPathElapsed.count()
+            << ",\"criticalPath\":[";
+        for (size_t i = 0; i < CriticalPath.size(); ++i)
+            out << (i ? "," : "") << CriticalPath[i];
+        out << "],\"nodes\":[";
+
+        for (size_t i = 0; i < Nodes.size(); ++i)
+        {
+            const DependencyStartupNode& node = Nodes[i];
+
+            out << (i ? ",\n" : "\n") << "{\"id\":" << i << ",\"type\":";
+            DependencyDetail::WriteJsonString(out, node.TypeName);
+            out << ",\"level\":" << node.Level
+                << ",\"startNsec\":" << node.Start.count()
+                << ",\"elapsedNsec\":" << node.Elapsed.count()
+                << ",\"earliestFinishNsec\":" << node.EarliestFinish.count()
+                << ",\"attempts\":" << node.Attempts
+                << ",\"failed\":" << (node.Failed ? "true" : "false")
+                << ",\"critical\":" << (node.OnCriticalPath ? "true" : "false")
+                << ",\"dependsOn\":[";
+            for (size_t k = 0; k < node.DependsOn.size(); ++k)
+                out << (k ? "," : "") << node.DependsOn[k];
+            out << "]}";
+        }
+        out << "\n]}\n";
+    }
+    bool WriteJson(const char* path) const
+    {
+        std::ofstream file(path);
+        if (!file)
+            return false;
+        WriteJson(file);
+        return static_cast<bool>(file);
+    }
+
+protected:
+    bool IsCriticalEdge(size_t from, size_t to) const
+    {
+        for (size_t k = 1; k < CriticalPath.size(); ++k)
+            if (CriticalPath[k] == from && CriticalPath[k - 1] == to)
+                return true;
+        return false;
+    }
+
+    static void WriteDotEscaped(std::ostream& out, const char* s)
+    {
+        for (; s && *s; ++s)
+        {
+            if (*s == '"' || *s == '\\')
+                out << '\\';
+            out << *s;
+        }
+    }
+
+    static void WriteMilliseconds(std::ostream& out, std::chrono::nanoseconds t)
+    {
+        const long long usec = static_cast<long long>(t.count() / 1000);
+        const long long frac = usec % 1000;
+        out << usec / 1000 << "." << (frac < 100 ? (frac < 10 ? "00" : "0") : "") << frac;
+    }
+};
+
+
+namespace DependencyDetail {
+
+template<class T, class = void>
+struct HasDrain : std::false_type {};
+
+template<class T>
+struct HasDrain<T, std::void_t<decltype(std::declval<T&>().Drain())>> : std::true_type {};
+
+// Address that identifies a type without RTTI
+template<class T>
+struct TypeKey
+{
+    static const char Id;
+};
+
+template<class T>
+const char TypeKey<T>::Id = 0;
+
+struct WireProvider
+{
+    // Already converted to the provided type
+    void* Object;
+    IDependencyInjected* Wrapper;
+
+    // More than one object provides the type
+    bool Ambiguous;
+};
+
+typedef std::unordered_map<const void*, WireProvider> WireProviderMap;
+
+// Member M set from the provider of its type.  Clears complete if a
+// required member has no provider or cannot be wired from one, or if any
+// member has more than one
+template<class M>
+M WireMember(const WireProviderMap& providers, bool& complete)
+{
+    if constexpr (IsWirable<M>::value)
+    {
+        typedef DependencyMemberTraits<M> Traits;
+        typedef typename Traits::Type X;
+
+        auto it = providers.find(&TypeKey<X>::Id);
+        if (it != providers.end())
+        {
+            // Catch a member that matches two providers in debug mode
+            DI_DEBUG_ASSERT(!it->second.Ambiguous);
+
+            if (it->second.Ambiguous)
+            {
+                complete = false;
+                return M();
+            }
+            return M(static_cast<X*>(it->second.Object), it->second.Wrapper);
+        }
+
+        if (Traits::IsRequired)
+            complete = false;
+    }
+    else if constexpr (DependencyMemberTraits<M>::IsRequired)
+    {
+        // E.g. ThreadLocalDependency: Left for the caller to set
+        complete = false;
+    }
+
+    return M();
+}
+
+} // namespace DependencyDetail
+
+
+//------------------------------------------------------------------------------
+// DependencyContainer
+
+class DependencyContainer
+{
+public:
+    // threadCount includes the calling thread.  0 = hardware concurrency
+    explicit DependencyContainer(unsigned threadCount = 0)
+        : Pool(threadCount)
+    {
+    }
+
+    ~DependencyContainer()
+    {
+        // Catch never calling ShutdownAll() before container goes out of scope
+        DI_DEBUG_ASSERT(!Initialized);
+    }
+
+    // Register a wrapper and the arguments to pass to its Initialize()
+    template<class T, class... Policies, class... Args>
+    void Add(DependencyInjected<T, Policies...>& wrapper, Args&&... args)
+    {
+        // Catch adding objects while the graph is live in debug mode
+        DI_DEBUG_ASSERT(!Initialized);
+
+        Node node;
+        node.Wrapper = &wrapper;
+        node.Storage = reinterpret_cast<const char*>(wrapper.GetObjectPtr());
+        node.StorageBytes = sizeof(T);
+        node.TypeName = DependencyDetail::GetTypeName<T>();
+
+        BindInitialize(node, wrapper, std::forward<Args>(args)...);
+#if defined(DI_COROUTINES)
+        if (node.InitializeAsync)
+            ++AsyncNodeCount;
+#endif // DI_COROUTINES
+
+        node.Shutdown = [&wrapper]() {
+            if constexpr (DependencyDetail::HasDrain<T>::value)
+            {
+                if (wrapper.IsInitialized())
+                    wrapper->Drain();
+            }
+#if defined(DI_COROUTINES)
+            if constexpr (DependencyDetail::IsDependencyTask<decltype(std::declval<T&>().Shutdown())>::value)
+                SyncWait(ShutdownAsync(wrapper));
+            else
+#endif // DI_COROUTINES
+            wrapper.Shutdown();
+        };
+        node.AutoWire = [&wrapper](const DependencyDetail::WireProviderMap& providers) -> bool {
+            typedef typename DependencyInjected<T, Policies...>::DepsT DepsT;
+
+            // Handwritten dependencies take precedence
+            if (wrapper.HasDependencies())
+                return true;
+
+            bool complete = true;
+            DepsT deps = DependencyDetail::BuildDependencies<DepsT>([&](auto tag) {
+                return DependencyDetail::WireMember<typename decltype(tag)::Type>(providers, complete);
+            });
+
+            if (complete)
+                wrapper.SetDependencies(std::move(deps));
+            return complete;
+        };
+        Providers.push_back({ &DependencyDetail::TypeKey<T>::Id, { wrapper.GetObjectPtr(), &wrapper, false } });
+
+        node.GetEdges = [&wrapper](std::vector<const void*>& edges) {
+            // Catch forgetting SetDependencies() in debug mode
+            DI_DEBUG_ASSERT(wrapper.HasDependencies());
+
+            DependencyDetail::ForEachDependency(wrapper.GetDependencies(), [&edges](const auto& dep) {
+                typedef typename std::decay<decltype(dep)>::type DepT;
+                if (!DependencyMemberTraits<DepT>::IsLateBound && dep.Get())
+                    edges.push_back(dep.Get());
+            });
+        };
+
+        Nodes.push_back(std::move(node));
+    }
+
+    // Makes the wrapper the provider of interface I for AutoWireAll()
+    template<class I, class S, class... Policies>
+    void Provide(DependencyInjected<S, Policies...>& wrapper)
+    {
+        static_assert(std::is_base_of<I, S>::value && !std::is_same<I, S>::value,
+            "Provide<I>() is for interfaces of S: Add() already provides S itself");
+
+        I* object = wrapper.GetObjectPtr();
+        Providers.push_back({ &DependencyDetail::TypeKey<I>::Id, { object, &wrapper, false } });
+    }
+
+    // Sets the Dependencies of each added object that has none yet from the
+    // added objects and Provide<I>() interfaces.  Returns false if a
+    // required dependency has no provider or cannot be wired from one, like
+    // ThreadLocalDependency, or a dependency matches more than one, leaving
+    // that object unwired.  Several objects of one type are fine as long as
+    // nothing is wired to that type
+    bool AutoWireAll()
+    {
+        // Catch wiring while the graph is live in debug mode
+        DI_DEBUG_ASSERT(!Initialized);
+
+        DependencyDetail::WireProviderMap providers;
+        for (const auto& provider : Providers)
+        {
+            auto result = providers.insert(provider);
+            if (!result.second)
+                result.first->second.Ambiguous = true;
+        }
+
+        bool complete = true;
+        for (Node& node : Nodes)
+            if (!node.AutoWire(providers))
+                complete = false;
+        return complete;
+    }
+
+    // Initialize all objects, one topological level at a time.
+    // Returns false if there is a dependency cycle or an Initialize() fails
+    bool InitializeAll()
+    {
+        // Catch double-initialization in debug mode
+        DI_DEBUG_ASSERT(!Initialized);
+
+        if (!BuildLevels())
+        {
+            // Catch unbroken dependency cycles in debug mode
+            DI_DEBUG_ASSERT(false);
+            return false;
+        }
+
+        Initialized = true;
+        ResetAttempts(std::vector<bool>(Nodes.size(), true));
+
+        StartupBegin = Clock::now();
+        const bool success = InitializeLevels();
+        StartupElapsed = Clock::now() - StartupBegin;
+
+        return success;
+    }
+
+    // Like InitializeAll(), but leaves nothing half up.  An object whose
+    // Initialize() fails is shut down and retried on its own, as set by
+    // SetRetryPolicy(), while the objects already up stay up.  Its
+    // dependents are in later levels, so they have not started yet.  Once
+    // an object runs out of attempts, the objects that were brought up are
+    // shut down in reverse level order and the container can be
+    // initialized again.  Coroutines are awaited level by level too.
+    // Returns false if there is a dependency cycle or an object failed
+    bool InitializeAllOrRollback()
+    {
+        // Catch double-initialization in debug mode
+        DI_DEBUG_ASSERT(!Initialized);
+
+        if (!BuildLevels())
+        {
+            // Catch unbroken dependency cycles in debug mode
+            DI_DEBUG_ASSERT(false);
+            return false;
+        }
+
+        Initialized = true;
+        ResetAttempts(std::vector<bool>(Nodes.size(), true));
+
+        StartupBegin = Clock::now();
+
+        size_t levelsStarted = 0;
+        bool success = true;
+        for (const auto& level : Levels)
+        {
+            ++levelsStarted;
+            if (!InitializeBatchWithRetry(level))
+            {
+                success = false;
+                break;
+            }
+        }
+
+        StartupElapsed = Clock::now() - StartupBegin;
+
+        if (!success)
+        {
+            ShutdownStartedLevels(levelsStarted);
+            Initialized = false;
+        }
+
+        return success;
+    }
+
+    // Restarts one object while the rest of the graph stays up, e.g. after
+    // its configuration changed.  The objects that transitively depend on
+    // it are shut down in reverse level order, then the object itself.
+    // The object is initialized again, with new arguments if any are given
+    // (they replace the ones from Add()), and then its dependents are
+    // brought back up level by level.  LateBound<> users are not restarted.
+    // Must not race with users of the restarted objects.  Failed objects
+    // are retried as set by SetRetryPolicy().
+    // Returns false if an object runs out of attempts: It is shut down, and
+    // the objects after it stay down
+    template<class T, class... Policies, class... Args>
+    bool Reinitialize(DependencyInjected<T, Policies...>& wrapper, Args&&... args)
+    {
+        // Catch restarting before InitializeAll() in debug mode
+        DI_DEBUG_ASSERT(Initialized);
+
+        const size_t target = FindWrapper(&wrapper);
+        if (target == SIZE_MAX)
+        {
+            // Catch restarting an object that was never added
+            DI_DEBUG_ASSERT(false);
+            return false;
+        }
+
+        const std::vector<bool> affected = MarkDependents(target);
+        ResetAttempts(affected);
+
+        // Users first, one level at a time
+        for (size_t i = Levels.size(); i > 0; --i)
+        {
+            const std::vector<size_t> batch = SelectMarked(Levels[i - 1], affected);
+
+            Pool.ParallelFor(batch.size(), [&](size_t j) {
+                Nodes[batch[j]].Shutdown();
+            });
+        }
+
+        if constexpr (sizeof...(Args) > 0)
+        {
+            Node& node = Nodes[target];
+#if defined(DI_COROUTINES)
+            const bool wasAsync = static_cast<bool>(node.InitializeAsync);
+#endif // DI_COROUTINES
+            BindInitialize(node, wrapper, std::forward<Args>(args)...);
+#if defined(DI_COROUTINES)
+            AsyncNodeCount += static_cast<bool>(node.InitializeAsync);
+            AsyncNodeCount -= wasAsync;
+#endif // DI_COROUTINES
+        }
+
+        for (const auto& level : Levels)
+        {
+            // Do not start dependents of an object that failed
+            if (!InitializeBatchWithRetry(SelectMarked(level, affected)))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Graph with the times measured by InitializeAll() and its critical path
+    DependencyStartupReport GetStartupReport() const
+    {
+        DependencyStartupReport report;
+        report.Elapsed = StartupElapsed;
+        report.Nodes.resize(Nodes.size());
+
+        for (size_t level = 0; level < Levels.size(); ++level)
+            for (size_t i : Levels[level])
+                report.Nodes[i].Level = level;
+
+        // Longest path by Initialize() time.  Dependencies are all in earlier
+        // levels, so one pass in level order sees them finished first
+        std::vector<size_t> slowest(Nodes.size(), SIZE_MAX);
+        size_t last = SIZE_MAX;
+
+        for (const auto& level : Levels)
+        {
+            for (size_t i : level)
+            {
+                const Node& node = Nodes[i];
+                DependencyStartupNode& entry = report.Nodes[i];
+
+                entry.Wrapper = node.Wrapper;
+                entry.TypeName = node.TypeName;
+                entry.DependsOn = node.DependsOn;
+                entry.Start = node.InitializeStart;
+                entry.Elapsed = node.InitializeElapsed;
+                entry.Attempts = node.Attempts;
+                entry.Failed = node.Failed;
+
+                std::chrono::nanoseconds ready{ 0 };
+                for (size_t j : node.DependsOn)
+                {
+                    if (report.Nodes[j].EarliestFinish >= ready)
+                    {
+                        ready = report.Nodes[j].EarliestFinish;
+                        slowest[i] = j;
+                    }
+                }
+                entry.EarliestFinish = ready + entry.Elapsed;
+
+                if (last == SIZE_MAX || entry.EarliestFinish > report.Nodes[last].EarliestFinish)
+                    last = i;
+            }
+        }
+
+        for (size_t i = last; i != SIZE_MAX; i = slowest[i])
+        {
+            report.CriticalPath.push_back(i);
+            report.Nodes[i].OnCriticalPath = true;
+        }
+        std::reverse(report.CriticalPath.begin(), report.CriticalPath.end());
+
+        if (last != SIZE_MAX)
+            report.CriticalPathElapsed = report.Nodes[last].EarliestFinish;
+
+        return report;
+    }
+
+    // Objects that transitively depend on the wrapper, in initialization
+    // order and not including the wrapper.  Valid after InitializeAll()
+    template<class T, class... Policies>
+    std::vector<IDependencyInjected*> GetDependents(DependencyInjected<T, Policies...>& wrapper) const
+    {
+        std::vector<IDependencyInjected*> dependents;
+
+        const size_t target = FindWrapper(&wrapper);
+        if (target == SIZE_MAX)
+            return dependents;
+
+        const std::vector<bool> affected = MarkDependents(target);
+        for (const auto& level : Levels)
+            for (size_t i : level)
+                if (affected[i] && i != target)
+                    dependents.push_back(Nodes[i].Wrapper);
+        return dependents;
+    }
+
+    // Shutdown all objects in reverse dependency order.  Each object is
+    // shut down as soon as every object that depends on it is, concurrently
+    // with the rest, so a slow object only delays the objects it depends on
+    DependencyShutdownReport ShutdownAll()
+    {
+        DependencyShutdownReport report;
+        const Clock::time_point start = Clock::now();
+
+        ShutdownAfterDependents();
+
+        for (size_t i = Levels.size(); i > 0; --i)
+        {
+            for (size_t j : Levels[i - 1])
+            {
+                const Node& node = Nodes[j];
+                const std::chrono::nanoseconds deadline =
+                    node.ShutdownDeadline.count() > 0 ? node.ShutdownDeadline : DefaultShutdownDeadline;
+
+                if (deadline.count() > 0 && node.ShutdownElapsed > deadline)
+                {
+                    DependencyShutdownOverrun overrun;
+                    overrun.Wrapper = node.Wrapper;
+                    overrun.TypeName = node.TypeName;
+                    overrun.Elapsed = node.ShutdownElapsed;
+                    overrun.Deadline = deadline;
+                    report.Overruns.push_back(overrun);
+                }
+            }
+        }
+
+        Initialized = false;
+
+        report.Elapsed = Clock::now() - start;
+        return report;
+    }
+
+    // Used by InitializeAllOrRollback() and Reinitialize()
+    void SetRetryPolicy(const DependencyRetryPolicy& policy)
+    {
+        Retry = policy;
+    }
+
+    // Deadline for Drain() plus Shutdown() of each object.  0 = none
+    void SetDefaultShutdownDeadline(std::chrono::nanoseconds deadline)
+    {
+        DefaultShutdownDeadline = deadline;
+    }
+
+    // Deadline for one registered object, overriding the default
+    template<class T, class... Policies>
+    void SetShutdownDeadline(DependencyInjected<T, Policies...>& wrapper, std::chrono::nanoseconds deadline)
+    {
+        for (Node& node : Nodes)
+        {
+            if (node.Wrapper == &wrapper)
+            {
+                node.ShutdownDeadline = deadline;
+                return;
+            }
+        }
+
+        // Catch setting a deadline on an object that was never added
+        DI_DEBUG_ASSERT(false);
+    }
+
+    // Initialize the object on a thread bound to a NUMA node.
+    // Pair with an ArenaStorage wrapper on a NumaArena for the same node
+    // so the object memory is there too.  -1 = no placement
+    template<class T, class... Policies>
+    void SetNumaNode(DependencyInjected<T, Policies...>& wrapper, int numaNode)
+    {
+        const size_t index = FindWrapper(&wrapper);
+        if (index == SIZE_MAX)
+        {
+            // Catch placing an object that was never added
+            DI_DEBUG_ASSERT(false);
+            return;
+        }
+
+        Nodes[index].NumaNode = numaNode;
+    }
+
+    size_t GetNodeCount() const
+    {
+        return Nodes.size();
+    }
+
+    // Valid after InitializeAll()
+    size_t GetLevelCount() const
+    {
+        return Levels.size();
+    }
+
+protected:
+    struct Node
+    {
+        IDependencyInjected* Wrapper = nullptr;
+
+        // Object memory: Dependencies that point into it refer to this node
+        const char* Storage = nullptr;
+        size_t StorageBytes = 0;
+
+        std::function<bool()> Initialize;
+#if defined(DI_COROUTINES)
+        // Set instead of Initialize when T::Initialize() is a coroutine
+        std::function<DependencyTask<bool>()> InitializeAsync;
+#endif // DI_COROUTINES
+        std::function<void()> Shutdown;
+        std::function<void(std::vector<const void*>&)> GetEdges;
+        std::function<bool(const DependencyDetail::WireProviderMap&)> AutoWire;
+
+        const char* TypeName = nullptr;
+        std::chrono::nanoseconds ShutdownDeadline{ 0 };
+        std::chrono::nanoseconds ShutdownElapsed{ 0 };
+        int NumaNode = -1;
+
+        // Relative to the start of InitializeAll()
+        std::chrono::nanoseconds InitializeStart{ 0 };
+        std::chrono::nanoseconds InitializeElapsed{ 0 };
+        unsigned Attempts = 0;
+        bool Failed = false;
+
+        // Indices of nodes that must be initialized first
+        std::vector<size_t> DependsOn;
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    DependencyThreadPool Pool;
+    std::vector<Node> Nodes;
+    std::vector<std::pair<const void*, DependencyDetail::WireProvider>> Providers;
+    std::vector<std::vector<size_t>> Levels;
+    std::chrono::nanoseconds DefaultShutdownDeadline{ 0 };
+    DependencyRetryPolicy Retry;
+    size_t AsyncNodeCount = 0;
+    bool Initialized = false;
+    Clock::time_point StartupBegin;
+    std::chrono::nanoseconds StartupElapsed{ 0 };
+
+    // Run the Shutdown() of each node once all nodes that depend on it are
+    // done, on as many pool threads as there is work for
+    void ShutdownAfterDependents()
+    {
+        std::vector<size_t> dependents(Nodes.size(), 0);
+        size_t total = 0;
+
+        for (const auto& level : Levels)
+        {
+            for (size_t i : level)
+            {
+                ++total;
+                for (size_t d : Nodes[i].DependsOn)
+                    ++dependents[d];
+            }
+        }
+
+        // Deepest level first, as a level-by-level shutdown would
+        std::vector<size_t> ready;
+        ready.reserve(total);
+        for (size_t i = Levels.size(); i > 0; --i)
+            for (size_t j : Levels[i - 1])
+                if (dependents[j] == 0)
+                    ready.push_back(j);
+
+        std::mutex lock;
+        std::condition_variable readyCondition;
+        size_t nextReady = 0;
+        size_t finished = 0;
+
+        const size_t workers = std::min<size_t>(Pool.GetThreadCount(), total);
+        Pool.ParallelFor(workers, [&](size_t) {
+            std::unique_lock<std::mutex> locker(lock);
+            for (;;)
+            {
+                // Some node is still shutting down until all are finished
+                readyCondition.wait(locker, [&] { return nextReady < ready.size() || finished == total; });
+                if (nextReady == ready.size())
+                    return;
+
+                Node& node = Nodes[ready[nextReady++]];
+                locker.unlock();
+
+                const Clock::time_point t0 = Clock::now();
+                node.Shutdown();
+                node.ShutdownElapsed = Clock::now() - t0;
+
+                locker.lock();
+                ++finished;
+                for (size_t d : node.DependsOn)
+                    if (--dependents[d] == 0)
+                        ready.push_back(d);
+                readyCondition.notify_all();
+            }
+        });
+    }
+
+    bool InitializeLevels()
+    {
+#if defined(DI_COROUTINES)
+        if (AsyncNodeCount > 0)
+            return InitializeAsyncGraph();
+#endif // DI_COROUTINES
+
+        for (const auto& level : Levels)
+        {
+            // Do not start dependents of an object that failed
+            if (!InitializeBatch(level))
+                return false;
+        }
+
+        return true;
+    }
+
+#if defined(DI_COROUTINES)
+    // Starts each node when the nodes it depends on are ready.  Coroutines
+    // run on whichever thread resumes them, and synchronous nodes run on
+    // the pool in batches.  Returns when no node is running
+    bool InitializeAsyncGraph()
+    {
+        const size_t count = Nodes.size();
+
+        std::vector<size_t> remaining(count);
+        std::vector<std::vector<size_t>> dependents(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            remaining[i] = Nodes[i].DependsOn.size();
+            for (size_t j : Nodes[i].DependsOn)
+                dependents[j].push_back(i);
+        }
+
+        std::mutex lock;
+        std::condition_variable condition;
+        std::vector<size_t> readySync;
+        size_t started = 0, finished = 0;
+        bool failed = false;
+
+        std::function<void(size_t, bool)> onDone;
+
+        auto start = [&](const std::vector<size_t>& ready) {
+            for (size_t i : ready)
+            {
+                Nodes[i].InitializeStart = Clock::now() - StartupBegin;
+                ++Nodes[i].Attempts;
+                DependencyDetail::AwaitThen(Nodes[i].InitializeAsync(), [&onDone, i](bool success) {
+                    onDone(i, success);
+                });
+            }
+        };
+
+        // Lock must be held
+        auto makeReady = [&](size_t i, std::vector<size_t>& readyAsync) {
+            ++started;
+            if (Nodes[i].InitializeAsync)
+                readyAsync.push_back(i);
+            else
+                readySync.push_back(i);
+        };
+
+        onDone = [&](size_t i, bool success) {
+            Nodes[i].InitializeElapsed = Clock::now() - StartupBegin - Nodes[i].InitializeStart;
+            Nodes[i].Failed = !success;
+
+            std::vector<size_t> readyAsync;
+            {
+                std::lock_guard<std::mutex> locker(lock);
+                ++finished;
+
+                // Fail fast: Start nothing else after a failure
+                if (!success)
+                    failed = true;
+                if (!failed)
+                {
+                    for (size_t j : dependents[i])
+                        if (--remaining[j] == 0)
+                            makeReady(j, readyAsync);
+                }
+
+                // Notify under the lock: The caller may return right after
+                condition.notify_all();
+            }
+
+            // Nothing on the stack of the caller may be touched once the
+            // last node is done, unless this started more nodes
+            if (!readyAsync.empty())
+                start(readyAsync);
+        };
+
+        std::vector<size_t> readyAsync;
+        {
+            std::lock_guard<std::mutex> locker(lock);
+            for (size_t i = 0; i < count; ++i)
+                if (remaining[i] == 0)
+                    makeReady(i, readyAsync);
+        }
+        start(readyAsync);
+
+        for (;;)
+        {
+            std::vector<size_t> batch;
+            {
+                std::unique_lock<std::mutex> locker(lock);
+                condition.wait(locker, [&] { return !readySync.empty() || finished == started; });
+                if (readySync.empty())
+                    break;
+                batch.swap(readySync);
+            }
+
+            Pool.ParallelFor(batch.size(), [&](size_t k) {
+                Node& node = Nodes[batch[k]];
+                node.InitializeStart = Clock::now() - StartupBegin;
+                ++node.Attempts;
+                onDone(batch[k], node.Initialize());
+            });
+        }
+
+        return !failed && finished == count;
+    }
+#endif // DI_COROUTINES
+
+    // Find the node whose object memory contains the pointer
+    static size_t FindNode(
+        const std::vector<std::pair<const char*, size_t>>& sorted,
+        const std::vector<Node>& nodes,
+        const void* ptr)
+    {
+        const char* p = static_cast<const char*>(ptr);
+
+        auto it = std::upper_bound(sorted.begin(), sorted.end(), p,
+            [](const char* key, const std::pair<const char*, size_t>& entry) {
+                return key < entry.first;
+            });
+        if (it == sorted.begin())
+            return SIZE_MAX;
+        --it;
+
+        const Node& node = nodes[it->second];
+        if (p >= node.Storage + node.StorageBytes)
+            return SIZE_MAX;
+        return it->second;
+    }
+
+    template<class T, class... Policies, class... Args>
+    static void BindInitialize(Node& node, DependencyInjected<T, Policies...>& wrapper, Args&&... args)
+    {
+        // Arguments are stored by value and passed as lvalues, since the
+        // container may initialize the object more than once
+        auto boundArgs = std::make_tuple(std::forward<Args>(args)...);
+
+        node.Initialize = nullptr;
+#if defined(DI_COROUTINES)
+        node.InitializeAsync = nullptr;
+
+        typedef decltype(wrapper.Initialize(std::declval<typename std::decay<Args>::type&>()...)) InitializeResultT;
+        if constexpr (DependencyDetail::IsDependencyTask<InitializeResultT>::value)
+        {
+            node.InitializeAsync = [&wrapper, boundArgs]() mutable -> DependencyTask<bool> {
+                return std::apply([&wrapper](auto&... a) {
+                    return wrapper.Initialize(a...);
+                }, boundArgs);
+            };
+        }
+        else
+#endif // DI_COROUTINES
+        node.Initialize = [&wrapper, boundArgs]() mutable -> bool {
+            return std::apply([&wrapper](auto&... a) {
+                return DependencyDetail::InvokeInitialize(wrapper, a...);
+            }, boundArgs);
+        };
+    }
+
+    // Runs a node's Initialize() to completion on the calling thread
+    static bool RunInitialize(Node& node)
+    {
+#if defined(DI_COROUTINES)
+        if (node.InitializeAsync)
+            return SyncWait(node.InitializeAsync());
+#endif // DI_COROUTINES
+        return node.Initialize();
+    }
+
+    // Initializes nodes that do not depend on each other concurrently.
+    // Placed nodes run on one thread per NUMA node, the rest on the pool
+    bool InitializeBatch(const std::vector<size_t>& batch)
+    {
+        std::atomic<bool> success{ true };
+
+        std::vector<size_t> pooled;
+        std::vector<std::pair<int, std::vector<size_t>>> placed;
+        for (size_t i : batch)
+        {
+            const int numaNode = Nodes[i].NumaNode;
+            if (numaNode < 0)
+            {
+                pooled.push_back(i);
+                continue;
+            }
+
+            auto it = std::find_if(placed.begin(), placed.end(),
+                [numaNode](const std::pair<int, std::vector<size_t>>& group) {
+                    return group.first == numaNode;
+                });
+            if (it == placed.end())
+                it = placed.insert(placed.end(), { numaNode, {} });
+            it->second.push_back(i);
+        }
+
+        std::vector<std::thread> threads;
+        threads.reserve(placed.size());
+        for (const auto& group : placed)
+        {
+            threads.emplace_back([this, &group, &success] {
+                // Best effort: Without the binding first-touch is just not local
+                BindThreadToNumaNode(static_cast<unsigned>(group.first));
+
+                for (size_t i : group.second)
+                    if (!TimedInitialize(Nodes[i]))
+                        success = false;
+            });
+        }
+
+        Pool.ParallelFor(pooled.size(), [&](size_t j) {
+            if (!TimedInitialize(Nodes[pooled[j]]))
+                success = false;
+        });
+
+        for (std::thread& thread : threads)
+            thread.join();
+
+        return success;
+    }
+
+    bool TimedInitialize(Node& node)
+    {
+        const Clock::time_point t0 = Clock::now();
+        const bool success = RunInitialize(node);
+        const Clock::time_point t1 = Clock::now();
+
+        node.InitializeStart = t0 - StartupBegin;
+        node.InitializeElapsed = t1 - t0;
+        ++node.Attempts;
+        node.Failed = !success;
+        return success;
+    }
+
+    // Initializes the batch, then shuts down the objects that failed and
+    // retries just those with backoff until they succeed or run out of
+    // attempts.  A failed object is never left up
+    bool InitializeBatchWithRetry(const std::vector<size_t>& batch)
+    {
+        std::vector<size_t> pending = batch;
+        std::chrono::nanoseconds backoff = Retry.InitialBackoff;
+
+        for (unsigned attempt = 1;; ++attempt)
+        {
+            InitializeBatch(pending);
+
+            std::vector<size_t> failed;
+            for (size_t i : pending)
+                if (Nodes[i].Failed)
+                    failed.push_back(i);
+
+            Pool.ParallelFor(failed.size(), [&](size_t j) {
+                Nodes[failed[j]].Shutdown();
+            });
+
+            if (failed.empty())
+                return true;
+            if (attempt >= Retry.MaxAttempts)
+                return false;
+
+            std::this_thread::sleep_for(backoff);
+            backoff = std::min(backoff * 2, Retry.MaxBackoff);
+            pending.swap(failed);
+        }
+    }
+
+    // Shuts down the objects that are up in the first levelCount levels,
+    // in reverse level order
+    void ShutdownStartedLevels(size_t levelCount)
+    {
+        for (size_t i = levelCount; i > 0; --i)
+        {
+            std::vector<size_t> batch;
+            for (size_t j : Levels[i - 1])
+                if (Nodes[j].Wrapper->IsInitialized())
+                    batch.push_back(j);
+
+            Pool.ParallelFor(batch.size(), [&](size_t j) {
+                Nodes[batch[j]].Shutdown();
+            });
+        }
+    }
+
+    void ResetAttempts(const std::vector<bool>& marked)
+    {
+        for (size_t i = 0; i < Nodes.size(); ++i)
+        {
+            if (marked[i])
+            {
+                Nodes[i].Attempts = 0;
+                Nodes[i].Failed = false;
+            }
+        }
+    }
+
+    // Index of the node for a wrapper, or SIZE_MAX
+    size_t FindWrapper(const IDependencyInjected* wrapper) const
+    {
+        for (size_t i = 0; i < Nodes.size(); ++i)
+            if (Nodes[i].Wrapper == wrapper)
+                return i;
+        return SIZE_MAX;
+    }
+
+    // Marks the target and every node that transitively depends on it.
+    // A node's dependencies are all in earlier levels, so one pass in
+    // level order sees each dependency marked before its users
+    std::vector<bool> MarkDependents(size_t target) const
+    {
+        std::vector<bool> marked(Nodes.size(), false);
+        marked[target] = true;
+
+        for (const auto& level : Levels)
+            for (size_t i : level)
+                for (size_t j : Nodes[i].DependsOn)
+                    if (marked[j])
+                        marked[i] = true;
+
+        return marked;
+    }
+
+    static std::vector<size_t> SelectMarked(const std::vector<size_t>& level, const std::vector<bool>& marked)
+    {
+        std::vector<size_t> batch;
+        for (size_t i : level)
+            if (marked[i])
+                batch.push_back(i);
+        return batch;
+    }
+
+    // Kahn's algorithm, grouping nodes by longest path from a leaf
+    bool BuildLevels()
+    {
+        const size_t count = Nodes.size();
+
+        std::vector<std::pair<const char*, size_t>> sorted;
+        sorted.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+            sorted.emplace_back(Nodes[i].Storage, i);
+        std::sort(sorted.begin(), sorted.end());
+
+        std::vector<std::vector<size_t>> dependents(count);
+        std::vector<size_t> remaining(count);
+        std::vector<const void*> edges;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            Node& node = Nodes[i];
+            node.DependsOn.clear();
+
+            edges.clear();
+            node.GetEdges(edges);
+
+            for (const void* edge : edges)
+            {
+                const size_t j = FindNode(sorted, Nodes, edge);
+
+                // Dependencies outside of the container are not ordered
+                if (j == SIZE_MAX || j == i)
+                    continue;
+                if (std::find(node.DependsOn.begin(), node.DependsOn.end(), j) != node.DependsOn.end())
+                    continue;
+
+                node.DependsOn.push_back(j);
+                dependents[j].push_back(i);
+            }
+
+            remaining[i] = node.DependsOn.size();
+        }
+
+        Levels.clear();
+
+        std::vector<size_t> ready;
+        for (size_t i = 0; i < count; ++i)
+            if (remaining[i] == 0)
+                ready.push_back(i);
+
+        size_t placed = 0;
+        while (!ready.empty())
+        {
+            placed += ready.size();
+
+            std::vector<size_t> next;
+            for (size_t i : ready)
+                for (size_t j : dependents[i])
+                    if (--remaining[j] == 0)
+                        next.push_back(j);
+
+            Levels.push_back(std::move(ready));
+            ready = std::move(next);
+        }
+
+        return placed == count;
+    }
+
+    // Deleted methods
+    DependencyContainer(const DependencyContainer&) = delete;
+    DependencyContainer& operator=(const DependencyContainer&) = delete;
+};
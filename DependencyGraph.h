@@ -0,0 +1,375 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    DependencyGraph
+
+    Compile-time dependency graph over a fixed set of object types.
+
+    The graph owns one DependencyInjected<> wrapper per type.  Edges are
+    read from the member types of each T::Dependencies struct: A member
+    RequiredDependency<X> or OptionalDependency<X> refers to the node whose
+    type is X or derives from X.  Dependencies on types outside of the graph
+    (like a ThirdPartyClass) are not ordered.
+
+    The initialization order is a constexpr topological sort, so that
+    InitializeAll() and ShutdownAll() are straight-line sequences of calls
+    with no heap, no virtual calls and no runtime sort.
+
+    Cycles are a compile error unless one of the edges is LateBound<>.
+
+    AutoWireAll() fills in every node's Dependencies struct from the same
+    member types, so handwritten SetDependencies() calls are only needed for
+    dependencies on objects outside of the graph.  The providers are known
+    at compile time, so the wiring compiles down to pointer stores.
+*/
+
+/*
+    Example Usage:
+
+
+    DependencyGraph<InterfaceUser, MyImplementation> graph;
+
+    graph.Get<MyImplementation>().SetDependencies({
+    });
+    graph.Get<InterfaceUser>().SetDependencies({
+        graph.Get<MyImplementation>()
+    });
+
+    // MyImplementation::Initialize() runs first, with parameterX = 10
+    graph.InitializeAll(
+        InitializeArgs<MyImplementation>(10));
+
+    graph.Get<InterfaceUser>()->DoThing();
+
+    graph.ShutdownAll();
+
+
+    Auto-wiring:
+
+
+    DependencyGraph<InterfaceUser, MyImplementation> graph;
+
+    graph.AutoWireAll(); // InterfaceUser's RequiredDependency<IMyInterface> is MyImplementation
+
+    graph.InitializeAll(
+        InitializeArgs<MyImplementation>(10));
+*/
+
+#include "DependencyInjected.h"
+
+#include <array>
+#include <tuple>
+
+
+//------------------------------------------------------------------------------
+// InitializeArgs
+//
+// Arguments for the Initialize() of one node in a DependencyGraph
+
+template<class T, class... Args>
+struct InitializeArgsT
+{
+    typedef T Type;
+
+    std::tuple<Args...> Values;
+};
+
+template<class T, class... Args>
+DI_FORCE_INLINE InitializeArgsT<T, typename std::decay<Args>::type...> InitializeArgs(Args&&... args)
+{
+    return { std::tuple<typename std::decay<Args>::type...>(std::forward<Args>(args)...) };
+}
+
+
+namespace DependencyDetail {
+
+// Number of types in Ts that provide X: X itself if listed, otherwise the
+// types that derive from X
+template<class X, class... Ts>
+constexpr size_t ProviderCount()
+{
+    constexpr size_t exact = (size_t(0) + ... + size_t(std::is_same<X, Ts>::value));
+    constexpr size_t derived = (size_t(0) + ... + size_t(std::is_base_of<X, Ts>::value && !std::is_same<X, Ts>::value));
+    return exact > 0 ? exact : derived;
+}
+
+// Index of the type in Ts that provides X, or sizeof...(Ts).  Two providers
+// are an error, as they are for DependencyContainer::AutoWireAll()
+template<class X, class... Ts>
+constexpr size_t ProviderIndex()
+{
+    static_assert(ProviderCount<X, Ts...>() <= 1,
+        "Ambiguous provider: Two listed types are or derive from the same dependency type");
+
+    constexpr bool exact[] = { std::is_same<X, Ts>::value..., false };
+    constexpr bool derived[] = { std::is_base_of<X, Ts>::value..., false };
+    for (size_t i = 0; i < sizeof...(Ts); ++i)
+        if (exact[i])
+            return i;
+    for (size_t i = 0; i < sizeof...(Ts); ++i)
+        if (derived[i])
+            return i;
+    return sizeof...(Ts);
+}
+
+// Index of the exact type T in Ts, or sizeof...(Ts)
+template<class T, class... Ts>
+constexpr size_t TypeIndex()
+{
+    constexpr bool matches[] = { std::is_same<T, Ts>::value..., false };
+    for (size_t i = 0; i < sizeof...(Ts); ++i)
+        if (matches[i])
+            return i;
+    return sizeof...(Ts);
+}
+
+// Node index an ordering edge points to, or sizeof...(Ts) for no edge
+template<class M, class... Ts>
+constexpr size_t EdgeTarget()
+{
+    typedef DependencyMemberTraits<M> Traits;
+
+    if constexpr (Traits::IsDependency && !Traits::IsLateBound)
+        return ProviderIndex<typename Traits::Type, Ts...>();
+    else
+        return sizeof...(Ts);
+}
+
+template<class... Ts, class... M>
+constexpr std::array<size_t, sizeof...(M) + 1> EdgeTargets(TypeList<M...>)
+{
+    return { { EdgeTarget<M, Ts...>()..., sizeof...(Ts) } };
+}
+
+template<size_t N>
+struct GraphOrder
+{
+    std::array<size_t, N> Order;
+    bool Acyclic;
+};
+
+template<class T, class... Ts>
+constexpr void AddEdges(std::array<bool, sizeof...(Ts) * sizeof...(Ts)>& edges, size_t node)
+{
+    constexpr size_t N = sizeof...(Ts);
+    constexpr auto targets = EdgeTargets<Ts...>(MemberTypes<typename T::Dependencies>());
+
+    for (size_t target : targets)
+        if (target < N && target != node)
+            edges[node * N + target] = true;
+}
+
+// Kahn's algorithm over the adjacency matrix, stable in declaration order
+template<class... Ts>
+constexpr GraphOrder<sizeof...(Ts)> SortGraph()
+{
+    constexpr size_t N = sizeof...(Ts);
+
+    // edges[i * N + j] = Node i depends on node j
+    std::array<bool, N * N> edges{};
+    size_t node = 0;
+    (AddEdges<Ts, Ts...>(edges, node++), ...);
+
+    std::array<size_t, N> remaining{};
+    for (size_t i = 0; i < N; ++i)
+        for (size_t j = 0; j < N; ++j)
+            if (edges[i * N + j])
+                ++remaining[i];
+
+    GraphOrder<N> result{};
+    size_t count = 0;
+    for (size_t i = 0; i < N; ++i)
+        if (remaining[i] == 0)
+            result.Order[count++] = i;
+
+    for (size_t next = 0; next < count; ++next)
+    {
+        const size_t done = result.Order[next];
+        for (size_t i = 0; i < N; ++i)
+            if (edges[i * N + done] && --remaining[i] == 0)
+                result.Order[count++] = i;
+    }
+
+    result.Acyclic = (count == N);
+    return result;
+}
+
+// Index in Packs of the InitializeArgsT for T, or sizeof...(Packs)
+template<class T, class... Packs>
+constexpr size_t ArgsIndex()
+{
+    return TypeIndex<T, typename std::decay<Packs>::type::Type...>();
+}
+
+} // namespace DependencyDetail
+
+
+//------------------------------------------------------------------------------
+// DependencyGraph
+
+template<class... Ts>
+class DependencyGraph
+{
+public:
+    static const size_t NodeCount = sizeof...(Ts);
+
+    template<class T>
+    DI_FORCE_INLINE DependencyInjected<T>& Get()
+    {
+        constexpr size_t index = DependencyDetail::TypeIndex<T, Ts...>();
+        static_assert(index < NodeCount, "Type is not a node of this DependencyGraph");
+
+        return std::get<index>(Nodes);
+    }
+
+    // Dependencies for T with every dependency member whose type is provided
+    // by a node set to that node.  Other members are value-initialized, so
+    // they can be set by hand before SetDependencies()
+    template<class T>
+    DI_FORCE_INLINE typename T::Dependencies Wire()
+    {
+        return DependencyDetail::BuildDependencies<typename T::Dependencies>([this](auto tag) {
+            return WireMember<typename decltype(tag)::Type, false>();
+        });
+    }
+
+    // SetDependencies() on every node from the graph.  Every required
+    // dependency must be provided by a node
+    DI_FORCE_INLINE void AutoWireAll()
+    {
+        (Get<Ts>().SetDependencies(
+            DependencyDetail::BuildDependencies<typename Ts::Dependencies>([this](auto tag) {
+                return WireMember<typename decltype(tag)::Type, true>();
+            })), ...);
+    }
+
+    // Initialize all nodes in dependency order
+    // Pass InitializeArgs<T>(...) for each node whose Initialize() takes arguments.
+    // Stops at the first failure and returns false
+    // Arguments in an rvalue InitializeArgs<T>(...) are moved into Initialize()
+    template<class... Packs>
+    DI_FORCE_INLINE bool InitializeAll(Packs&&... packs)
+    {
+        return InitializeInOrder<Packs...>(std::make_index_sequence<NodeCount>(), packs...);
+    }
+
+    // Shutdown all nodes in reverse dependency order
+    DI_FORCE_INLINE void ShutdownAll()
+    {
+        ShutdownInOrder(std::make_index_sequence<NodeCount>());
+    }
+
+    // Position of T in the initialization order
+    template<class T>
+    static constexpr size_t GetInitializeOrder()
+    {
+        constexpr size_t index = DependencyDetail::TypeIndex<T, Ts...>();
+        static_assert(index < NodeCount, "Type is not a node of this DependencyGraph");
+
+        for (size_t i = 0; i < NodeCount; ++i)
+            if (Sorted.Order[i] == index)
+                return i;
+        return NodeCount;
+    }
+
+protected:
+    static constexpr DependencyDetail::GraphOrder<NodeCount> Sorted =
+        DependencyDetail::SortGraph<Ts...>();
+
+    static_assert(Sorted.Acyclic,
+        "DependencyGraph has a dependency cycle: Mark one of the edges LateBound<>");
+
+    std::tuple<DependencyInjected<Ts>...> Nodes;
+
+    template<class... Packs, size_t... I>
+    DI_FORCE_INLINE bool InitializeInOrder(std::index_sequence<I...>, typename std::remove_reference<Packs>::type&... packs)
+    {
+        return (InitializeNode<Sorted.Order[I], Packs...>(packs...) && ...);
+    }
+
+    template<size_t... I>
+    DI_FORCE_INLINE void ShutdownInOrder(std::index_sequence<I...>)
+    {
+        (std::get<Sorted.Order[NodeCount - 1 - I]>(Nodes).Shutdown(), ...);
+    }
+
+    template<class M, bool Complete>
+    DI_FORCE_INLINE M WireMember()
+    {
+        if constexpr (DependencyDetail::IsWirable<M>::value)
+        {
+            typedef DependencyMemberTraits<M> Traits;
+            typedef typename Traits::Type X;
+            constexpr size_t index = DependencyDetail::ProviderIndex<X, Ts...>();
+
+            if constexpr (index < NodeCount)
+            {
+                auto& node = std::get<index>(Nodes);
+                return M(node.GetObjectPtr(), &node);
+            }
+            else
+            {
+                static_assert(!Complete || !Traits::IsRequired,
+                    "RequiredDependency has no provider in this DependencyGraph: Use Wire<T>() and set it by hand");
+                return M();
+            }
+        }
+        else
+            return M();
+    }
+
+    template<size_t Index, class... Packs>
+    DI_FORCE_INLINE bool InitializeNode(typename std::remove_reference<Packs>::type&... packs)
+    {
+        typedef typename std::tuple_element<Index, std::tuple<Ts...>>::type T;
+        constexpr size_t argsIndex = DependencyDetail::ArgsIndex<T, Packs...>();
+
+        auto& node = std::get<Index>(Nodes);
+
+        if constexpr (argsIndex < sizeof...(Packs))
+        {
+            typedef typename std::tuple_element<argsIndex, std::tuple<Packs...>>::type PackT;
+            auto& values = std::get<argsIndex>(std::forward_as_tuple(packs...)).Values;
+
+            auto invoke = [&node](auto&&... args) {
+                return DependencyDetail::InvokeInitialize(node, std::forward<decltype(args)>(args)...);
+            };
+
+            if constexpr (std::is_lvalue_reference<PackT>::value)
+                return std::apply(invoke, values);
+            else
+                return std::apply(invoke, std::move(values));
+        }
+        else
+            return DependencyDetail::InvokeInitialize(node);
+    }
+};
@@ -0,0 +1,108 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+    DependencyInjected C++20 module
+
+    Optional module interface for the wrappers in DependencyInjected.h.
+    The headers are compiled once into the module instead of being parsed
+    again by every translation unit.  Build it with DI_BUILD_MODULE in
+    CMake 3.28 or newer, or add it to a C++20 project as a module
+    interface unit.
+
+    The module exports the names marked DI_EXPORT: DependencyInjected,
+    the policies, OptionalDependency, RequiredDependency, LateBound,
+    DependencyBinding and the violation handler, plus the
+    DependencyViolationLog in debug builds.  Macros are not exported, so
+    translation units that use DI_BIND_IMPLEMENTATION include
+    DependencyInjectedFwd.h as well.  The other headers (DependencyContainer.h,
+    DependencyInjectedPool.h, ...) include DependencyInjected.h and cannot
+    be mixed with the import in one translation unit.
+
+    Build flags like DEBUG, DI_HARDENED and DI_TRACE must match between the
+    module and the code that imports it.
+*/
+
+/*
+    Example Usage:
+
+
+    import DependencyInjected;
+
+    DependencyInjected<Cog> cog;
+    DependencyInjected<Widget, CacheLineAligned> widget;
+*/
+
+module;
+
+// Everything the headers include from outside the module
+#include <cstring>
+#include <new>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+#include <initializer_list>
+#include <memory_resource>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <tuple>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#else // _MSC_VER
+    #include <dlfcn.h>
+#endif // _MSC_VER
+
+#if defined(__SANITIZE_ADDRESS__)
+    #include <sanitizer/asan_interface.h>
+#elif defined(__has_feature)
+    #if __has_feature(address_sanitizer)
+        #include <sanitizer/asan_interface.h>
+    #endif
+#endif
+
+// Type names, tracing and access counters stay in the global module, so
+// they can still be included next to the import
+#include "DependencyTypeName.h"
+#include "DependencyThreadId.h"
+#if defined(DI_TRACE)
+    #include "DependencyTrace.h"
+#endif // DI_TRACE
+#if defined(DI_COUNT_ACCESSES)
+    #include "DependencyAccessCounters.h"
+#endif // DI_COUNT_ACCESSES
+
+export module DependencyInjected;
+
+#define DI_EXPORT export
+#include "DependencyInjected.h"
+#include "DependencyArenaStorage.h"
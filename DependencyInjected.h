@@ -58,7 +58,9 @@
             Initialize(); Shutdown(); Initialize();
         where state from the previous instance leaks into the new one.
     (4) Compiler optimizations work well with the abstractions (tested in MSVC)
-    (5) All the extra debugging checks listed below...
+    (5) No vtables: Dependencies are trivially copyable, and a required one
+        is a single pointer in release builds without DI_HARDENED
+    (6) All the extra debugging checks listed below...
 
     Verifies in debug mode that:
 
@@ -67,6 +69,18 @@
     (3) Objects are initialized before use
     (4) Objects are not initialized twice
     (5) Objects are explicitly shutdown before they go out of scope
+
+    Release builds with DI_HARDENED defined keep checks (2) through (5) as
+    cold calls into a handler set by SetDependencyViolationHandler().
+
+    Debug builds trap at the first failed check, unless a
+    DependencyViolationLog is enabled (see DependencyViolationLog.h): Then
+    every failure is recorded and the program carries on.
+
+    Headers that only declare a Dependencies struct can include
+    DependencyMembers.h instead, and DependencyInjectedFwd.h forward
+    declares the types.  DependencyInjected.cppm wraps this header in a
+    C++20 module.
 */
 
 /*
@@ -134,276 +148,658 @@
     }
 */
 
+#include "DependencyMembers.h"
 
-//------------------------------------------------------------------------------
-// Portability macros
-
-// Compiler-specific debug break
-#if defined(_DEBUG) || defined(DEBUG)
-    #define DI_DEBUG
-    #if defined(_WIN32)
-        #define DI_DEBUG_BREAK() __debugbreak()
-    #else // _WIN32
-        #define DI_DEBUG_BREAK() __builtin_trap()
-    #endif // _WIN32
-    #define DI_DEBUG_ASSERT(cond) { if (!(cond)) { DI_DEBUG_BREAK(); } }
-#else // _DEBUG
-    #define DI_DEBUG_BREAK() do {} while (false);
-    #define DI_DEBUG_ASSERT(cond) do {} while (false);
-#endif // _DEBUG
-
-// Compiler-specific force inline keyword
-#if defined(_MSC_VER)
-    #define DI_FORCE_INLINE inline __forceinline
-#else // _MSC_VER
-    #define DI_FORCE_INLINE inline __attribute__((always_inline))
-#endif // _MSC_VER
+#include <cstring> // memset
+#include <new> // placement new
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+#include <initializer_list>
+#include <atomic>
+#include <cstdint>
+
+// Debug builds can collect violations instead of trapping
+#if defined(DI_DEBUG)
+    #include "DependencyViolationLog.h"
+#endif // DI_DEBUG
 
 
 //------------------------------------------------------------------------------
-// DependencyInjected
+// Policies
 //
-// Smart pointer with dependency injection
+// Optional tags for DependencyInjected<T, Policies...>
+
+/*
+    Example:
+
+    DependencyInjected<Widget, CacheLineAligned> widget;
+*/
+
+// Places the object on its own cache lines, so that objects written by
+// different threads do not share a line with each other or with wrapper
+// fields like Instance and Deps
+struct CacheLineAligned
+{
+    static const size_t Alignment = DI_CACHE_LINE_BYTES;
+};
 
-class IDependencyInjected
+// Skips clearing the object memory in the constructor and in Shutdown().
+// Debug builds still clear it, so that state leaking between instances
+// stays testable, and sanitizer builds fill it with DI_POISON_BYTE instead
+struct FastReset
+{
+    static const bool SkipsReset = true;
+};
+
+// Object memory is allocated on the heap when the wrapper is constructed,
+// which keeps the owner of a large object small
+struct HeapStorage
+{
+};
+
+// ArenaStorage is defined in DependencyArenaStorage.h, so that only its
+// users include <memory_resource>
+
+namespace DependencyDetail {
+
+template<class P, class = void>
+struct PolicySkipsReset : std::false_type {};
+
+template<class P>
+struct PolicySkipsReset<P, std::void_t<decltype(P::SkipsReset)>>
+    : std::integral_constant<bool, P::SkipsReset> {};
+
+template<class P, class = void>
+struct PolicyAlignment : std::integral_constant<size_t, 1> {};
+
+template<class P>
+struct PolicyAlignment<P, std::void_t<decltype(P::Alignment)>>
+    : std::integral_constant<size_t, P::Alignment> {};
+
+constexpr size_t MaxOf(std::initializer_list<size_t> values)
+{
+    size_t result = 0;
+    for (size_t value : values)
+        if (result < value)
+            result = value;
+    return result;
+}
+
+// Size and alignment of the object memory inside the wrapper
+template<class T, class... Policies>
+struct StorageLayout
+{
+    static const size_t Padding = MaxOf({ size_t(1), PolicyAlignment<Policies>::value... });
+    static const size_t Alignment = MaxOf({ alignof(T), Padding });
+    static const size_t Bytes = (sizeof(T) + Padding - 1) / Padding * Padding;
+
+    // Object memory is cleared after construction and Shutdown()
+#if defined(DI_DEBUG)
+    static const bool ClearsMemory = true;
+#else // DI_DEBUG
+    static const bool ClearsMemory = !(PolicySkipsReset<Policies>::value || ...);
+#endif // DI_DEBUG
+};
+
+// Object memory inside the wrapper (default)
+template<class LayoutT>
+class InlineObjectStorage
 {
 public:
-    virtual ~IDependencyInjected() {}
+    DI_FORCE_INLINE unsigned char* Get()
+    {
+        return Memory;
+    }
 
-    DI_FORCE_INLINE operator bool() const
+protected:
+    alignas(LayoutT::Alignment) unsigned char Memory[LayoutT::Bytes];
+};
+
+template<class LayoutT>
+class HeapObjectStorage
+{
+public:
+    HeapObjectStorage()
     {
-        return IsInitialized();
+        Memory = static_cast<unsigned char*>(
+            ::operator new(LayoutT::Bytes, std::align_val_t(LayoutT::Alignment)));
     }
-    DI_FORCE_INLINE bool IsInitialized() const
+    ~HeapObjectStorage()
     {
-        return Initialized;
+        ::operator delete(Memory, std::align_val_t(LayoutT::Alignment));
+    }
+
+    DI_FORCE_INLINE unsigned char* Get()
+    {
+        return Memory;
     }
 
 protected:
-    bool Initialized = false;
+    unsigned char* Memory;
+
+    HeapObjectStorage(const HeapObjectStorage&) = delete;
+    HeapObjectStorage& operator=(const HeapObjectStorage&) = delete;
+};
+
+template<class P, class LayoutT>
+struct PolicyStorage
+{
+    typedef void Type;
+};
+
+template<class LayoutT>
+struct PolicyStorage<HeapStorage, LayoutT>
+{
+    typedef HeapObjectStorage<LayoutT> Type;
+};
+
+// Defined in DependencyArenaStorage.h, which must be included to use it
+template<class LayoutT>
+struct PolicyStorage<ArenaStorage, LayoutT>;
+
+// First storage policy in the list, or inline storage
+template<class LayoutT, class... Policies>
+struct SelectStorage
+{
+    typedef InlineObjectStorage<LayoutT> Type;
 };
 
-template<class T>
+template<class LayoutT, class P, class... Rest>
+struct SelectStorage<LayoutT, P, Rest...>
+{
+    typedef typename PolicyStorage<P, LayoutT>::Type PolicyT;
+
+    typedef typename std::conditional<std::is_void<PolicyT>::value,
+        typename SelectStorage<LayoutT, Rest...>::Type, PolicyT>::type Type;
+};
+
+// Clear object memory after construction and Shutdown()
+template<class LayoutT>
+DI_FORCE_INLINE void ResetObjectMemory(void* memory, size_t bytes)
+{
+    if constexpr (LayoutT::ClearsMemory)
+        memset(memory, 0, bytes);
+#if defined(DI_SANITIZER)
+    else
+    {
+        memset(memory, DI_POISON_BYTE, bytes);
+
+        // Catch use after Shutdown() until the next Initialize()
+        DI_ASAN_POISON(memory, bytes);
+    }
+#else // DI_SANITIZER
+    else
+    {
+        (void)memory;
+        (void)bytes;
+    }
+#endif // DI_SANITIZER
+}
+
+// Defined with the Dependencies reflection below
+template<class D, class F>
+DI_FORCE_INLINE void ForEachDependency(D& deps, F&& f);
+template<class D, class F>
+DI_FORCE_INLINE decltype(auto) InvokeWithLiveDependencies(D& deps, F&& f);
+
+} // namespace DependencyDetail
+
+
+//------------------------------------------------------------------------------
+// DependencyInjected
+//
+// Smart pointer with dependency injection
+
+template<class T, class... Policies>
 class DependencyInjected : public IDependencyInjected
 {
 public:
     typedef typename T::Dependencies DepsT;
+    typedef DependencyDetail::StorageLayout<T, Policies...> LayoutT;
+    typedef typename DependencyDetail::SelectStorage<LayoutT, Policies...>::Type StorageT;
 
     // Set dependencies
     DI_FORCE_INLINE void SetDependencies(const DepsT& deps)
     {
         // Catch setting dependencies after Initialize() in debug mode
-        DI_DEBUG_ASSERT(!IsInitialized());
+        DI_CHECK(!IsInitialized(), DependencyViolationKind::SetDependenciesAfterInitialize, T,
+            "SetDependencies() after Initialize()");
 
         Deps = deps;
         SetDeps = true;
+        DI_COUNT_EDGES(T, Deps);
+    }
+    DI_FORCE_INLINE void SetDependencies(DepsT&& deps)
+    {
+        // Catch setting dependencies after Initialize() in debug mode
+        DI_CHECK(!IsInitialized(), DependencyViolationKind::SetDependenciesAfterInitialize, T,
+            "SetDependencies() after Initialize()");
+
+        Deps = std::move(deps);
+        SetDeps = true;
+        DI_COUNT_EDGES(T, Deps);
     }
 
-    // Initialize the object
+    // Initialize the object.  If T::Initialize() fails the object stays
+    // initialized, so that Shutdown() can release what it acquired
     template<typename... Args>
     auto Initialize(Args&&... args)
     {
         // Catch double-initialization in debug mode
-        DI_DEBUG_ASSERT(SetDeps && !IsInitialized());
+        DI_CHECK(SetDeps && !IsInitialized(), GetInitializeViolation(), T,
+            "Initialize() twice or without SetDependencies()");
+
+        DI_TRACE_SCOPE(trace, "Initialize", T, ObjectMemory.Get());
+        DI_TRACE_EDGES(trace, Deps);
 
         Initialized = true;
 
         // Create the object instance (placement new)
-        Instance = new (&ObjectMemory)T();
+        DI_ASAN_UNPOISON(ObjectMemory.Get(), LayoutT::Bytes);
+        Instance = new (ObjectMemory.Get())T();
 
-        // Initialize the object
-        return Instance->Initialize(Deps, args...);
+        // Initialize the object, with optionals whose wrapper is down unset
+        return DependencyDetail::InvokeWithLiveDependencies(Deps, [&](DepsT& deps) -> decltype(auto) {
+            return Instance->Initialize(deps, std::forward<Args>(args)...);
+        });
+    }
+
+    // Initialize the object, moving the dependencies into T::Initialize().
+    // SetDependencies() must be called again before the next Initialize()
+    template<typename... Args>
+    auto InitializeAndMoveDependencies(Args&&... args)
+    {
+        // Catch double-initialization in debug mode
+        DI_CHECK(SetDeps && !IsInitialized(), GetInitializeViolation(), T,
+            "Initialize() twice or without SetDependencies()");
+
+        DI_TRACE_SCOPE(trace, "Initialize", T, ObjectMemory.Get());
+        DI_TRACE_EDGES(trace, Deps);
+
+        Initialized = true;
+        SetDeps = false;
+
+        // Create the object instance (placement new)
+        DI_ASAN_UNPOISON(ObjectMemory.Get(), LayoutT::Bytes);
+        Instance = new (ObjectMemory.Get())T();
+
+        // Initialize the object, with optionals whose wrapper is down unset
+        return DependencyDetail::InvokeWithLiveDependencies(Deps, [&](DepsT& deps) -> decltype(auto) {
+            return Instance->Initialize(std::move(deps), std::forward<Args>(args)...);
+        });
+    }
+
+    // Initialize the object through f(T& instance, const DepsT& deps)
+    // instead of T::Initialize(), e.g. to restore it from a snapshot
+    template<class F>
+    auto InitializeWith(F&& f)
+    {
+        // Catch double-initialization in debug mode
+        DI_CHECK(SetDeps && !IsInitialized(), GetInitializeViolation(), T,
+            "Initialize() twice or without SetDependencies()");
+
+        DI_TRACE_SCOPE(trace, "Initialize", T, ObjectMemory.Get());
+        DI_TRACE_EDGES(trace, Deps);
+
+        Initialized = true;
+
+        // Create the object instance (placement new)
+        DI_ASAN_UNPOISON(ObjectMemory.Get(), LayoutT::Bytes);
+        Instance = new (ObjectMemory.Get())T();
+
+        return DependencyDetail::InvokeWithLiveDependencies(Deps, [&](DepsT& deps) -> decltype(auto) {
+            return f(*Instance, static_cast<const DepsT&>(deps));
+        });
     }
 
     // Shutdown the object
     template<typename... Args>
     void Shutdown(Args&&... args)
+    {
+        ShutdownWith([&](T& instance) {
+            instance.Shutdown(std::forward<Args>(args)...);
+        });
+    }
+
+    // Shutdown the object through f(T& instance) instead of T::Shutdown(),
+    // e.g. after an asynchronous shutdown has completed
+    template<class F>
+    void ShutdownWith(F&& f)
     {
         if (Instance)
         {
+            DI_TRACE_SCOPE(trace, "Shutdown", T, ObjectMemory.Get());
+
             // Invoke the derived class OnShutdown() method
-            Instance->Shutdown(args...);
+            f(*Instance);
 
             // Call the deallocator
             Instance->~T();
 
             // Clear class memory
-            memset(ObjectMemory, 0, sizeof(ObjectMemory));
+            ResetObjectMemory();
 
             // Clear the object instance pointer
             Instance = nullptr;
 
             Initialized = false;
+#if defined(DI_DEBUG)
+            WasShutdown = true;
+#endif // DI_DEBUG
         }
     }
 
     DI_FORCE_INLINE explicit DependencyInjected()
     {
         // Ensure that object memory state is the same in debug and release
-        memset(ObjectMemory, 0, sizeof(ObjectMemory));
+        ResetObjectMemory();
     }
 
-    DI_FORCE_INLINE virtual ~DependencyInjected()
+    // For ArenaStorage: Object memory is allocated from the resource
+    template<class R, typename std::enable_if<std::is_constructible<StorageT, R&>::value, int>::type = 0>
+    DI_FORCE_INLINE explicit DependencyInjected(R& resource)
+        : ObjectMemory(resource)
+    {
+        // Ensure that object memory state is the same in debug and release
+        ResetObjectMemory();
+    }
+
+    DI_FORCE_INLINE ~DependencyInjected()
     {
         // Catch never calling Shutdown() before object goes out of scope
-        DI_DEBUG_ASSERT(!IsInitialized());
+        DI_CHECK(!IsInitialized(), DependencyViolationKind::MissedShutdown, T,
+            "Destroyed without Shutdown()");
 
         Shutdown();
+
+        // Memory may be reused after the wrapper is gone
+        DI_ASAN_UNPOISON(ObjectMemory.Get(), LayoutT::Bytes);
     }
 
     DI_FORCE_INLINE T* operator->() const
     {
-        DI_DEBUG_ASSERT(IsInitialized()); // Object must be initialized before use
-        return Instance;
+        DI_CHECK(IsInitialized(), GetUseViolation(), T, "Object used before Initialize()");
+        return GetInstance();
     }
     DI_FORCE_INLINE T& operator*() const
     {
-        DI_DEBUG_ASSERT(IsInitialized()); // Object must be initialized before use
-        return *Instance;
+        DI_CHECK(IsInitialized(), GetUseViolation(), T, "Object used before Initialize()");
+        return *GetInstance();
     }
     DI_FORCE_INLINE T* GetObjectPtr()
     {
-        return reinterpret_cast<T*>(&ObjectMemory);
+        return reinterpret_cast<T*>(ObjectMemory.Get());
+    }
+
+    // Dependencies passed to SetDependencies()
+    DI_FORCE_INLINE const DepsT& GetDependencies() const
+    {
+        return Deps;
+    }
+    DI_FORCE_INLINE bool HasDependencies() const
+    {
+        return SetDeps;
     }
 
 protected:
     // Object instance
-    char ObjectMemory[sizeof(T)];
+    StorageT ObjectMemory;
     T* Instance = nullptr;
 
     // Dependencies for the object
     DepsT Deps;
     bool SetDeps = false;
 
+    DI_FORCE_INLINE void ResetObjectMemory()
+    {
+        DependencyDetail::ResetObjectMemory<LayoutT>(ObjectMemory.Get(), LayoutT::Bytes);
+    }
+
+    DI_FORCE_INLINE T* GetInstance() const
+    {
+#if defined(DI_DEBUG)
+        // A recorded violation carries on with the cleared object memory
+        // instead of a null pointer
+        if (!Instance)
+            return const_cast<DependencyInjected*>(this)->GetObjectPtr();
+#endif // DI_DEBUG
+        return Instance;
+    }
+
+#if defined(DI_DEBUG)
+    DI_FORCE_INLINE DependencyViolationKind GetInitializeViolation() const
+    {
+        return IsInitialized() ? DependencyViolationKind::InitializeTwice : DependencyViolationKind::InitializeWithoutDependencies;
+    }
+#endif // DI_DEBUG
+
     // Deleted methods
-    DependencyInjected(const DependencyInjected<T>&) = delete;
-    DependencyInjected<T>& operator=(DependencyInjected<T>&) = delete;
+    DependencyInjected(const DependencyInjected&) = delete;
+    DependencyInjected& operator=(const DependencyInjected&) = delete;
 };
 
 
 //------------------------------------------------------------------------------
-// OptionalDependency
+// Dependencies reflection
 //
-// Use this to specify an optional dependency in a Dependencies list.
+// Dependencies structs are aggregates, so their members can be enumerated
+// with structured bindings after counting how many initializers they take.
+// Up to DI_MAX_DEPENDENCY_MEMBERS members are supported.  Members must not
+// be aggregates themselves (brace elision would throw off the count).
 
-/*
-    Example:
+#define DI_MAX_DEPENDENCY_MEMBERS 16
 
-    struct Dependencies
-    {
-        RequiredDependency<Widget> widget;
+namespace DependencyDetail {
 
-        OptionalDependency<Widget> optionalWidget;
-    };
-*/
+template<class... Ts>
+struct TypeList
+{
+    static const size_t Size = sizeof...(Ts);
+};
 
-template<class T>
-class OptionalDependency
+// Converts to anything, only used in unevaluated contexts
+struct AnyMember
 {
-protected:
-    T* Reference;
-    IDependencyInjected* Wrapper;
+    template<class U>
+    operator U() const;
+};
 
-public:
-    virtual ~OptionalDependency() {}
+template<class D, class Seq, class = void>
+struct IsBraceConstructible : std::false_type {};
 
-    OptionalDependency()
-    {
-        Wrapper = nullptr;
-        Reference = nullptr;
-    }
-    OptionalDependency(T* reference)
-    {
-        Wrapper = nullptr;
-        Reference = reference;
-    }
-    template<class S>
-    OptionalDependency(DependencyInjected<S>& wrapper)
-    {
-        Wrapper = &wrapper;
-        if (Wrapper)
-        {
-            // Types must be convertible e.g. implementation to interface
-            Reference = wrapper.GetObjectPtr();
-        }
-        else
-            Reference = nullptr;
-    }
-    template<class S>
-    OptionalDependency(DependencyInjected<S>* wrapper)
-    {
-        Wrapper = wrapper;
-        if (Wrapper)
-        {
-            // Types must be convertible e.g. implementation to interface
-            Reference = wrapper->GetObjectPtr();
-        }
-        else
-            Reference = nullptr;
-    }
+template<class D, size_t... I>
+struct IsBraceConstructible<D, std::index_sequence<I...>,
+    decltype(void(D{ (void(I), AnyMember())... }))> : std::true_type {};
 
-    DI_FORCE_INLINE bool IsInitialized() const
-    {
-        // Verifies that reference is valid and that object is initialized
-        return Reference != nullptr && (Wrapper == nullptr || Wrapper->IsInitialized());
-    }
-    DI_FORCE_INLINE operator bool() const
-    {
-        return IsInitialized();
-    }
-    DI_FORCE_INLINE T* operator->() const
-    {
-        DI_DEBUG_ASSERT(IsInitialized()); // Object must be initialized before use
-        return Reference;
-    }
-    DI_FORCE_INLINE T& operator*() const
-    {
-        DI_DEBUG_ASSERT(IsInitialized()); // Object must be initialized before use
-        return *Reference;
+template<class D, size_t N = 0,
+    bool More = (N <= DI_MAX_DEPENDENCY_MEMBERS) &&
+        IsBraceConstructible<D, std::make_index_sequence<N + 1>>::value>
+struct MemberCount : MemberCount<D, N + 1> {};
+
+template<class D, size_t N>
+struct MemberCount<D, N, false> : std::integral_constant<size_t, N> {};
+
+template<size_t N>
+using SizeTag = std::integral_constant<size_t, N>;
+
+template<class D, class F>
+DI_FORCE_INLINE decltype(auto) VisitMembers(D&, F&& f, SizeTag<0>)
+{
+    return f();
+}
+
+#define DI_VISIT_MEMBERS_CASE(N, ...) \
+    template<class D, class F> \
+    DI_FORCE_INLINE decltype(auto) VisitMembers(D& d, F&& f, SizeTag<N>) \
+    { \
+        auto& [__VA_ARGS__] = d; \
+        return f(__VA_ARGS__); \
     }
-};
 
+DI_VISIT_MEMBERS_CASE(1, m0)
+DI_VISIT_MEMBERS_CASE(2, m0, m1)
+DI_VISIT_MEMBERS_CASE(3, m0, m1, m2)
+DI_VISIT_MEMBERS_CASE(4, m0, m1, m2, m3)
+DI_VISIT_MEMBERS_CASE(5, m0, m1, m2, m3, m4)
+DI_VISIT_MEMBERS_CASE(6, m0, m1, m2, m3, m4, m5)
+DI_VISIT_MEMBERS_CASE(7, m0, m1, m2, m3, m4, m5, m6)
+DI_VISIT_MEMBERS_CASE(8, m0, m1, m2, m3, m4, m5, m6, m7)
+DI_VISIT_MEMBERS_CASE(9, m0, m1, m2, m3, m4, m5, m6, m7, m8)
+DI_VISIT_MEMBERS_CASE(10, m0, m1, m2, m3, m4, m5, m6, m7, m8, m9)
+DI_VISIT_MEMBERS_CASE(11, m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10)
+DI_VISIT_MEMBERS_CASE(12, m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11)
+DI_VISIT_MEMBERS_CASE(13, m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12)
+DI_VISIT_MEMBERS_CASE(14, m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13)
+DI_VISIT_MEMBERS_CASE(15, m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14)
+DI_VISIT_MEMBERS_CASE(16, m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15)
+
+#undef DI_VISIT_MEMBERS_CASE
+
+// Invokes f(m0, m1, ...) with every member of the Dependencies struct
+template<class D, class F>
+DI_FORCE_INLINE decltype(auto) VisitMembers(D& deps, F&& f)
+{
+    typedef typename std::remove_cv<D>::type PlainD;
+    static_assert(std::is_aggregate<PlainD>::value,
+        "Dependencies must be an aggregate struct");
+    static_assert(MemberCount<PlainD>::value <= DI_MAX_DEPENDENCY_MEMBERS,
+        "Too many Dependencies members: Increase DI_MAX_DEPENDENCY_MEMBERS");
 
-//------------------------------------------------------------------------------
-// RequiredDependency
-//
-// Use this to specify a required dependency in a Dependencies list.
+    return VisitMembers(deps, std::forward<F>(f), SizeTag<MemberCount<PlainD>::value>());
+}
 
-/*
-    Example:
+struct MemberTypesFn
+{
+    template<class... M>
+    TypeList<typename std::remove_cv<M>::type...> operator()(M&...) const;
+};
 
-    struct Dependencies
-    {
-        RequiredDependency<Widget> widget;
+// TypeList of the member types of a Dependencies struct
+template<class D>
+using MemberTypes = decltype(VisitMembers(std::declval<D&>(), MemberTypesFn()));
 
-        OptionalDependency<Widget> optionalWidget;
-    };
-*/
+template<class F, class M>
+DI_FORCE_INLINE void ForEachDependencyMember(F& f, M& member)
+{
+    if constexpr (DependencyMemberTraits<typename std::remove_cv<M>::type>::IsDependency)
+        f(member);
+}
 
-template<class T>
-class RequiredDependency : public OptionalDependency<T>
+// Invokes f(member) for each dependency member, skipping other members
+template<class D, class F>
+DI_FORCE_INLINE void ForEachDependency(D& deps, F&& f)
 {
-public:
-    RequiredDependency()
-    {
-        Wrapper = nullptr;
-        Reference = nullptr;
-    }
-    RequiredDependency(T* reference)
-        : OptionalDependency<T>(reference)
+    VisitMembers(deps, [&f](auto&... members) {
+        (ForEachDependencyMember(f, members), ...);
+    });
+}
+
+template<class T, class C>
+DI_FORCE_INLINE bool IsBoundToStoppedWrapper(const OptionalDependency<T, C>& dep)
+{
+    return dep.IsWrapperDown();
+}
+template<class M>
+DI_FORCE_INLINE bool IsBoundToStoppedWrapper(const M&)
+{
+    return false;
+}
+
+template<class T, class C>
+DI_FORCE_INLINE void ClearIfBoundToStoppedWrapper(OptionalDependency<T, C>& dep)
+{
+    if (dep.IsWrapperDown())
+        dep = OptionalDependency<T, C>();
+}
+template<class M>
+DI_FORCE_INLINE void ClearIfBoundToStoppedWrapper(M&)
+{
+}
+
+// Invokes f(deps) with every OptionalDependency that is bound to a wrapper
+// that is not initialized cleared, so the consumer sees it as unset.
+// Resolves a copy, so deps keeps the binding for the next Initialize(),
+// unless the Dependencies cannot be copied.  LateBound<> members match the
+// generic overloads above and are left alone
+template<class D, class F>
+DI_FORCE_INLINE decltype(auto) InvokeWithLiveDependencies(D& deps, F&& f)
+{
+    bool stopped = false;
+    ForEachDependency(deps, [&stopped](const auto& dep) {
+        stopped |= IsBoundToStoppedWrapper(dep);
+    });
+
+    if (!stopped)
+        return f(deps);
+
+    if constexpr (std::is_copy_constructible<D>::value)
     {
-        DI_DEBUG_ASSERT(Reference != nullptr);
+        D live(deps);
+        ForEachDependency(live, [](auto& dep) { ClearIfBoundToStoppedWrapper(dep); });
+        return f(live);
     }
-    template<class S>
-    RequiredDependency(DependencyInjected<S>& wrapper)
-        : OptionalDependency<T>(wrapper)
+    else
     {
-        DI_DEBUG_ASSERT(Reference != nullptr);
+        ForEachDependency(deps, [](auto& dep) { ClearIfBoundToStoppedWrapper(dep); });
+        return f(deps);
     }
-    template<class S>
-    RequiredDependency(DependencyInjected<S>* wrapper)
-        : OptionalDependency<T>(wrapper)
+}
+
+// Members that can be set from a reference and its wrapper:
+// OptionalDependency and RequiredDependency, optionally LateBound<>
+template<class M, class = void>
+struct IsWirable : std::false_type {};
+
+template<class M>
+struct IsWirable<M, std::void_t<typename DependencyMemberTraits<M>::Type>>
+    : std::integral_constant<bool, DependencyMemberTraits<M>::IsDependency &&
+        std::is_constructible<M, typename DependencyMemberTraits<M>::Type*, IDependencyInjected*>::value>
+{
+};
+
+template<class M>
+struct MemberTag
+{
+    typedef M Type;
+};
+
+template<class D, class F, class... M>
+DI_FORCE_INLINE D BuildMembers(F& f, TypeList<M...>)
+{
+    return D{ f(MemberTag<M>())... };
+}
+
+// Builds a Dependencies struct from f(MemberTag<M>()) for each member type
+// M in order, e.g. to wire it from the providers known to a container
+template<class D, class F>
+DI_FORCE_INLINE D BuildDependencies(F&& f)
+{
+    return BuildMembers<D>(f, MemberTypes<D>());
+}
+
+// Calls f() and reports success, treating a void result as success
+template<class F>
+DI_FORCE_INLINE bool CallSucceeded(F&& f)
+{
+    typedef decltype(f()) R;
+
+    if constexpr (std::is_void<R>::value)
     {
-        DI_DEBUG_ASSERT(Reference != nullptr);
+        f();
+        return true;
     }
-};
+    else
+        return static_cast<bool>(f());
+}
+
+// Calls wrapper.Initialize() and reports success
+template<class W, class... Args>
+DI_FORCE_INLINE bool InvokeInitialize(W& wrapper, Args&&... args)
+{
+    return CallSucceeded([&]() -> decltype(auto) {
+        return wrapper.Initialize(std::forward<Args>(args)...);
+    });
+}
+
+} // namespace DependencyDetail
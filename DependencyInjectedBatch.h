@@ -0,0 +1,401 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    DependencyInjectedBatch
+
+    Thousands of identical small components stored as a structure of arrays,
+    e.g. one filter per stream in a filter bank.
+
+    The component type describes one instance with an aggregate Row struct
+    of scalar fields.  DependencyColumns<Row> stores each field of the Row in
+    its own cache-line aligned array, so a loop over one field across all
+    instances is contiguous and can be vectorized.  There is no wrapper
+    metadata between instances.
+
+    T is a single object that manages the whole batch:
+
+        T::Initialize(deps, columns, args...)
+            Sets up columns.GetCount() instances, e.g. from a span of
+            per-instance arguments passed through InitializeAll()
+        T::Shutdown()
+
+    Bulk operations are ordinary methods of T that loop over the columns.
+*/
+
+/*
+    Example Usage:
+
+
+    class FilterBank
+    {
+    public:
+        struct Dependencies
+        {
+        };
+
+        // One filter
+        struct Row
+        {
+            float Gain;
+            float State;
+        };
+
+        bool Initialize(const Dependencies& deps, DependencyColumns<Row>& rows, const float* gains)
+        {
+            Rows = &rows;
+            float* gain = rows.Column(&Row::Gain);
+            for (size_t i = 0; i < rows.GetCount(); ++i)
+                gain[i] = gains[i];
+            return true;
+        }
+        void Shutdown()
+        {
+        }
+
+        // Vectorizes: Walks two contiguous float arrays
+        void Process(const float* input)
+        {
+            float* DI_RESTRICT state = Rows->Column(&Row::State);
+            const float* DI_RESTRICT gain = Rows->Column(&Row::Gain);
+            for (size_t i = 0; i < Rows->GetCount(); ++i)
+                state[i] += gain[i] * input[i];
+        }
+
+    private:
+        DependencyColumns<Row>* Rows = nullptr;
+    };
+
+    DependencyInjectedBatch<FilterBank> filters(4096);
+
+    filters.SetDependencies({
+    });
+    filters.InitializeAll(gains.size(), gains.data());
+
+    filters->Process(samples);
+
+    filters.Shutdown();
+*/
+
+#include "DependencyInjected.h"
+
+#include <array>
+#include <tuple>
+#include <cstdint>
+
+// Compiler-specific restrict keyword, for bulk loops over columns
+#if defined(_MSC_VER)
+    #define DI_RESTRICT __restrict
+#else // _MSC_VER
+    #define DI_RESTRICT __restrict__
+#endif // _MSC_VER
+
+
+namespace DependencyDetail {
+
+template<class L>
+struct TypeListTuple;
+
+template<class... Ts>
+struct TypeListTuple<TypeList<Ts...>>
+{
+    typedef std::tuple<Ts...> Type;
+};
+
+template<class L>
+struct AllTriviallyCopyable;
+
+template<class... Ts>
+struct AllTriviallyCopyable<TypeList<Ts...>>
+    : std::integral_constant<bool, (std::is_trivially_copyable<Ts>::value && ...)> {};
+
+} // namespace DependencyDetail
+
+
+//------------------------------------------------------------------------------
+// DependencyColumns
+//
+// Structure of arrays for the members of an aggregate Row struct
+
+template<class Row>
+class DependencyColumns
+{
+public:
+    typedef DependencyDetail::MemberTypes<Row> MemberTypesT;
+    typedef typename DependencyDetail::TypeListTuple<MemberTypesT>::Type TupleT;
+
+    static const size_t ColumnCount = MemberTypesT::Size;
+
+    static_assert(ColumnCount > 0, "Row must have members");
+    static_assert(DependencyDetail::AllTriviallyCopyable<MemberTypesT>::value,
+        "Row members must be trivially copyable");
+
+    template<size_t I>
+    using ColumnT = typename std::tuple_element<I, TupleT>::type;
+
+    explicit DependencyColumns(size_t capacity)
+        : Capacity(capacity)
+    {
+        size_t bytes = 0;
+        ForEachColumnSize([&](size_t column, size_t elementBytes) {
+            Offsets[column] = bytes;
+            bytes += RoundUpToCacheLine(Capacity * elementBytes);
+        });
+        TotalBytes = bytes;
+
+        Memory = static_cast<unsigned char*>(
+            ::operator new(TotalBytes > 0 ? TotalBytes : 1, std::align_val_t(DI_CACHE_LINE_BYTES)));
+        Reset(0);
+    }
+    ~DependencyColumns()
+    {
+        ::operator delete(Memory, std::align_val_t(DI_CACHE_LINE_BYTES));
+    }
+
+    // Clears all columns and sets the number of rows in use
+    void Reset(size_t count)
+    {
+        DI_DEBUG_ASSERT(count <= Capacity);
+        memset(Memory, 0, TotalBytes);
+        Count = count;
+    }
+
+    DI_FORCE_INLINE size_t GetCount() const
+    {
+        return Count;
+    }
+    DI_FORCE_INLINE size_t GetCapacity() const
+    {
+        return Capacity;
+    }
+
+    // Column of the I-th member, aligned to DI_CACHE_LINE_BYTES
+    template<size_t I>
+    DI_FORCE_INLINE ColumnT<I>* Column() const
+    {
+        static_assert(I < ColumnCount, "Column index out of range");
+        return reinterpret_cast<ColumnT<I>*>(Memory + Offsets[I]);
+    }
+
+    // Column of a member, e.g. Column(&Row::Gain)
+    template<class M>
+    DI_FORCE_INLINE M* Column(M Row::* member) const
+    {
+        return reinterpret_cast<M*>(Memory + Offsets[MemberIndex(member)]);
+    }
+
+    // Gathers one instance from the columns
+    Row GetRow(size_t index) const
+    {
+        DI_DEBUG_ASSERT(index < Count);
+
+        Row row{};
+        DependencyDetail::VisitMembers(row, [&](auto&... members) {
+            size_t column = 0;
+            ((members = ColumnAs<decltype(members)>(column++)[index]), ...);
+        });
+        return row;
+    }
+
+    // Scatters one instance into the columns
+    void SetRow(size_t index, const Row& row)
+    {
+        DI_DEBUG_ASSERT(index < Count);
+
+        DependencyDetail::VisitMembers(row, [&](const auto&... members) {
+            size_t column = 0;
+            ((ColumnAs<decltype(members)>(column++)[index] = members), ...);
+        });
+    }
+
+protected:
+    unsigned char* Memory = nullptr;
+    size_t TotalBytes = 0;
+    size_t Capacity = 0;
+    size_t Count = 0;
+
+    // Byte offset of each column in Memory
+    std::array<size_t, ColumnCount> Offsets;
+
+    static size_t RoundUpToCacheLine(size_t bytes)
+    {
+        return (bytes + DI_CACHE_LINE_BYTES - 1) / DI_CACHE_LINE_BYTES * DI_CACHE_LINE_BYTES;
+    }
+
+    template<class F>
+    static void ForEachColumnSize(F&& f)
+    {
+        Row probe{};
+        DependencyDetail::VisitMembers(probe, [&](auto&... members) {
+            size_t column = 0;
+            (f(column++, sizeof(members)), ...);
+        });
+    }
+
+    // Finds the column of a member by its address in a probe Row
+    template<class M>
+    static size_t MemberIndex(M Row::* member)
+    {
+        Row probe{};
+        const void* target = &(probe.*member);
+
+        size_t index = ColumnCount;
+        DependencyDetail::VisitMembers(probe, [&](auto&... members) {
+            size_t column = 0;
+            ((index = (static_cast<const void*>(&members) == target) ? column : index, ++column), ...);
+        });
+
+        DI_DEBUG_ASSERT(index < ColumnCount);
+        return index;
+    }
+
+    template<class MemberRef>
+    DI_FORCE_INLINE typename std::decay<MemberRef>::type* ColumnAs(size_t column) const
+    {
+        return reinterpret_cast<typename std::decay<MemberRef>::type*>(Memory + Offsets[column]);
+    }
+
+    // Deleted methods
+    DependencyColumns(const DependencyColumns&) = delete;
+    DependencyColumns& operator=(const DependencyColumns&) = delete;
+};
+
+
+//------------------------------------------------------------------------------
+// DependencyInjectedBatch
+
+template<class T>
+class DependencyInjectedBatch : public IDependencyInjected
+{
+public:
+    typedef typename T::Dependencies DepsT;
+    typedef typename T::Row RowT;
+    typedef DependencyColumns<RowT> ColumnsT;
+
+    explicit DependencyInjectedBatch(size_t capacity)
+        : Columns(capacity)
+    {
+    }
+    ~DependencyInjectedBatch()
+    {
+        // Catch never calling Shutdown() before batch goes out of scope
+        DI_DEBUG_ASSERT(!IsInitialized());
+
+        Shutdown();
+    }
+
+    // Set dependencies shared by all instances
+    DI_FORCE_INLINE void SetDependencies(const DepsT& deps)
+    {
+        // Catch setting dependencies after InitializeAll() in debug mode
+        DI_DEBUG_ASSERT(!IsInitialized());
+
+        Deps = deps;
+        SetDeps = true;
+        DI_COUNT_EDGES(T, Deps);
+    }
+
+    // Initialize count instances with one call to
+    // T::Initialize(deps, columns, args...)
+    template<typename... Args>
+    auto InitializeAll(size_t count, Args&&... args)
+    {
+        // Catch double-initialization in debug mode
+        DI_DEBUG_ASSERT(SetDeps && !IsInitialized());
+
+        DI_TRACE_SCOPE(trace, "Initialize", T, GetObjectPtr());
+        DI_TRACE_EDGES(trace, Deps);
+
+        Initialized = true;
+
+        // Rows start zeroed like the object memory of DependencyInjected<T>
+        Columns.Reset(count);
+        Instance = new (ObjectMemory)T();
+
+        return DependencyDetail::InvokeWithLiveDependencies(Deps, [&](DepsT& deps) -> decltype(auto) {
+            return Instance->Initialize(deps, Columns, std::forward<Args>(args)...);
+        });
+    }
+
+    // Shutdown all instances
+    template<typename... Args>
+    void Shutdown(Args&&... args)
+    {
+        if (Instance)
+        {
+            DI_TRACE_SCOPE(trace, "Shutdown", T, GetObjectPtr());
+
+            Instance->Shutdown(std::forward<Args>(args)...);
+            Instance->~T();
+            Instance = nullptr;
+
+            Columns.Reset(0);
+            Initialized = false;
+        }
+    }
+
+    DI_FORCE_INLINE T* operator->() const
+    {
+        DI_DEBUG_ASSERT(IsInitialized()); // Object must be initialized before use
+        return Instance;
+    }
+    DI_FORCE_INLINE T& operator*() const
+    {
+        DI_DEBUG_ASSERT(IsInitialized()); // Object must be initialized before use
+        return *Instance;
+    }
+    DI_FORCE_INLINE T* GetObjectPtr()
+    {
+        return reinterpret_cast<T*>(ObjectMemory);
+    }
+
+    DI_FORCE_INLINE ColumnsT& GetColumns()
+    {
+        return Columns;
+    }
+    DI_FORCE_INLINE size_t GetCount() const
+    {
+        return Columns.GetCount();
+    }
+
+protected:
+    ColumnsT Columns;
+
+    alignas(T) unsigned char ObjectMemory[sizeof(T)];
+    T* Instance = nullptr;
+
+    DepsT Deps;
+    bool SetDeps = false;
+
+    // Deleted methods
+    DependencyInjectedBatch(const DependencyInjectedBatch&) = delete;
+    DependencyInjectedBatch& operator=(const DependencyInjectedBatch&) = delete;
+};
@@ -0,0 +1,96 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+/*
+    DependencyInjectedFwd
+
+    Forward declarations of the DependencyInjected types.
+
+    Include this instead of DependencyInjected.h in headers that only pass
+    wrappers and dependencies around by pointer or reference, or that bind
+    interfaces with DI_BIND_IMPLEMENTATION.  Headers that declare a
+    Dependencies struct include DependencyMembers.h, and only the source
+    files that own a DependencyInjected<T> need DependencyInjected.h.
+
+    The default template arguments are given here, so this is the one place
+    they are declared, along with the DependencyBinding they default to.
+*/
+
+/*
+    Example Usage:
+
+
+    // WidgetFactory.h
+    #include "DependencyInjectedFwd.h"
+
+    class Widget;
+
+    void RegisterWidget(DependencyInjected<Widget>& widget);
+*/
+
+
+// Marks the public API for the C++20 module in DependencyInjected.cppm,
+// and expands to nothing when the headers are included
+#if !defined(DI_EXPORT)
+    #define DI_EXPORT
+#endif // DI_EXPORT
+
+DI_EXPORT class IDependencyInjected;
+
+DI_EXPORT template<class T, class... Policies>
+class DependencyInjected;
+
+// Policies
+DI_EXPORT struct CacheLineAligned;
+DI_EXPORT struct FastReset;
+DI_EXPORT struct HeapStorage;
+DI_EXPORT struct ArenaStorage;
+
+// Defined here so the default arguments below can be named without
+// DependencyMembers.h
+DI_EXPORT template<class T>
+struct DependencyBinding
+{
+    typedef T Type;
+};
+
+DI_EXPORT template<class T, class C = typename DependencyBinding<T>::Type>
+class OptionalDependency;
+
+DI_EXPORT template<class T, class C = typename DependencyBinding<T>::Type>
+class RequiredDependency;
+
+DI_EXPORT template<class D>
+class LateBound;
+
+// Binds an interface to its implementation, see DependencyBinding.
+// Must be used at global scope
+#define DI_BIND_IMPLEMENTATION(Interface, Implementation) \
+    template<> struct DependencyBinding<Interface> { typedef Implementation Type; }
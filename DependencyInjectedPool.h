@@ -0,0 +1,286 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    DependencyInjectedPool
+
+    Many instances of the same object type, e.g. one per client connection.
+
+    All objects live contiguously in one slab that is allocated once, share
+    a single Dependencies block, and have their liveness tracked in a bitmap.
+    Acquire() and Release() are O(1) and run T::Initialize()/T::Shutdown(),
+    so slots are recycled without reallocation and iterating over the live
+    objects walks memory in order.
+
+    Not thread-safe: Acquire() and Release() must be serialized, like
+    Initialize() and Shutdown() on a DependencyInjected<> wrapper.
+*/
+
+/*
+    Example Usage:
+
+
+    DependencyInjectedPool<Session> sessions(1000);
+
+    sessions.SetDependencies({
+        server
+    });
+
+    Session* session = sessions.Acquire(clientId);
+    if (session)
+    {
+        session->OnData(data, bytes);
+
+        sessions.Release(session);
+    }
+
+    sessions.ForEach([](Session& s) {
+        s.OnTick();
+    });
+*/
+
+#include "DependencyInjected.h"
+
+#include <vector>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif // _MSC_VER
+
+
+namespace DependencyDetail {
+
+// Index of the lowest set bit.  x must not be zero
+DI_FORCE_INLINE unsigned LowestBitIndex(uint64_t x)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    #if defined(_WIN64)
+        _BitScanForward64(&index, x);
+    #else // _WIN64
+        if (_BitScanForward(&index, static_cast<unsigned long>(x)))
+            return index;
+        _BitScanForward(&index, static_cast<unsigned long>(x >> 32));
+        index += 32;
+    #endif // _WIN64
+    return index;
+#else // _MSC_VER
+    return static_cast<unsigned>(__builtin_ctzll(x));
+#endif // _MSC_VER
+}
+
+} // namespace DependencyDetail
+
+
+//------------------------------------------------------------------------------
+// DependencyInjectedPool
+
+template<class T, class... Policies>
+class DependencyInjectedPool
+{
+public:
+    typedef typename T::Dependencies DepsT;
+    typedef DependencyDetail::StorageLayout<T, Policies...> LayoutT;
+
+    explicit DependencyInjectedPool(size_t capacity)
+        : Capacity(capacity)
+    {
+        Slab = static_cast<unsigned char*>(
+            ::operator new(Capacity * LayoutT::Bytes, std::align_val_t(LayoutT::Alignment)));
+
+        LiveBits.resize((Capacity + 63) / 64, 0);
+
+        // Hand out low indices first so live objects stay packed together
+        FreeList.resize(Capacity);
+        for (size_t i = 0; i < Capacity; ++i)
+            FreeList[i] = Capacity - 1 - i;
+
+        for (size_t i = 0; i < Capacity; ++i)
+            ResetSlot(i);
+    }
+
+    ~DependencyInjectedPool()
+    {
+        // Catch never calling Release() before pool goes out of scope
+        DI_DEBUG_ASSERT(LiveCount == 0);
+
+        ForEachIndex([this](size_t i) {
+            Release(GetSlot(i));
+        });
+
+        DI_ASAN_UNPOISON(Slab, Capacity * LayoutT::Bytes);
+        ::operator delete(Slab, std::align_val_t(LayoutT::Alignment));
+    }
+
+    // Set dependencies shared by all objects in the pool
+    void SetDependencies(const DepsT& deps)
+    {
+        // Catch setting dependencies while objects are live in debug mode
+        DI_DEBUG_ASSERT(LiveCount == 0);
+
+        Deps = deps;
+        SetDeps = true;
+        DI_COUNT_EDGES(T, Deps);
+    }
+
+    // Construct and initialize an object in a free slot.
+    // Returns nullptr if the pool is full or T::Initialize() fails
+    template<typename... Args>
+    T* Acquire(Args&&... args)
+    {
+        // Catch forgetting SetDependencies() in debug mode
+        DI_DEBUG_ASSERT(SetDeps);
+
+        if (FreeList.empty())
+            return nullptr;
+
+        const size_t index = FreeList.back();
+        FreeList.pop_back();
+        LiveBits[index / 64] |= uint64_t(1) << (index % 64);
+        ++LiveCount;
+
+        unsigned char* memory = Slab + index * LayoutT::Bytes;
+        DI_ASAN_UNPOISON(memory, LayoutT::Bytes);
+        T* instance = new (memory)T();
+
+        const bool success = DependencyDetail::CallSucceeded([&]() -> decltype(auto) {
+            return DependencyDetail::InvokeWithLiveDependencies(Deps, [&](DepsT& deps) -> decltype(auto) {
+                return instance->Initialize(deps, std::forward<Args>(args)...);
+            });
+        });
+
+        if (!success)
+        {
+            Release(instance);
+            return nullptr;
+        }
+
+        return instance;
+    }
+
+    // Shutdown and destroy an object returned by Acquire()
+    template<typename... Args>
+    void Release(T* instance, Args&&... args)
+    {
+        const size_t index = GetIndex(instance);
+
+        // Catch releasing an object that is not live in debug mode
+        DI_DEBUG_ASSERT(index < Capacity && IsLive(index));
+
+        instance->Shutdown(std::forward<Args>(args)...);
+        instance->~T();
+
+        ResetSlot(index);
+
+        LiveBits[index / 64] &= ~(uint64_t(1) << (index % 64));
+        --LiveCount;
+        FreeList.push_back(index);
+    }
+
+    // Invoke f(T&) for each live object in slot order
+    template<class F>
+    void ForEach(F&& f)
+    {
+        ForEachIndex([this, &f](size_t i) {
+            f(*GetSlot(i));
+        });
+    }
+
+    DI_FORCE_INLINE bool IsLive(size_t index) const
+    {
+        return (LiveBits[index / 64] >> (index % 64)) & 1;
+    }
+    DI_FORCE_INLINE size_t GetIndex(const T* instance) const
+    {
+        return static_cast<size_t>(reinterpret_cast<const unsigned char*>(instance) - Slab) / LayoutT::Bytes;
+    }
+    DI_FORCE_INLINE T* GetObjectPtr(size_t index) const
+    {
+        DI_DEBUG_ASSERT(index < Capacity && IsLive(index)); // Object must be initialized before use
+        return GetSlot(index);
+    }
+
+    DI_FORCE_INLINE size_t GetLiveCount() const
+    {
+        return LiveCount;
+    }
+    DI_FORCE_INLINE size_t GetCapacity() const
+    {
+        return Capacity;
+    }
+
+protected:
+    // Objects are LayoutT::Bytes apart in one allocation
+    unsigned char* Slab = nullptr;
+    size_t Capacity = 0;
+    size_t LiveCount = 0;
+
+    // Set bit = live object in that slot
+    std::vector<uint64_t> LiveBits;
+
+    // Stack of free slot indices
+    std::vector<size_t> FreeList;
+
+    // Dependencies shared by all objects
+    DepsT Deps;
+    bool SetDeps = false;
+
+    DI_FORCE_INLINE T* GetSlot(size_t index) const
+    {
+        return reinterpret_cast<T*>(Slab + index * LayoutT::Bytes);
+    }
+
+    DI_FORCE_INLINE void ResetSlot(size_t index)
+    {
+        DependencyDetail::ResetObjectMemory<LayoutT>(Slab + index * LayoutT::Bytes, LayoutT::Bytes);
+    }
+
+    template<class F>
+    void ForEachIndex(F&& f)
+    {
+        const size_t words = LiveBits.size();
+        for (size_t w = 0; w < words; ++w)
+        {
+            uint64_t bits = LiveBits[w];
+            while (bits)
+            {
+                const size_t bit = DependencyDetail::LowestBitIndex(bits);
+                bits &= bits - 1;
+                f(w * 64 + bit);
+            }
+        }
+    }
+
+    // Deleted methods
+    DependencyInjectedPool(const DependencyInjectedPool&) = delete;
+    DependencyInjectedPool& operator=(const DependencyInjectedPool&) = delete;
+};
@@ -0,0 +1,755 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+/*
+    DependencyMembers
+
+    Everything a Dependencies struct needs: OptionalDependency,
+    RequiredDependency, LateBound and DependencyBinding, with the usage
+    checks they share with DependencyInjected.h.
+
+    A component header includes this one instead of DependencyInjected.h,
+    and its dependencies can be forward declared: A member only holds a
+    pointer, so the dependency type must be complete only where it is used
+    through operator-> or wired up from its wrapper.  The wrapper storage,
+    policies and Dependencies reflection stay in DependencyInjected.h, which
+    only the source files that own or initialize wrappers include.  That
+    keeps an edit to Cog.h from rebuilding every file that includes
+    Widget.h.
+*/
+
+/*
+    Example Usage:
+
+
+    // Widget.h
+    #include "DependencyMembers.h"
+
+    class Cog;
+
+    class Widget
+    {
+    public:
+        struct Dependencies
+        {
+            RequiredDependency<Cog> cog;
+        };
+
+        void Initialize(const Dependencies& deps);
+        void Shutdown();
+
+    private:
+        Dependencies Deps;
+    };
+
+    // Widget.cpp
+    #include "Widget.h"
+    #include "Cog.h"
+
+    void Widget::Initialize(const Dependencies& deps)
+    {
+        Deps = deps;
+        Deps.cog->DoCogThing();
+    }
+
+    // App.cpp
+    #include "DependencyInjected.h"
+    #include "Widget.h"
+    #include "Cog.h"
+
+    DependencyInjected<Cog> cog;
+    DependencyInjected<Widget> widget;
+*/
+
+#include "DependencyInjectedFwd.h"
+
+#include <type_traits>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+
+//------------------------------------------------------------------------------
+// Portability macros
+
+// Compiler-specific debug break
+#if defined(_DEBUG) || defined(DEBUG)
+    #define DI_DEBUG
+    #if defined(_WIN32)
+        #define DI_DEBUG_BREAK() __debugbreak()
+    #else // _WIN32
+        #define DI_DEBUG_BREAK() __builtin_trap()
+    #endif // _WIN32
+    #define DI_DEBUG_ASSERT(cond) { if (!(cond)) { DI_DEBUG_BREAK(); } }
+#else // _DEBUG
+    #define DI_DEBUG_BREAK() do {} while (false);
+    #define DI_DEBUG_ASSERT(cond) do {} while (false);
+#endif // _DEBUG
+
+// Sanitizer builds
+#if defined(__has_feature)
+    #if __has_feature(address_sanitizer)
+        #define DI_ASAN
+    #endif
+    #if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer) || __has_feature(thread_sanitizer)
+        #define DI_SANITIZER
+    #endif
+#endif // __has_feature
+#if defined(__SANITIZE_ADDRESS__)
+    #define DI_ASAN
+#endif
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+    #define DI_SANITIZER
+#endif
+
+#if defined(DI_ASAN) && !defined(DI_SANITIZER)
+    #define DI_SANITIZER
+#endif
+
+#if defined(DI_ASAN)
+    #include <sanitizer/asan_interface.h>
+    #define DI_ASAN_POISON(ptr, bytes) ASAN_POISON_MEMORY_REGION(ptr, bytes)
+    #define DI_ASAN_UNPOISON(ptr, bytes) ASAN_UNPOISON_MEMORY_REGION(ptr, bytes)
+#else // DI_ASAN
+    #define DI_ASAN_POISON(ptr, bytes) do {} while (false);
+    #define DI_ASAN_UNPOISON(ptr, bytes) do {} while (false);
+#endif // DI_ASAN
+
+// Byte pattern written over object memory by FastReset in sanitizer builds
+#if !defined(DI_POISON_BYTE)
+    #define DI_POISON_BYTE 0xDD
+#endif // DI_POISON_BYTE
+
+// Cache line size used for padding
+#if !defined(DI_CACHE_LINE_BYTES)
+    #define DI_CACHE_LINE_BYTES 64
+#endif // DI_CACHE_LINE_BYTES
+
+// Compiler-specific force inline keyword
+#if defined(_MSC_VER)
+    #define DI_FORCE_INLINE inline __forceinline
+#else // _MSC_VER
+    #define DI_FORCE_INLINE inline __attribute__((always_inline))
+#endif // _MSC_VER
+
+// Branch hints for checks that are expected to pass
+#if defined(_MSC_VER)
+    #define DI_UNLIKELY(cond) (cond)
+    #define DI_COLD __declspec(noinline)
+#else // _MSC_VER
+    #define DI_UNLIKELY(cond) __builtin_expect(!!(cond), 0)
+    #define DI_COLD __attribute__((cold, noinline))
+#endif // _MSC_VER
+
+// Return address of the current function, for the violation log
+#if defined(DI_DEBUG)
+    #include "DependencyTypeName.h" // GetTypeName()
+
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define DI_RETURN_ADDRESS() _ReturnAddress()
+    #else // _MSC_VER
+        #define DI_RETURN_ADDRESS() __builtin_return_address(0)
+    #endif // _MSC_VER
+#endif // DI_DEBUG
+
+// Usage checks:
+// Debug builds trap, or record the violation while a DependencyViolationLog
+// is enabled.  DI_HARDENED release builds keep the checks as predicted
+// branches into a cold call to the violation handler.  Other release builds
+// compile them out.  The kind and type are only evaluated for the log
+#if defined(DI_DEBUG)
+    #define DI_CHECK(cond, kind, T, message) { if (DI_UNLIKELY(!(cond))) { \
+        if (!DependencyDetail::TrackViolation<T>(kind, message, __FILE__, __LINE__)) { DI_DEBUG_BREAK(); } } }
+#elif defined(DI_HARDENED)
+    #define DI_CHECK(cond, kind, T, message) { if (DI_UNLIKELY(!(cond))) { DependencyDetail::ReportViolation(message, __FILE__, __LINE__); } }
+#else // DI_HARDENED
+    #define DI_CHECK(cond, kind, T, message) do {} while (false);
+#endif // DI_HARDENED
+
+// Checked builds also keep a pointer to the wrapper in each
+// RequiredDependency, to catch its use before Initialize().  In other
+// release builds it is a single pointer
+#if defined(DI_DEBUG) || defined(DI_HARDENED)
+    #define DI_DEPENDENCY_WRAPPER
+#endif // DI_DEBUG || DI_HARDENED
+
+// Startup/shutdown tracing, see DependencyTrace.h
+#if defined(DI_TRACE)
+    #include "DependencyTrace.h"
+    #define DI_TRACE_SCOPE(scope, phase, T, object) \
+        DependencyTraceScope scope(phase, DependencyDetail::GetTypeName<T>(), object, sizeof(T));
+    #define DI_TRACE_EDGES(scope, deps) \
+        DependencyDetail::ForEachDependency(deps, [&scope](const auto& dep) { scope.AddEdge(dep.Get()); });
+#else // DI_TRACE
+    #define DI_TRACE_SCOPE(scope, phase, T, object) do {} while (false);
+    #define DI_TRACE_EDGES(scope, deps) do {} while (false);
+#endif // DI_TRACE
+
+// Per-edge access counters, see DependencyAccessCounters.h
+#if defined(DI_COUNT_ACCESSES)
+    #include "DependencyAccessCounters.h"
+    #define DI_COUNT_EDGES(T, deps) \
+        DependencyDetail::ForEachDependency(deps, [](auto& dep) { DependencyDetail::AssignAccessEdge<T>(dep); });
+    #define DI_COUNT_ACCESS(edge) DependencyDetail::CountAccess(edge);
+#else // DI_COUNT_ACCESSES
+    #define DI_COUNT_EDGES(T, deps) do {} while (false);
+    #define DI_COUNT_ACCESS(edge) do {} while (false);
+#endif // DI_COUNT_ACCESSES
+
+
+//------------------------------------------------------------------------------
+// Violation handler
+//
+// Called when a DI_CHECK fails in a DI_HARDENED build.  The default handler
+// prints the message and aborts.  A custom handler may log and throw, but it
+// cannot resume: if it returns, abort() is called.  Not returning is what
+// lets the compiler hoist the checks out of loops.
+
+/*
+    Example:
+
+    SetDependencyViolationHandler([](const char* message, const char* file, int line) {
+        LogError("%s at %s:%d", message, file, line);
+        throw std::logic_error(message);
+    });
+*/
+
+DI_EXPORT typedef void (*DependencyViolationHandler)(const char* message, const char* file, int line);
+
+DI_EXPORT enum class DependencyViolationKind : uint8_t
+{
+    SetDependenciesAfterInitialize,
+    InitializeTwice,
+    InitializeWithoutDependencies,
+    InitializeOutsideScope,
+    UseBeforeInitialize,
+    UseAfterShutdown,
+    DependencyNotSet,
+    RequiredDependencyNull,
+    MissedShutdown,
+
+    Count
+};
+
+namespace DependencyDetail {
+
+inline void DefaultViolationHandler(const char* message, const char* file, int line)
+{
+    fprintf(stderr, "DependencyInjected violation: %s (%s:%d)\n", message, file, line);
+    abort();
+}
+
+inline std::atomic<DependencyViolationHandler>& GetViolationHandler()
+{
+    static std::atomic<DependencyViolationHandler> handler{ &DefaultViolationHandler };
+    return handler;
+}
+
+// Out of line so the checks cost one predicted branch at each call site
+[[noreturn]] DI_COLD inline void ReportViolation(const char* message, const char* file, int line)
+{
+    GetViolationHandler().load(std::memory_order_acquire)(message, file, line);
+    abort();
+}
+
+} // namespace DependencyDetail
+
+#if defined(DI_DEBUG)
+namespace DependencyDetail {
+
+// Installed by DependencyViolationLog.h, so this header does not include
+// the log.  Returns false to trap
+typedef bool (*ViolationTracker)(DependencyViolationKind kind, const char* typeName,
+    const char* message, const char* file, int line, const void* callSite);
+
+inline std::atomic<ViolationTracker>& GetViolationTracker()
+{
+    static std::atomic<ViolationTracker> tracker{ nullptr };
+    return tracker;
+}
+
+// Out of line, so the return address is in the function with the failed
+// check.  Traps unless a DependencyViolationLog is enabled
+template<class T>
+DI_COLD bool TrackViolation(DependencyViolationKind kind, const char* message, const char* file, int line)
+{
+    const ViolationTracker tracker = GetViolationTracker().load(std::memory_order_acquire);
+    return tracker && tracker(kind, GetTypeName<T>(), message, file, line, DI_RETURN_ADDRESS());
+}
+
+} // namespace DependencyDetail
+#endif // DI_DEBUG
+
+// Returns the previous handler.  nullptr restores the default handler
+DI_EXPORT inline DependencyViolationHandler SetDependencyViolationHandler(DependencyViolationHandler handler)
+{
+    return DependencyDetail::GetViolationHandler().exchange(
+        handler ? handler : &DependencyDetail::DefaultViolationHandler);
+}
+
+
+//------------------------------------------------------------------------------
+// IDependencyInjected
+//
+// Base of every DependencyInjected<T> wrapper
+
+// Non-virtual: Wrappers are never destroyed through this base, so neither
+// the wrappers nor the dependencies that point at them carry a vtable
+class IDependencyInjected
+{
+public:
+    DI_FORCE_INLINE operator bool() const
+    {
+        return IsInitialized();
+    }
+    DI_FORCE_INLINE bool IsInitialized() const
+    {
+        return Initialized;
+    }
+
+#if defined(DI_DEBUG)
+    DI_FORCE_INLINE DependencyViolationKind GetUseViolation() const
+    {
+        return WasShutdown ? DependencyViolationKind::UseAfterShutdown : DependencyViolationKind::UseBeforeInitialize;
+    }
+#endif // DI_DEBUG
+
+protected:
+    bool Initialized = false;
+#if defined(DI_DEBUG)
+    // Tells use-after-Shutdown() apart from use-before-Initialize()
+    bool WasShutdown = false;
+#endif // DI_DEBUG
+
+    ~IDependencyInjected() = default;
+};
+
+namespace DependencyDetail {
+
+// Stands in for the wrapper of a dependency that has none, so the wrapper
+// a dependency keeps is never null.  Unset() is never initialized and is
+// kept with a null reference.  Unbound() is always initialized and is kept
+// with a reference that was set without its wrapper
+class SentinelWrapper : public IDependencyInjected
+{
+public:
+    explicit constexpr SentinelWrapper(bool initialized)
+    {
+        Initialized = initialized;
+    }
+
+    static IDependencyInjected* Unset()
+    {
+        static SentinelWrapper wrapper(false);
+        return &wrapper;
+    }
+    static IDependencyInjected* Unbound()
+    {
+        static SentinelWrapper wrapper(true);
+        return &wrapper;
+    }
+};
+
+} // namespace DependencyDetail
+
+
+//------------------------------------------------------------------------------
+// DependencyBinding
+//
+// Binds an interface to the one implementation used by a build so calls
+// through RequiredDependency<I> and OptionalDependency<I> are direct and
+// can be inlined.  Declare bindings in one header that every translation
+// unit includes before it uses the interface, and leave them out of test
+// builds that inject mocks.  Mark the implementation final so the
+// compiler can devirtualize its methods.
+//
+// A single dependency can also be bound explicitly with
+// RequiredDependency<IMyInterface, MyImplementation>.
+//
+// Debug builds check that each bound reference really is the implementation.
+
+/*
+    Example:
+
+    class MyImplementation final : public IMyInterface { ... };
+
+    DI_BIND_IMPLEMENTATION(IMyInterface, MyImplementation);
+*/
+
+// DependencyBinding<T> and DI_BIND_IMPLEMENTATION are defined in
+// DependencyInjectedFwd.h
+
+namespace DependencyDetail {
+
+// Converts an interface reference to its bound implementation
+template<class C, class T>
+DI_FORCE_INLINE C* BindReference(T* reference)
+{
+    static_assert(std::is_same<T, C>::value || std::is_base_of<T, C>::value,
+        "Bound implementation must derive from the interface");
+
+#if defined(DI_DEBUG)
+    if constexpr (!std::is_same<T, C>::value && std::is_polymorphic<T>::value)
+    {
+        // Catch binding to the wrong implementation e.g. a mock in debug mode
+        DI_DEBUG_ASSERT(reference == nullptr || dynamic_cast<C*>(reference) != nullptr);
+    }
+#endif // DI_DEBUG
+
+    return static_cast<C*>(reference);
+}
+
+} // namespace DependencyDetail
+
+
+//------------------------------------------------------------------------------
+// DependencyReference
+//
+// Common part of OptionalDependency and RequiredDependency
+
+namespace DependencyDetail {
+
+// Wrapper the reference was bound to, or a SentinelWrapper.  Empty where it
+// is not kept, so the dependency collapses to a single pointer
+template<bool Keep>
+class DependencyWrapperSlot
+{
+public:
+    DI_FORCE_INLINE IDependencyInjected* GetWrapper() const
+    {
+        return Wrapper;
+    }
+
+protected:
+    IDependencyInjected* Wrapper;
+
+    DI_FORCE_INLINE void SetWrapper(const void* reference, IDependencyInjected* wrapper)
+    {
+        if (!reference)
+            Wrapper = SentinelWrapper::Unset();
+        else
+            Wrapper = wrapper ? wrapper : SentinelWrapper::Unbound();
+    }
+};
+
+template<>
+class DependencyWrapperSlot<false>
+{
+public:
+    DI_FORCE_INLINE IDependencyInjected* GetWrapper() const
+    {
+        return nullptr;
+    }
+
+protected:
+    DI_FORCE_INLINE void SetWrapper(const void*, IDependencyInjected*)
+    {
+    }
+};
+
+template<class T, class C, bool KeepWrapper>
+class DependencyReference : public DependencyWrapperSlot<KeepWrapper>
+{
+public:
+    // Type that calls are made through
+    typedef C BoundT;
+
+    DI_FORCE_INLINE bool IsInitialized() const
+    {
+        return Reference != nullptr;
+    }
+    DI_FORCE_INLINE operator bool() const
+    {
+        return IsInitialized();
+    }
+    DI_FORCE_INLINE C* operator->() const
+    {
+        CheckUse();
+        DI_COUNT_ACCESS(AccessEdge);
+        return BindReference<C>(Reference);
+    }
+    DI_FORCE_INLINE C& operator*() const
+    {
+        CheckUse();
+        DI_COUNT_ACCESS(AccessEdge);
+        return *BindReference<C>(Reference);
+    }
+
+    // Referenced object without the initialization check
+    DI_FORCE_INLINE T* Get() const
+    {
+        return Reference;
+    }
+
+#if defined(DI_COUNT_ACCESSES)
+    // Called by SetDependencies() of the consumer
+    void AssignAccessEdge(const char* consumerType)
+    {
+        AccessEdge = RegisterAccessEdge(consumerType, GetTypeName<T>());
+    }
+#endif // DI_COUNT_ACCESSES
+
+protected:
+    T* Reference;
+#if defined(DI_COUNT_ACCESSES)
+    uint32_t AccessEdge;
+#endif // DI_COUNT_ACCESSES
+
+    DI_FORCE_INLINE void Bind(T* reference, IDependencyInjected* wrapper)
+    {
+        this->SetWrapper(reference, wrapper);
+        Reference = reference;
+#if defined(DI_COUNT_ACCESSES)
+        AccessEdge = 0;
+#endif // DI_COUNT_ACCESSES
+    }
+
+    DI_FORCE_INLINE void CheckUse() const
+    {
+#if defined(DI_DEPENDENCY_WRAPPER)
+        // Checked builds also catch using an object after its wrapper was
+        // shut down, or before it was initialized.  An unset dependency
+        // keeps SentinelWrapper::Unset(), so one branch tests for both
+        const IDependencyInjected* wrapper = this->GetWrapper();
+        DI_CHECK(wrapper->IsInitialized(),
+            Reference == nullptr ? DependencyViolationKind::DependencyNotSet : wrapper->GetUseViolation(), T,
+            "Dependency used before it was set or initialized");
+#else // DI_DEPENDENCY_WRAPPER
+        DI_CHECK(IsInitialized(), DependencyViolationKind::DependencyNotSet, T,
+            "Dependency used before it was set or initialized");
+#endif // DI_DEPENDENCY_WRAPPER
+    }
+};
+
+#if defined(DI_DEPENDENCY_WRAPPER)
+    inline constexpr bool KeepRequiredWrapper = true;
+#else // DI_DEPENDENCY_WRAPPER
+    inline constexpr bool KeepRequiredWrapper = false;
+#endif // DI_DEPENDENCY_WRAPPER
+
+} // namespace DependencyDetail
+
+
+//------------------------------------------------------------------------------
+// OptionalDependency
+//
+// Use this to specify an optional dependency in a Dependencies list.
+//
+// One bound to a wrapper that is not initialized when the consumer is
+// tests false inside T::Initialize() and in the copy T keeps, so it keeps
+// the wrapper in every build.  LateBound<> optionals are not resolved,
+// since they are only used once both objects are up.
+
+/*
+    Example:
+
+    struct Dependencies
+    {
+        RequiredDependency<Widget> widget;
+
+        OptionalDependency<Widget> optionalWidget;
+    };
+*/
+
+template<class T, class C>
+class OptionalDependency : public DependencyDetail::DependencyReference<T, C, true>
+{
+public:
+    OptionalDependency()
+    {
+        this->Bind(nullptr, nullptr);
+    }
+    OptionalDependency(T* reference)
+    {
+        this->Bind(reference, nullptr);
+    }
+    // Reference together with the wrapper that owns it, e.g. from a
+    // DependencyRegistry that only knows the wrapper as IDependencyInjected
+    OptionalDependency(T* reference, IDependencyInjected* wrapper)
+    {
+        this->Bind(reference, wrapper);
+    }
+    template<class S, class... P>
+    OptionalDependency(DependencyInjected<S, P...>& wrapper)
+    {
+        // Types must be convertible e.g. implementation to interface
+        this->Bind(wrapper.GetObjectPtr(), &wrapper);
+    }
+    template<class S, class... P>
+    OptionalDependency(DependencyInjected<S, P...>* wrapper)
+    {
+        if (wrapper)
+        {
+            // Types must be convertible e.g. implementation to interface
+            this->Bind(wrapper->GetObjectPtr(), wrapper);
+        }
+        else
+            this->Bind(nullptr, nullptr);
+    }
+
+    // Called by Initialize() of the consumer: True if bound to a wrapper
+    // that is not initialized, so the consumer must see it as unset
+    DI_FORCE_INLINE bool IsWrapperDown() const
+    {
+        return this->Reference != nullptr && !this->Wrapper->IsInitialized();
+    }
+};
+
+
+//------------------------------------------------------------------------------
+// RequiredDependency
+//
+// Use this to specify a required dependency in a Dependencies list.
+//
+// Release builds store just the pointer: Only checked builds keep the
+// wrapper, to catch use before it is initialized.
+
+/*
+    Example:
+
+    struct Dependencies
+    {
+        RequiredDependency<Widget> widget;
+
+        OptionalDependency<Widget> optionalWidget;
+    };
+*/
+
+template<class T, class C>
+class RequiredDependency
+    : public DependencyDetail::DependencyReference<T, C, DependencyDetail::KeepRequiredWrapper>
+{
+public:
+    RequiredDependency()
+    {
+        this->Bind(nullptr, nullptr);
+    }
+    RequiredDependency(T* reference)
+    {
+        this->Bind(reference, nullptr);
+        DI_CHECK(this->Reference != nullptr, DependencyViolationKind::RequiredDependencyNull, T,
+            "RequiredDependency set to null");
+    }
+    RequiredDependency(T* reference, IDependencyInjected* wrapper)
+    {
+        this->Bind(reference, wrapper);
+        DI_CHECK(this->Reference != nullptr, DependencyViolationKind::RequiredDependencyNull, T,
+            "RequiredDependency set to null");
+    }
+    template<class S, class... P>
+    RequiredDependency(DependencyInjected<S, P...>& wrapper)
+    {
+        // Types must be convertible e.g. implementation to interface
+        this->Bind(wrapper.GetObjectPtr(), &wrapper);
+        DI_CHECK(this->Reference != nullptr, DependencyViolationKind::RequiredDependencyNull, T,
+            "RequiredDependency set to null");
+    }
+    template<class S, class... P>
+    RequiredDependency(DependencyInjected<S, P...>* wrapper)
+    {
+        if (wrapper)
+        {
+            // Types must be convertible e.g. implementation to interface
+            this->Bind(wrapper->GetObjectPtr(), wrapper);
+        }
+        else
+            this->Bind(nullptr, nullptr);
+        DI_CHECK(this->Reference != nullptr, DependencyViolationKind::RequiredDependencyNull, T,
+            "RequiredDependency set to null");
+    }
+};
+
+
+//------------------------------------------------------------------------------
+// LateBound
+//
+// Marks a dependency that is only used after both objects are initialized,
+// so it does not constrain initialization order.  Peer objects that refer
+// to each other (like Cog and Widget) must mark one of the edges LateBound
+// before a container can order them.
+
+/*
+    Example:
+
+    struct Dependencies
+    {
+        RequiredDependency<Cog> cog;
+
+        LateBound<RequiredDependency<Widget>> widget;
+    };
+*/
+
+template<class D>
+class LateBound : public D
+{
+public:
+    using D::D;
+
+    LateBound() = default;
+};
+
+
+//------------------------------------------------------------------------------
+// DependencyMemberTraits
+//
+// Describes a member of a Dependencies struct
+
+DI_EXPORT template<class M>
+struct DependencyMemberTraits
+{
+    static const bool IsDependency = false;
+    static const bool IsRequired = false;
+    static const bool IsLateBound = false;
+};
+
+template<class T, class C>
+struct DependencyMemberTraits<OptionalDependency<T, C>>
+{
+    typedef T Type;
+
+    static const bool IsDependency = true;
+    static const bool IsRequired = false;
+    static const bool IsLateBound = false;
+};
+
+template<class T, class C>
+struct DependencyMemberTraits<RequiredDependency<T, C>>
+    : DependencyMemberTraits<OptionalDependency<T, C>>
+{
+    static const bool IsRequired = true;
+};
+
+template<class D>
+struct DependencyMemberTraits<LateBound<D>> : DependencyMemberTraits<D>
+{
+    static const bool IsLateBound = true;
+};
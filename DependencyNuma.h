@@ -0,0 +1,379 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    DependencyNuma
+
+    NUMA-aware placement of object memory.
+
+    NumaArena is a std::pmr::memory_resource whose pages are placed on one
+    NUMA node, so it plugs into the existing ArenaStorage policy.  Like a
+    monotonic_buffer_resource it hands out memory from large blocks and only
+    returns it when the arena is destroyed.  Not thread-safe.
+
+    The object memory is only half of it: The buffers an object allocates in
+    its Initialize() land on whichever node first touches them.
+    DependencyContainer::SetNumaNode() makes InitializeAll() run that
+    Initialize() on a thread bound to the node, so first-touch lands there.
+
+    On Linux the pages are placed with mbind(MPOL_PREFERRED) and threads are
+    bound with sched_setaffinity() to the CPUs in
+    /sys/devices/system/node/nodeN/cpulist.  On Windows VirtualAllocExNuma()
+    and SetThreadGroupAffinity() are used.  Elsewhere, or when the kernel
+    refuses, the arena falls back to ordinary memory and
+    BindThreadToNumaNode() returns false: Placement is a hint and never
+    makes initialization fail.
+*/
+
+/*
+    Example Usage:
+
+
+    NumaArena arena0(0), arena1(1);
+
+    DependencyInjected<PacketQueue, ArenaStorage> queue0(arena0);
+    DependencyInjected<PacketQueue, ArenaStorage> queue1(arena1);
+
+    DependencyContainer container;
+    container.Add(queue0);
+    container.Add(queue1);
+    container.SetNumaNode(queue0, 0);
+    container.SetNumaNode(queue1, 1);
+
+    container.InitializeAll(); // queue1 initializes on a CPU of node 1
+    ...
+    // After both are shut down and destroyed, arena memory is released
+*/
+
+#include "DependencyArenaStorage.h"
+
+#include <memory_resource>
+#include <vector>
+#include <new>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <sched.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+#endif
+
+
+//------------------------------------------------------------------------------
+// Platform helpers
+
+namespace DependencyDetail {
+
+#if defined(__linux__)
+
+// Reads a sysfs list like "0-3,8-11" into the set of numbers it names.
+// Returns false if the file does not exist
+inline bool ReadSysfsList(const char* path, std::vector<unsigned>& numbers)
+{
+    numbers.clear();
+
+    FILE* file = fopen(path, "r");
+    if (!file)
+        return false;
+
+    char text[4096];
+    const bool read = fgets(text, sizeof(text), file) != nullptr;
+    fclose(file);
+    if (!read)
+        return false;
+
+    const char* p = text;
+    while (*p >= '0' && *p <= '9')
+    {
+        unsigned first = 0;
+        while (*p >= '0' && *p <= '9')
+            first = first * 10 + static_cast<unsigned>(*p++ - '0');
+
+        unsigned last = first;
+        if (*p == '-')
+        {
+            ++p;
+            last = 0;
+            while (*p >= '0' && *p <= '9')
+                last = last * 10 + static_cast<unsigned>(*p++ - '0');
+        }
+
+        for (unsigned i = first; i <= last; ++i)
+            numbers.push_back(i);
+
+        if (*p == ',')
+            ++p;
+    }
+
+    return true;
+}
+
+static const unsigned kNumaMaskWords = 16; // 1024 nodes
+static const int kMpolPreferred = 1;
+
+#endif // __linux__
+
+inline size_t GetPageBytes()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#elif defined(__linux__)
+    const long bytes = sysconf(_SC_PAGESIZE);
+    return bytes > 0 ? static_cast<size_t>(bytes) : 4096;
+#else
+    return 4096;
+#endif
+}
+
+// Page-granular memory for a block of the arena.  Sets placed = true if
+// the memory is known to be on the node
+inline void* AllocateNumaPages(size_t bytes, unsigned node, bool& placed)
+{
+    placed = false;
+
+#if defined(_WIN32)
+    void* memory = VirtualAllocExNuma(GetCurrentProcess(), nullptr, bytes,
+        MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+    if (memory)
+    {
+        placed = true;
+        return memory;
+    }
+    return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#elif defined(__linux__)
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+        return nullptr;
+
+#if defined(SYS_mbind)
+    const unsigned bitsPerWord = sizeof(unsigned long) * 8;
+    if (node < kNumaMaskWords * bitsPerWord)
+    {
+        unsigned long mask[kNumaMaskWords] = {};
+        mask[node / bitsPerWord] = 1ul << (node % bitsPerWord);
+
+        // The kernel reads maxnode - 1 bits of the mask
+        placed = syscall(SYS_mbind, memory, bytes, kMpolPreferred,
+            mask, kNumaMaskWords * bitsPerWord + 1, 0) == 0;
+    }
+#endif // SYS_mbind
+
+    return memory;
+#else
+    // Callers carve page-aligned blocks out of this memory
+    return ::operator new(bytes, std::align_val_t(GetPageBytes()), std::nothrow);
+#endif
+}
+
+inline void FreeNumaPages(void* memory, size_t bytes)
+{
+#if defined(_WIN32)
+    (void)bytes;
+    VirtualFree(memory, 0, MEM_RELEASE);
+#elif defined(__linux__)
+    munmap(memory, bytes);
+#else
+    (void)bytes;
+    ::operator delete(memory, std::align_val_t(GetPageBytes()), std::nothrow);
+#endif
+}
+
+} // namespace DependencyDetail
+
+
+//------------------------------------------------------------------------------
+// NUMA topology
+
+// Number of NUMA nodes, at least 1
+inline unsigned GetNumaNodeCount()
+{
+#if defined(_WIN32)
+    ULONG highest = 0;
+    if (!GetNumaHighestNodeNumber(&highest))
+        return 1;
+    return static_cast<unsigned>(highest) + 1;
+#elif defined(__linux__)
+    std::vector<unsigned> nodes;
+    if (!DependencyDetail::ReadSysfsList("/sys/devices/system/node/online", nodes) || nodes.empty())
+        return 1;
+    return nodes.back() + 1;
+#else
+    return 1;
+#endif
+}
+
+// Restricts the calling thread to the CPUs of a NUMA node.
+// Returns false if the node does not exist or the OS refused
+inline bool BindThreadToNumaNode(unsigned node)
+{
+#if defined(_WIN32)
+    GROUP_AFFINITY affinity = {};
+    if (!GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity) || affinity.Mask == 0)
+        return false;
+    return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+#elif defined(__linux__)
+    char path[96];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+
+    std::vector<unsigned> cpus;
+    if (!DependencyDetail::ReadSysfsList(path, cpus) || cpus.empty())
+        return false;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (unsigned cpu : cpus)
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+
+    // 0 = the calling thread
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+// NumaArena
+
+class NumaArena : public std::pmr::memory_resource
+{
+public:
+    explicit NumaArena(unsigned node, size_t blockBytes = 64 * 1024)
+        : Node(node)
+        , PageBytes(DependencyDetail::GetPageBytes())
+    {
+        BlockBytes = RoundUp(blockBytes > 0 ? blockBytes : 1, PageBytes);
+    }
+
+    ~NumaArena()
+    {
+        for (const Block& block : Blocks)
+            DependencyDetail::FreeNumaPages(block.Memory, block.Bytes);
+    }
+
+    unsigned GetNode() const
+    {
+        return Node;
+    }
+
+    // True if every block so far was placed on the node by the OS
+    bool IsPlaced() const
+    {
+        return Placed;
+    }
+
+    size_t GetReservedBytes() const
+    {
+        size_t bytes = 0;
+        for (const Block& block : Blocks)
+            bytes += block.Bytes;
+        return bytes;
+    }
+
+protected:
+    struct Block
+    {
+        unsigned char* Memory;
+        size_t Bytes;
+    };
+
+    unsigned Node;
+    size_t PageBytes;
+    size_t BlockBytes;
+    std::vector<Block> Blocks;
+    unsigned char* Next = nullptr;
+    unsigned char* End = nullptr;
+    bool Placed = true;
+
+    static size_t RoundUp(size_t bytes, size_t multiple)
+    {
+        return (bytes + multiple - 1) / multiple * multiple;
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        const uintptr_t next = reinterpret_cast<uintptr_t>(Next);
+        const uintptr_t aligned = RoundUp(next, alignment);
+
+        if (!Next || aligned + bytes > reinterpret_cast<uintptr_t>(End))
+        {
+            // Oversized requests get a block of their own.
+            // Blocks are page-aligned, so alignment up to a page is free
+            const size_t needed = RoundUp(bytes + (alignment > PageBytes ? alignment : 0), PageBytes);
+            const size_t blockBytes = needed > BlockBytes ? needed : BlockBytes;
+
+            bool placed = false;
+            void* memory = DependencyDetail::AllocateNumaPages(blockBytes, Node, placed);
+            if (!memory)
+                throw std::bad_alloc();
+
+            Blocks.push_back(Block{ static_cast<unsigned char*>(memory), blockBytes });
+            Placed &= placed;
+
+            Next = static_cast<unsigned char*>(memory);
+            End = Next + blockBytes;
+            return do_allocate(bytes, alignment);
+        }
+
+        Next = reinterpret_cast<unsigned char*>(aligned + bytes);
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    void do_deallocate(void* /*p*/, size_t /*bytes*/, size_t /*alignment*/) override
+    {
+        // Released when the arena is destroyed
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    // Deleted methods
+    NumaArena(const NumaArena&) = delete;
+    NumaArena& operator=(const NumaArena&) = delete;
+};
@@ -0,0 +1,185 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    DependencyRegistry
+
+    Finds already-created components by type, e.g. from a plugin layer,
+    without hashing.
+
+    The registry is declared over a fixed list of component types.  Each
+    type's position in the list is its compile-time index into a flat array
+    of object pointers, so Get<T>() is a single load from a constant offset.
+    Get<I>() for an interface I resolves to the one listed type that
+    derives from I, and does not compile if two of them do.
+
+    Wire<T>() builds a T::Dependencies struct from the registry: Each
+    RequiredDependency<X> or OptionalDependency<X> member, optionally marked
+    LateBound<>, is set to the registered provider of X.  Other members are
+    value-initialized.  A RequiredDependency on a type with no provider in
+    the list is a compile error.  When it refers to a listed type that has
+    not been added, the RequiredDependency check fires.
+*/
+
+/*
+    Example Usage:
+
+
+    DependencyRegistry<MyImplementation, InterfaceUser> registry;
+    DependencyInjected<MyImplementation> branch;
+    DependencyInjected<InterfaceUser> user;
+
+    registry.Add(branch);
+    registry.Add(user);
+
+    registry.AutoWire(branch);
+    registry.AutoWire(user); // Dependencies member RequiredDependency<IMyInterface> is branch
+
+    branch.Initialize(10);
+    user.Initialize();
+
+    registry.Get<IMyInterface>()->DoThing(); // Single indexed load
+
+    user.Shutdown();
+    branch.Shutdown();
+*/
+
+#include "DependencyInjected.h"
+#include "DependencyGraph.h" // ProviderIndex, TypeIndex
+
+#include <array>
+#include <tuple>
+
+
+//------------------------------------------------------------------------------
+// DependencyRegistry
+
+template<class... Ts>
+class DependencyRegistry
+{
+public:
+    static const size_t TypeCount = sizeof...(Ts);
+
+    // Registers the wrapper for its object type, which must be listed
+    template<class S, class... P>
+    void Add(DependencyInjected<S, P...>& wrapper)
+    {
+        constexpr size_t index = DependencyDetail::TypeIndex<S, Ts...>();
+        static_assert(index < TypeCount, "Type is not listed in this DependencyRegistry");
+
+        // Catch registering two wrappers for one type in debug mode
+        DI_DEBUG_ASSERT(Wrappers[index] == nullptr || Wrappers[index] == &wrapper);
+
+        Objects[index] = wrapper.GetObjectPtr();
+        Wrappers[index] = &wrapper;
+    }
+
+    template<class S>
+    void Remove()
+    {
+        constexpr size_t index = DependencyDetail::TypeIndex<S, Ts...>();
+        static_assert(index < TypeCount, "Type is not listed in this DependencyRegistry");
+
+        Objects[index] = nullptr;
+        Wrappers[index] = nullptr;
+    }
+
+    // Object of type X, or of the one listed type that derives from X.
+    // Returns nullptr if no wrapper has been added for it
+    template<class X>
+    DI_FORCE_INLINE X* Get() const
+    {
+        constexpr size_t index = DependencyDetail::ProviderIndex<X, Ts...>();
+        static_assert(index < TypeCount, "No type in this DependencyRegistry provides X");
+
+        typedef typename std::tuple_element<index, std::tuple<Ts...>>::type S;
+        return static_cast<S*>(Objects[index]);
+    }
+
+    template<class X>
+    DI_FORCE_INLINE IDependencyInjected* GetWrapper() const
+    {
+        constexpr size_t index = DependencyDetail::ProviderIndex<X, Ts...>();
+        static_assert(index < TypeCount, "No type in this DependencyRegistry provides X");
+
+        return Wrappers[index];
+    }
+
+    // Provider of X has been added and initialized
+    template<class X>
+    DI_FORCE_INLINE bool IsInitialized() const
+    {
+        IDependencyInjected* wrapper = GetWrapper<X>();
+        return wrapper && wrapper->IsInitialized();
+    }
+
+    // Dependencies for T with every dependency member set from the registry
+    template<class T>
+    typename T::Dependencies Wire() const
+    {
+        return DependencyDetail::BuildDependencies<typename T::Dependencies>([this](auto tag) {
+            return WireMember<typename decltype(tag)::Type>();
+        });
+    }
+
+    // SetDependencies(Wire<S>())
+    template<class S, class... P>
+    void AutoWire(DependencyInjected<S, P...>& wrapper) const
+    {
+        wrapper.SetDependencies(Wire<S>());
+    }
+
+protected:
+    // Indexed by position in Ts
+    std::array<void*, sizeof...(Ts)> Objects{};
+    std::array<IDependencyInjected*, sizeof...(Ts)> Wrappers{};
+
+    template<class M>
+    M WireMember() const
+    {
+        if constexpr (DependencyDetail::IsWirable<M>::value)
+        {
+            typedef DependencyMemberTraits<M> Traits;
+            typedef typename Traits::Type X;
+            constexpr size_t index = DependencyDetail::ProviderIndex<X, Ts...>();
+
+            if constexpr (index < TypeCount)
+                return M(Get<X>(), Wrappers[index]);
+            else
+            {
+                static_assert(!Traits::IsRequired, "RequiredDependency has no provider in this DependencyRegistry");
+                return M();
+            }
+        }
+        else
+            return M();
+    }
+};
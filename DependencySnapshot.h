@@ -0,0 +1,672 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    DependencySnapshot
+
+    Saves the state of a set of initialized DependencyInjected<> objects to
+    a file, and restores it in a later process by memory-mapping the file
+    instead of running Initialize() again.
+
+    Objects opt in by implementing two methods next to Initialize():
+
+        void SaveSnapshot(DependencySnapshotWriter& writer) const;
+        bool RestoreSnapshot(const Dependencies& deps, DependencySnapshotReader& reader);
+
+    ReadArray() returns pointers straight into the mapped file, so large
+    immutable tables are not copied: Warm-start time is proportional to the
+    pages that are actually touched.  The file stays mapped until the
+    DependencySnapshot is destroyed, which must happen after the restored
+    objects are shut down.
+
+    Pointers into the object memory of another object in the snapshot are
+    relocatable: They are stored as (object index, offset) and resolved
+    against the wrappers of the restoring process.  This is done for the
+    RequiredDependency<>/OptionalDependency<> members of each Dependencies
+    struct, and for pointers written with WritePointer().  Restore()
+    fails if the edges of the graph do not match the ones that were saved,
+    if any type changed, or if the version does not match.  In that case
+    the caller falls back to initializing normally.
+
+    Objects are saved and restored in the order they were added, which must
+    be a valid initialization order.  Snapshots are only portable between
+    processes running the same build.
+*/
+
+/*
+    Example Usage:
+
+
+    DependencySnapshot snapshot;
+    snapshot.SetVersion(kTablesVersion);
+    snapshot.Add(tables);
+    snapshot.Add(index);
+
+    if (!snapshot.Restore("warm.snapshot"))
+    {
+        tables.Initialize();
+        index.Initialize();
+
+        snapshot.Save("warm.snapshot");
+    }
+
+    ...
+
+    index.Shutdown();
+    tables.Shutdown();
+*/
+
+#include "DependencyInjected.h"
+#include "DependencyTypeName.h"
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else // _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif // _WIN32
+
+
+namespace DependencyDetail {
+
+// Object memory of one object in the snapshot
+struct SnapshotRange
+{
+    const char* Storage;
+    size_t Bytes;
+};
+
+static const uint64_t kSnapshotMagic = 0x31305041534E4944ULL; // "DISNAP01"
+static const uint64_t kSnapshotNull = ~uint64_t(0);
+static const uint64_t kSnapshotExternal = ~uint64_t(1);
+
+// Relative to the start of the file, which is page aligned when mapped
+static const size_t kSnapshotArrayAlignment = DI_CACHE_LINE_BYTES;
+
+inline void EncodeSnapshotPointer(const std::vector<SnapshotRange>& ranges,
+    const void* ptr, uint64_t& node, uint64_t& offset)
+{
+    node = kSnapshotNull;
+    offset = 0;
+    if (!ptr)
+        return;
+
+    const char* p = static_cast<const char*>(ptr);
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        if (p >= ranges[i].Storage && p < ranges[i].Storage + ranges[i].Bytes)
+        {
+            node = i;
+            offset = static_cast<uint64_t>(p - ranges[i].Storage);
+            return;
+        }
+    }
+
+    // Outside of the snapshot, so it cannot be relocated
+    node = kSnapshotExternal;
+}
+
+inline uint64_t HashSnapshotType(const char* typeName, size_t bytes)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char* s = typeName; *s; ++s)
+    {
+        hash ^= static_cast<unsigned char>(*s);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= bytes;
+    hash *= 1099511628211ULL;
+    return hash;
+}
+
+} // namespace DependencyDetail
+
+
+//------------------------------------------------------------------------------
+// DependencySnapshotWriter
+
+class DependencySnapshotWriter
+{
+public:
+    // Raw bytes, aligned to 8 bytes
+    void Write(const void* data, size_t bytes)
+    {
+        Align(8);
+        const size_t offset = Buffer.size();
+        Buffer.resize(offset + bytes);
+        if (bytes > 0)
+            memcpy(Buffer.data() + offset, data, bytes);
+    }
+
+    template<class X>
+    void WriteValue(const X& value)
+    {
+        static_assert(std::is_trivially_copyable<X>::value, "Must be trivially copyable");
+        Write(&value, sizeof(X));
+    }
+
+    // Count followed by the elements, aligned for SIMD loads when mapped
+    template<class X>
+    void WriteArray(const X* data, size_t count)
+    {
+        static_assert(std::is_trivially_copyable<X>::value, "Must be trivially copyable");
+        WriteValue<uint64_t>(count);
+        Align(kArrayAlignment);
+        Write(data, count * sizeof(X));
+    }
+
+    // Pointer into the object memory of an object in the snapshot
+    void WritePointer(const void* ptr)
+    {
+        uint64_t node, offset;
+        DependencyDetail::EncodeSnapshotPointer(*Ranges, ptr, node, offset);
+
+        // Catch pointers that cannot be relocated in debug mode
+        DI_DEBUG_ASSERT(node != DependencyDetail::kSnapshotExternal);
+
+        WriteValue(node);
+        WriteValue(offset);
+    }
+
+protected:
+    friend class DependencySnapshot;
+
+    static const size_t kArrayAlignment = DependencyDetail::kSnapshotArrayAlignment;
+
+    const std::vector<DependencyDetail::SnapshotRange>* Ranges = nullptr;
+    std::vector<unsigned char> Buffer;
+
+    void Align(size_t alignment)
+    {
+        Buffer.resize((Buffer.size() + alignment - 1) / alignment * alignment, 0);
+    }
+};
+
+
+//------------------------------------------------------------------------------
+// DependencySnapshotReader
+
+class DependencySnapshotReader
+{
+public:
+    // Raw bytes in the mapped file, or nullptr past the end of the object
+    const void* Read(size_t bytes)
+    {
+        Align(8);
+        if (Error || bytes > End - Offset)
+        {
+            Error = true;
+            return nullptr;
+        }
+
+        const void* data = Data + Offset;
+        Offset += bytes;
+        return data;
+    }
+
+    template<class X>
+    bool ReadValue(X& value)
+    {
+        static_assert(std::is_trivially_copyable<X>::value, "Must be trivially copyable");
+        const void* data = Read(sizeof(X));
+        if (!data)
+            return false;
+        memcpy(&value, data, sizeof(X));
+        return true;
+    }
+
+    // Elements in the mapped file, valid until the snapshot is destroyed
+    template<class X>
+    const X* ReadArray(size_t& count)
+    {
+        static_assert(std::is_trivially_copyable<X>::value, "Must be trivially copyable");
+        uint64_t n = 0;
+        count = 0;
+        if (!ReadValue(n) || n > (End - Offset) / sizeof(X))
+        {
+            Error = true;
+            return nullptr;
+        }
+        Align(DependencyDetail::kSnapshotArrayAlignment);
+
+        const X* data = static_cast<const X*>(Read(static_cast<size_t>(n) * sizeof(X)));
+        if (data)
+            count = static_cast<size_t>(n);
+        return data;
+    }
+
+    // Pointer written with WritePointer(), relocated to this process
+    void* ReadPointer()
+    {
+        uint64_t node = 0, offset = 0;
+        if (!ReadValue(node) || !ReadValue(offset))
+            return nullptr;
+        if (node == DependencyDetail::kSnapshotNull)
+            return nullptr;
+        if (node >= Ranges->size() || offset >= (*Ranges)[static_cast<size_t>(node)].Bytes)
+        {
+            Error = true;
+            return nullptr;
+        }
+        return const_cast<char*>((*Ranges)[static_cast<size_t>(node)].Storage) + offset;
+    }
+
+    // True if any read ran past the end of the object or was malformed
+    DI_FORCE_INLINE bool Failed() const
+    {
+        return Error;
+    }
+
+protected:
+    friend class DependencySnapshot;
+
+    const std::vector<DependencyDetail::SnapshotRange>* Ranges = nullptr;
+    const unsigned char* Data = nullptr;
+    size_t Offset = 0;
+    size_t End = 0;
+    bool Error = false;
+
+    void Align(size_t alignment)
+    {
+        const size_t aligned = (Offset + alignment - 1) / alignment * alignment;
+        if (aligned > End)
+            Error = true;
+        else
+            Offset = aligned;
+    }
+};
+
+
+namespace DependencyDetail {
+
+template<class T, class = void>
+struct HasSnapshotMethods : std::false_type {};
+
+template<class T>
+struct HasSnapshotMethods<T, std::void_t<
+    decltype(std::declval<const T&>().SaveSnapshot(std::declval<DependencySnapshotWriter&>())),
+    decltype(std::declval<T&>().RestoreSnapshot(
+        std::declval<const typename T::Dependencies&>(), std::declval<DependencySnapshotReader&>()))>>
+    : std::true_type {};
+
+} // namespace DependencyDetail
+
+
+//------------------------------------------------------------------------------
+// DependencySnapshotMapping
+//
+// Read-only memory mapping of a file
+
+class DependencySnapshotMapping
+{
+public:
+    DependencySnapshotMapping() = default;
+    ~DependencySnapshotMapping()
+    {
+        Unmap();
+    }
+
+    bool Map(const char* path)
+    {
+        Unmap();
+
+#if defined(_WIN32)
+        File = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (File == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!::GetFileSizeEx(File, &size) || size.QuadPart <= 0)
+        {
+            Unmap();
+            return false;
+        }
+
+        Mapping = ::CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!Mapping)
+        {
+            Unmap();
+            return false;
+        }
+
+        Data = static_cast<const unsigned char*>(::MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!Data)
+        {
+            Unmap();
+            return false;
+        }
+        Bytes = static_cast<size_t>(size.QuadPart);
+#else // _WIN32
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || info.st_size <= 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void* data = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+            return false;
+
+        Data = static_cast<const unsigned char*>(data);
+        Bytes = static_cast<size_t>(info.st_size);
+#endif // _WIN32
+
+        return true;
+    }
+
+    void Unmap()
+    {
+#if defined(_WIN32)
+        if (Data)
+            ::UnmapViewOfFile(Data);
+        if (Mapping)
+            ::CloseHandle(Mapping);
+        if (File != INVALID_HANDLE_VALUE)
+            ::CloseHandle(File);
+        Mapping = nullptr;
+        File = INVALID_HANDLE_VALUE;
+#else // _WIN32
+        if (Data)
+            ::munmap(const_cast<unsigned char*>(Data), Bytes);
+#endif // _WIN32
+
+        Data = nullptr;
+        Bytes = 0;
+    }
+
+    DI_FORCE_INLINE const unsigned char* GetData() const
+    {
+        return Data;
+    }
+    DI_FORCE_INLINE size_t GetBytes() const
+    {
+        return Bytes;
+    }
+
+protected:
+    const unsigned char* Data = nullptr;
+    size_t Bytes = 0;
+
+#if defined(_WIN32)
+    HANDLE File = INVALID_HANDLE_VALUE;
+    HANDLE Mapping = nullptr;
+#endif // _WIN32
+
+    // Deleted methods
+    DependencySnapshotMapping(const DependencySnapshotMapping&) = delete;
+    DependencySnapshotMapping& operator=(const DependencySnapshotMapping&) = delete;
+};
+
+
+//------------------------------------------------------------------------------
+// DependencySnapshot
+
+class DependencySnapshot
+{
+public:
+    ~DependencySnapshot()
+    {
+        // Catch unmapping the file while restored objects still use it
+        for (const Node& node : Nodes)
+        {
+            DI_DEBUG_ASSERT(!Mapping.GetData() || !node.Wrapper->IsInitialized());
+            (void)node;
+        }
+    }
+
+    // Application-defined version of the saved state, checked by Restore()
+    void SetVersion(uint64_t version)
+    {
+        Version = version;
+    }
+
+    // Register an object whose type implements SaveSnapshot() and
+    // RestoreSnapshot().  Add them in initialization order
+    template<class T, class... Policies>
+    void Add(DependencyInjected<T, Policies...>& wrapper)
+    {
+        static_assert(DependencyDetail::HasSnapshotMethods<T>::value,
+            "T must implement SaveSnapshot() and RestoreSnapshot()");
+
+        Node node;
+        node.Wrapper = &wrapper;
+        node.TypeHash = DependencyDetail::HashSnapshotType(DependencyDetail::GetTypeName<T>(), sizeof(T));
+        node.Save = [&wrapper](DependencySnapshotWriter& writer) {
+            wrapper->SaveSnapshot(writer);
+        };
+        node.Restore = [&wrapper](DependencySnapshotReader& reader) -> bool {
+            const bool success = wrapper.InitializeWith([&reader](T& instance, const typename T::Dependencies& deps) {
+                return DependencyDetail::CallSucceeded([&]() -> decltype(auto) {
+                    return instance.RestoreSnapshot(deps, reader);
+                });
+            });
+            return success && !reader.Failed();
+        };
+        node.Shutdown = [&wrapper]() {
+            wrapper.Shutdown();
+        };
+        node.GetEdges = [&wrapper](std::vector<const void*>& edges) {
+            // Catch forgetting SetDependencies() in debug mode
+            DI_DEBUG_ASSERT(wrapper.HasDependencies());
+
+            // Null members are kept so edges are compared member by member
+            DependencyDetail::ForEachDependency(wrapper.GetDependencies(), [&edges](const auto& dep) {
+                edges.push_back(dep.Get());
+            });
+        };
+
+        Ranges.push_back({ reinterpret_cast<const char*>(wrapper.GetObjectPtr()), sizeof(T) });
+        Nodes.push_back(std::move(node));
+    }
+
+    // Save all objects, which must be initialized
+    bool Save(const char* path) const
+    {
+        DependencySnapshotWriter writer;
+        writer.Ranges = &Ranges;
+
+        writer.WriteValue(DependencyDetail::kSnapshotMagic);
+        writer.WriteValue(Version);
+        writer.WriteValue<uint64_t>(Nodes.size());
+
+        std::vector<const void*> edges;
+        for (const Node& node : Nodes)
+        {
+            // Catch saving an object that is not initialized in debug mode
+            DI_DEBUG_ASSERT(node.Wrapper->IsInitialized());
+            if (!node.Wrapper->IsInitialized())
+                return false;
+
+            writer.WriteValue(node.TypeHash);
+
+            edges.clear();
+            node.GetEdges(edges);
+            writer.WriteValue<uint64_t>(edges.size());
+            for (const void* edge : edges)
+            {
+                uint64_t target, offset;
+                DependencyDetail::EncodeSnapshotPointer(Ranges, edge, target, offset);
+                writer.WriteValue(target);
+                writer.WriteValue(offset);
+            }
+
+            // Size of the object state, patched after it is written
+            writer.WriteValue<uint64_t>(0);
+            const size_t sizeOffset = writer.Buffer.size() - sizeof(uint64_t);
+
+            writer.Align(DependencyDetail::kSnapshotArrayAlignment);
+            const size_t start = writer.Buffer.size();
+            node.Save(writer);
+
+            const uint64_t stateBytes = writer.Buffer.size() - start;
+            memcpy(writer.Buffer.data() + sizeOffset, &stateBytes, sizeof(stateBytes));
+        }
+
+        FILE* file = fopen(path, "wb");
+        if (!file)
+            return false;
+        const bool written = fwrite(writer.Buffer.data(), 1, writer.Buffer.size(), file) == writer.Buffer.size();
+        return (fclose(file) == 0) && written;
+    }
+
+    // Map the file and restore all objects without calling Initialize().
+    // Returns false with no objects initialized if the snapshot is missing
+    // or does not match the current graph
+    bool Restore(const char* path)
+    {
+        if (!Mapping.Map(path))
+            return false;
+
+        DependencySnapshotReader reader;
+        reader.Ranges = &Ranges;
+        reader.Data = Mapping.GetData();
+        reader.End = Mapping.GetBytes();
+
+        uint64_t magic = 0, version = 0, count = 0;
+        bool valid = reader.ReadValue(magic) && reader.ReadValue(version) && reader.ReadValue(count) &&
+            magic == DependencyDetail::kSnapshotMagic && version == Version && count == Nodes.size();
+
+        std::vector<const void*> edges;
+        size_t restored = 0;
+        for (; valid && restored < Nodes.size(); ++restored)
+        {
+            const Node& node = Nodes[restored];
+
+            uint64_t typeHash = 0, edgeCount = 0;
+            if (!reader.ReadValue(typeHash) || typeHash != node.TypeHash || !reader.ReadValue(edgeCount))
+            {
+                valid = false;
+                break;
+            }
+
+            // Graph must be wired the same way as when it was saved
+            edges.clear();
+            node.GetEdges(edges);
+            if (edgeCount != edges.size())
+            {
+                valid = false;
+                break;
+            }
+            for (const void* edge : edges)
+            {
+                uint64_t target, offset, savedTarget = 0, savedOffset = 0;
+                DependencyDetail::EncodeSnapshotPointer(Ranges, edge, target, offset);
+                if (!reader.ReadValue(savedTarget) || !reader.ReadValue(savedOffset) ||
+                    target != savedTarget || offset != savedOffset)
+                {
+                    valid = false;
+                }
+            }
+
+            uint64_t stateBytes = 0;
+            if (!valid || !reader.ReadValue(stateBytes))
+            {
+                valid = false;
+                break;
+            }
+            reader.Align(DependencyDetail::kSnapshotArrayAlignment);
+            if (reader.Failed() || stateBytes > reader.End - reader.Offset)
+            {
+                valid = false;
+                break;
+            }
+
+            // Limit the object to its own state
+            DependencySnapshotReader objectReader = reader;
+            objectReader.End = reader.Offset + static_cast<size_t>(stateBytes);
+            reader.Offset = objectReader.End;
+
+            if (!node.Restore(objectReader))
+            {
+                // Shutdown the partially restored object too
+                ++restored;
+                valid = false;
+                break;
+            }
+        }
+
+        if (!valid)
+        {
+            for (size_t i = restored; i > 0; --i)
+                Nodes[i - 1].Shutdown();
+            Mapping.Unmap();
+            return false;
+        }
+
+        return true;
+    }
+
+    // True while restored objects may refer to the mapped file
+    DI_FORCE_INLINE bool IsMapped() const
+    {
+        return Mapping.GetData() != nullptr;
+    }
+
+protected:
+    struct Node
+    {
+        IDependencyInjected* Wrapper = nullptr;
+        uint64_t TypeHash = 0;
+
+        std::function<void(DependencySnapshotWriter&)> Save;
+        std::function<bool(DependencySnapshotReader&)> Restore;
+        std::function<void()> Shutdown;
+        std::function<void(std::vector<const void*>&)> GetEdges;
+    };
+
+    std::vector<Node> Nodes;
+    std::vector<DependencyDetail::SnapshotRange> Ranges;
+    uint64_t Version = 0;
+
+    DependencySnapshotMapping Mapping;
+};
@@ -0,0 +1,411 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    DependencyTrace
+
+    Startup/shutdown tracing for DependencyInjected objects.
+
+    Define DI_TRACE for the whole build to record one event for every
+    DependencyInjected<T>::Initialize() and Shutdown() with:
+
+    (1) Type name of T
+    (2) Wall time of the call
+    (3) Number of heap allocations and bytes allocated during the call,
+        when DI_TRACE_ALLOCATION_HOOKS() is placed in one source file
+    (4) Objects it depends on, read from its Dependencies struct
+
+    Times and allocations are inclusive of nested objects initialized
+    inside the call.  The events are exported as Chrome trace JSON, which
+    can be opened in chrome://tracing or https://ui.perfetto.dev
+
+    Without DI_TRACE the hooks in DependencyInjected.h compile to nothing.
+*/
+
+/*
+    Example Usage:
+
+
+    // In one source file, with DI_TRACE defined for the whole build:
+    DI_TRACE_ALLOCATION_HOOKS();
+
+    ...
+
+    container.InitializeAll();
+
+    DependencyTracer::Get().WriteChromeTrace("startup.json");
+*/
+
+#include "DependencyTypeName.h"
+#include "DependencyThreadId.h"
+
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <fstream>
+
+#if defined(_MSC_VER)
+    #include <malloc.h> // _aligned_malloc
+#endif // _MSC_VER
+
+
+//------------------------------------------------------------------------------
+// DependencyTraceEvent
+
+struct DependencyTraceEvent
+{
+    // "Initialize" or "Shutdown"
+    const char* Phase = nullptr;
+    const char* TypeName = nullptr;
+
+    // Object memory of the wrapper
+    const void* Object = nullptr;
+    size_t ObjectBytes = 0;
+
+    // Referenced objects from the Dependencies struct
+    std::vector<const void*> Edges;
+
+    // Nanoseconds since the tracer was created
+    uint64_t StartNsec = 0;
+    uint64_t DurationNsec = 0;
+
+    uint64_t Allocations = 0;
+    uint64_t AllocatedBytes = 0;
+
+    uint32_t ThreadId = 0;
+};
+
+
+namespace DependencyDetail {
+
+//------------------------------------------------------------------------------
+// Allocation counters
+
+struct TraceAllocationCounters
+{
+    uint64_t Count;
+    uint64_t Bytes;
+};
+
+// Trivial type so it is safe to touch from operator new at any time
+inline TraceAllocationCounters& GetTraceAllocationCounters()
+{
+    static thread_local TraceAllocationCounters counters = { 0, 0 };
+    return counters;
+}
+
+inline void CountTraceAllocation(size_t bytes)
+{
+    TraceAllocationCounters& counters = GetTraceAllocationCounters();
+    counters.Count++;
+    counters.Bytes += bytes;
+}
+
+inline void* TraceAllocate(size_t bytes) noexcept
+{
+    CountTraceAllocation(bytes);
+    return std::malloc(bytes ? bytes : 1);
+}
+
+// For the std::align_val_t forms, freed by FreeTraceAllocationAligned()
+inline void* TraceAllocateAligned(size_t bytes, std::align_val_t alignment) noexcept
+{
+    CountTraceAllocation(bytes);
+
+    const size_t align = static_cast<size_t>(alignment);
+#if defined(_MSC_VER)
+    return _aligned_malloc(bytes ? bytes : 1, align);
+#else // _MSC_VER
+    // aligned_alloc() takes a multiple of the alignment
+    return std::aligned_alloc(align, ((bytes ? bytes : 1) + align - 1) & ~(align - 1));
+#endif // _MSC_VER
+}
+
+// Out of line so compilers that see both new and free() do not flag a mismatch
+#if defined(_MSC_VER)
+__declspec(noinline)
+#else // _MSC_VER
+__attribute__((noinline))
+#endif // _MSC_VER
+inline void FreeTraceAllocation(void* p)
+{
+    std::free(p);
+}
+
+#if defined(_MSC_VER)
+__declspec(noinline)
+#else // _MSC_VER
+__attribute__((noinline))
+#endif // _MSC_VER
+inline void FreeTraceAllocationAligned(void* p)
+{
+#if defined(_MSC_VER)
+    _aligned_free(p);
+#else // _MSC_VER
+    std::free(p);
+#endif // _MSC_VER
+}
+
+} // namespace DependencyDetail
+
+
+// Counts heap allocations for the trace.  Place in exactly one source file.
+// Replaces the single, array and std::align_val_t forms of new and delete
+#define DI_TRACE_ALLOCATION_HOOKS() \
+    void* operator new(std::size_t bytes) \
+    { \
+        if (void* p = DependencyDetail::TraceAllocate(bytes)) \
+            return p; \
+        throw std::bad_alloc(); \
+    } \
+    void* operator new[](std::size_t bytes) \
+    { \
+        if (void* p = DependencyDetail::TraceAllocate(bytes)) \
+            return p; \
+        throw std::bad_alloc(); \
+    } \
+    void* operator new(std::size_t bytes, const std::nothrow_t&) noexcept { return DependencyDetail::TraceAllocate(bytes); } \
+    void* operator new[](std::size_t bytes, const std::nothrow_t&) noexcept { return DependencyDetail::TraceAllocate(bytes); } \
+    void* operator new(std::size_t bytes, std::align_val_t alignment) \
+    { \
+        if (void* p = DependencyDetail::TraceAllocateAligned(bytes, alignment)) \
+            return p; \
+        throw std::bad_alloc(); \
+    } \
+    void* operator new[](std::size_t bytes, std::align_val_t alignment) \
+    { \
+        if (void* p = DependencyDetail::TraceAllocateAligned(bytes, alignment)) \
+            return p; \
+        throw std::bad_alloc(); \
+    } \
+    void* operator new(std::size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept \
+    { \
+        return DependencyDetail::TraceAllocateAligned(bytes, alignment); \
+    } \
+    void* operator new[](std::size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept \
+    { \
+        return DependencyDetail::TraceAllocateAligned(bytes, alignment); \
+    } \
+    void operator delete(void* p) noexcept { DependencyDetail::FreeTraceAllocation(p); } \
+    void operator delete[](void* p) noexcept { DependencyDetail::FreeTraceAllocation(p); } \
+    void operator delete(void* p, std::size_t) noexcept { DependencyDetail::FreeTraceAllocation(p); } \
+    void operator delete[](void* p, std::size_t) noexcept { DependencyDetail::FreeTraceAllocation(p); } \
+    void operator delete(void* p, const std::nothrow_t&) noexcept { DependencyDetail::FreeTraceAllocation(p); } \
+    void operator delete[](void* p, const std::nothrow_t&) noexcept { DependencyDetail::FreeTraceAllocation(p); } \
+    void operator delete(void* p, std::align_val_t) noexcept { DependencyDetail::FreeTraceAllocationAligned(p); } \
+    void operator delete[](void* p, std::align_val_t) noexcept { DependencyDetail::FreeTraceAllocationAligned(p); } \
+    void operator delete(void* p, std::size_t, std::align_val_t) noexcept { DependencyDetail::FreeTraceAllocationAligned(p); } \
+    void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { DependencyDetail::FreeTraceAllocationAligned(p); } \
+    void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { DependencyDetail::FreeTraceAllocationAligned(p); } \
+    void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { DependencyDetail::FreeTraceAllocationAligned(p); } \
+    static_assert(true, "")
+
+
+//------------------------------------------------------------------------------
+// DependencyTracer
+//
+// Process-wide collection of trace events
+
+class DependencyTracer
+{
+public:
+    static DependencyTracer& Get()
+    {
+        static DependencyTracer tracer;
+        return tracer;
+    }
+
+    uint64_t GetNsec() const
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - Epoch).count());
+    }
+
+    void Record(DependencyTraceEvent&& event)
+    {
+        std::lock_guard<std::mutex> locker(Lock);
+        Events.push_back(std::move(event));
+    }
+
+    std::vector<DependencyTraceEvent> GetEvents() const
+    {
+        std::lock_guard<std::mutex> locker(Lock);
+        return Events;
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> locker(Lock);
+        Events.clear();
+    }
+
+    // Chrome trace event format, with edges in args.dependsOn
+    void WriteChromeTrace(std::ostream& out) const
+    {
+        const std::vector<DependencyTraceEvent> events = GetEvents();
+
+        out << "{\"traceEvents\":[";
+        for (size_t i = 0; i < events.size(); ++i)
+        {
+            const DependencyTraceEvent& e = events[i];
+
+            out << (i ? ",\n" : "\n") << "{\"name\":";
+            DependencyDetail::WriteJsonString(out, e.TypeName);
+            out << ",\"cat\":";
+            DependencyDetail::WriteJsonString(out, e.Phase);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.ThreadId
+                << ",\"ts\":" << e.StartNsec / 1000 << "." << (e.StartNsec % 1000) / 100
+                << ",\"dur\":" << e.DurationNsec / 1000 << "." << (e.DurationNsec % 1000) / 100
+                << ",\"args\":{\"allocations\":" << e.Allocations
+                << ",\"allocatedBytes\":" << e.AllocatedBytes
+                << ",\"dependsOn\":[";
+
+            bool first = true;
+            for (const void* edge : e.Edges)
+            {
+                const char* name = FindTypeName(events, edge, e.StartNsec);
+                if (!name)
+                    continue;
+                if (!first)
+                    out << ",";
+                first = false;
+                DependencyDetail::WriteJsonString(out, name);
+            }
+            out << "]}}";
+        }
+        out << "\n]}\n";
+    }
+
+    bool WriteChromeTrace(const char* path) const
+    {
+        std::ofstream file(path);
+        if (!file)
+            return false;
+        WriteChromeTrace(file);
+        return static_cast<bool>(file);
+    }
+
+protected:
+    const std::chrono::steady_clock::time_point Epoch = std::chrono::steady_clock::now();
+
+    mutable std::mutex Lock;
+    std::vector<DependencyTraceEvent> Events;
+
+    // Find the most recent Initialize() before the given time whose object
+    // memory contains the pointer
+    static const char* FindTypeName(const std::vector<DependencyTraceEvent>& events,
+        const void* ptr, uint64_t beforeNsec)
+    {
+        const char* name = nullptr;
+        uint64_t latest = 0;
+
+        const uintptr_t p = reinterpret_cast<uintptr_t>(ptr);
+        for (const DependencyTraceEvent& e : events)
+        {
+            const uintptr_t object = reinterpret_cast<uintptr_t>(e.Object);
+            if (p < object || p >= object + e.ObjectBytes)
+                continue;
+            if (e.Phase[0] != 'I' || e.StartNsec > beforeNsec)
+                continue;
+            if (!name || e.StartNsec >= latest)
+            {
+                name = e.TypeName;
+                latest = e.StartNsec;
+            }
+        }
+
+        return name;
+    }
+};
+
+
+//------------------------------------------------------------------------------
+// DependencyTraceScope
+//
+// Records one event from construction to destruction
+
+class DependencyTraceScope
+{
+public:
+    DependencyTraceScope(const char* phase, const char* typeName, const void* object, size_t objectBytes)
+    {
+        Event.Phase = phase;
+        Event.TypeName = typeName;
+        Event.Object = object;
+        Event.ObjectBytes = objectBytes;
+        Event.ThreadId = DependencyDetail::GetTraceThreadId();
+
+        const DependencyDetail::TraceAllocationCounters& counters = DependencyDetail::GetTraceAllocationCounters();
+        StartAllocations = counters.Count;
+        StartBytes = counters.Bytes;
+        Event.StartNsec = DependencyTracer::Get().GetNsec();
+    }
+    ~DependencyTraceScope()
+    {
+        Event.DurationNsec = DependencyTracer::Get().GetNsec() - Event.StartNsec;
+
+        const DependencyDetail::TraceAllocationCounters& counters = DependencyDetail::GetTraceAllocationCounters();
+        Event.Allocations = counters.Count - StartAllocations;
+        Event.AllocatedBytes = counters.Bytes - StartBytes;
+
+        DependencyTracer::Get().Record(std::move(Event));
+    }
+
+    void AddEdge(const void* object)
+    {
+        if (!object)
+            return;
+
+        // Keep the allocations of the trace itself out of the counts
+        const DependencyDetail::TraceAllocationCounters& counters = DependencyDetail::GetTraceAllocationCounters();
+        const uint64_t count = counters.Count, bytes = counters.Bytes;
+        Event.Edges.push_back(object);
+        StartAllocations += counters.Count - count;
+        StartBytes += counters.Bytes - bytes;
+    }
+
+protected:
+    DependencyTraceEvent Event;
+    uint64_t StartAllocations;
+    uint64_t StartBytes;
+
+    // Deleted methods
+    DependencyTraceScope(const DependencyTraceScope&) = delete;
+    DependencyTraceScope& operator=(const DependencyTraceScope&) = delete;
+};
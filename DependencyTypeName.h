@@ -0,0 +1,119 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    DependencyTypeName
+
+    Readable type names without RTTI, used by the trace, the container
+    reports, snapshots, the access counters and the violation log.
+
+    Kept apart from DependencyTrace.h so those headers do not pull in the
+    tracer to name a type, and free of standard library containers and
+    streams so debug builds of DependencyMembers.h can include it.
+*/
+
+#include <cstring>
+#include <cstdlib>
+
+
+namespace DependencyDetail {
+
+//------------------------------------------------------------------------------
+// Type names
+
+template<class T>
+const char* TypeNameSignature()
+{
+#if defined(_MSC_VER)
+    return __FUNCSIG__;
+#else // _MSC_VER
+    return __PRETTY_FUNCTION__;
+#endif // _MSC_VER
+}
+
+// Copies T out of a TypeNameSignature<T>() string.  Never freed
+inline const char* ExtractTypeName(const char* sig)
+{
+#if defined(_MSC_VER)
+    // "const char *__cdecl DependencyDetail::TypeNameSignature<class X>(void)"
+    const char* start = strstr(sig, "TypeNameSignature<") + 18;
+    const char* end = start;
+    for (const char* found = start; (found = strstr(found, ">(void)")) != nullptr; ++found)
+        end = found;
+    static const char* const prefixes[] = { "class ", "struct " };
+    for (const char* prefix : prefixes)
+    {
+        const size_t len = strlen(prefix);
+        if (strncmp(start, prefix, len) == 0)
+            start += len;
+    }
+#else // _MSC_VER
+    // "const char* DependencyDetail::TypeNameSignature() [with T = X]"
+    const char* start = strstr(sig, "T = ") + 4;
+    const char* end = start + strcspn(start, ";]");
+#endif // _MSC_VER
+
+    const size_t len = static_cast<size_t>(end - start);
+    char* name = static_cast<char*>(malloc(len + 1));
+    if (!name)
+        return "?";
+    memcpy(name, start, len);
+    name[len] = '\0';
+    return name;
+}
+
+// Extracts T from the function signature once per type
+template<class T>
+const char* GetTypeName()
+{
+    static const char* const name = ExtractTypeName(TypeNameSignature<T>());
+    return name;
+}
+
+
+//------------------------------------------------------------------------------
+// JSON
+
+// Writes a type name or other identifier as a JSON string to a std::ostream
+template<class Stream>
+void WriteJsonString(Stream& out, const char* s)
+{
+    out << '"';
+    for (; *s; ++s)
+    {
+        if (*s == '"' || *s == '\\')
+            out << '\\';
+        out << *s;
+    }
+    out << '"';
+}
+
+} // namespace DependencyDetail
@@ -0,0 +1,406 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    DependencyViolationLog
+
+    Collects every failed usage check of a debug build in one run.
+
+    By default a failed check traps at the first violation.  While the log
+    is enabled, each failure is recorded into a fixed-size lock-free ring
+    buffer instead, and the program carries on as a release build would.
+    Each record has:
+
+    (1) Kind, e.g. use-before-init, use-after-shutdown, missed-shutdown
+    (2) Type name of the object and the check's message, file and line
+    (3) Call site: The return address in the function that made the
+        failing call, printed as module+offset for addr2line
+    (4) Thread id and sequence number
+
+    Recording costs nothing until a check fails: The checks are still one
+    branch each.  When the ring wraps the oldest records are overwritten,
+    but the per-kind totals keep counting.  The report groups the kept
+    records by call site, and is written to stderr at exit.
+
+    Define DI_TRACK_VIOLATIONS for the whole build to enable the log from
+    the start, e.g. for a load test in a checked build.  DependencyInjected.h
+    includes this header in debug builds only.  Checks in code that sees
+    just DependencyMembers.h reach the log through a tracker it installs.
+*/
+
+/*
+    Example Usage:
+
+
+    DependencyViolationLog::Get().Enable();
+
+    RunLoadTest();
+
+    // Or wait for the report at exit
+    DependencyViolationLog::Get().WriteReport(stderr);
+*/
+
+#include "DependencyMembers.h" // DependencyViolationKind, GetViolationTracker()
+#include "DependencyTypeName.h"
+#include "DependencyThreadId.h"
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <tuple>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if !defined(_MSC_VER)
+    #include <dlfcn.h>
+#endif // _MSC_VER
+
+// Number of records kept, a power of two
+#if !defined(DI_VIOLATION_LOG_CAPACITY)
+    #define DI_VIOLATION_LOG_CAPACITY 4096
+#endif // DI_VIOLATION_LOG_CAPACITY
+
+
+//------------------------------------------------------------------------------
+// DependencyViolationEvent
+
+DI_EXPORT struct DependencyViolationEvent
+{
+    DependencyViolationKind Kind = DependencyViolationKind::Count;
+    const char* TypeName = nullptr;
+    const char* Message = nullptr;
+    const char* File = nullptr;
+    int Line = 0;
+
+    // Return address in the function that made the failing call
+    const void* CallSite = nullptr;
+
+    uint32_t ThreadId = 0;
+
+    // Order among all violations since the log was cleared, from 0
+    uint64_t Sequence = 0;
+};
+
+// Short name for reports, e.g. "use-before-init"
+DI_EXPORT inline const char* GetViolationKindName(DependencyViolationKind kind)
+{
+    switch (kind)
+    {
+    case DependencyViolationKind::SetDependenciesAfterInitialize: return "set-deps-after-init";
+    case DependencyViolationKind::InitializeTwice: return "double-init";
+    case DependencyViolationKind::InitializeWithoutDependencies: return "init-without-deps";
+    case DependencyViolationKind::InitializeOutsideScope: return "init-outside-scope";
+    case DependencyViolationKind::UseBeforeInitialize: return "use-before-init";
+    case DependencyViolationKind::UseAfterShutdown: return "use-after-shutdown";
+    case DependencyViolationKind::DependencyNotSet: return "dependency-not-set";
+    case DependencyViolationKind::RequiredDependencyNull: return "required-null";
+    case DependencyViolationKind::MissedShutdown: return "missed-shutdown";
+    default: break;
+    }
+    return "unknown";
+}
+
+
+//------------------------------------------------------------------------------
+// DependencyViolationLog
+//
+// Process-wide.  Record() may be called from any thread.  Clear() must not
+// race with it
+
+DI_EXPORT class DependencyViolationLog
+{
+public:
+    static const uint64_t kCapacity = DI_VIOLATION_LOG_CAPACITY;
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "Capacity must be a power of two");
+
+    static DependencyViolationLog& Get()
+    {
+        static DependencyViolationLog log;
+        return log;
+    }
+
+    // Record violations instead of trapping
+    void Enable(bool reportAtExit = true)
+    {
+        ReportAtExit.store(reportAtExit, std::memory_order_relaxed);
+        Enabled.store(true, std::memory_order_release);
+    }
+    void Disable()
+    {
+        Enabled.store(false, std::memory_order_release);
+    }
+    bool IsEnabled() const
+    {
+        return Enabled.load(std::memory_order_acquire);
+    }
+
+    // Returns false if the log is disabled, so the check should trap
+    bool Record(
+        DependencyViolationKind kind,
+        const char* typeName,
+        const char* message,
+        const char* file,
+        int line,
+        const void* callSite)
+    {
+        if (!IsEnabled())
+            return false;
+
+        const uint64_t sequence = Next.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = Slots[sequence & (kCapacity - 1)];
+
+        KindCounts[static_cast<unsigned>(kind)].fetch_add(1, std::memory_order_relaxed);
+        InstallExitHook();
+
+        // Seqlock: Readers skip the slot while it is marked busy.  A writer
+        // drops its record if another writer holds the slot, or if a newer
+        // record already took it, so two writers never fill one slot
+        const uint64_t busy = kBusyBit | (sequence + 1);
+        uint64_t current = slot.Sequence.load(std::memory_order_acquire);
+        do
+        {
+            if ((current & kBusyBit) != 0 || current > sequence + 1)
+                return true;
+        } while (!slot.Sequence.compare_exchange_weak(current, busy,
+            std::memory_order_acq_rel, std::memory_order_acquire));
+
+        // Release stores: A reader that sees any of them also sees the busy
+        // mark when it checks the sequence again
+        slot.Kind.store(static_cast<uint8_t>(kind), std::memory_order_release);
+        slot.TypeName.store(typeName, std::memory_order_release);
+        slot.Message.store(message, std::memory_order_release);
+        slot.File.store(file, std::memory_order_release);
+        slot.Line.store(line, std::memory_order_release);
+        slot.CallSite.store(callSite, std::memory_order_release);
+        slot.ThreadId.store(DependencyDetail::GetTraceThreadId(), std::memory_order_release);
+
+        // Only this writer can clear its busy mark
+        slot.Sequence.store(sequence + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // All violations since the log was cleared, including overwritten ones
+    uint64_t GetTotalCount() const
+    {
+        return Next.load(std::memory_order_acquire);
+    }
+    uint64_t GetCount(DependencyViolationKind kind) const
+    {
+        return KindCounts[static_cast<unsigned>(kind)].load(std::memory_order_relaxed);
+    }
+
+    // Kept records, oldest first.  Records being written are skipped
+    std::vector<DependencyViolationEvent> GetEvents() const
+    {
+        std::vector<DependencyViolationEvent> events;
+
+        const uint64_t end = GetTotalCount();
+        const uint64_t begin = end > kCapacity ? end - kCapacity : 0;
+        events.reserve(static_cast<size_t>(end - begin));
+
+        for (uint64_t sequence = begin; sequence < end; ++sequence)
+        {
+            const Slot& slot = Slots[sequence & (kCapacity - 1)];
+
+            if (slot.Sequence.load(std::memory_order_acquire) != sequence + 1)
+                continue;
+
+            // Acquire loads keep the second sequence check after them
+            DependencyViolationEvent event;
+            event.Kind = static_cast<DependencyViolationKind>(slot.Kind.load(std::memory_order_acquire));
+            event.TypeName = slot.TypeName.load(std::memory_order_acquire);
+            event.Message = slot.Message.load(std::memory_order_acquire);
+            event.File = slot.File.load(std::memory_order_acquire);
+            event.Line = slot.Line.load(std::memory_order_acquire);
+            event.CallSite = slot.CallSite.load(std::memory_order_acquire);
+            event.ThreadId = slot.ThreadId.load(std::memory_order_acquire);
+            event.Sequence = sequence;
+
+            if (slot.Sequence.load(std::memory_order_acquire) != sequence + 1)
+                continue;
+
+            events.push_back(event);
+        }
+
+        return events;
+    }
+
+    void Clear()
+    {
+        for (Slot& slot : Slots)
+            slot.Sequence.store(0, std::memory_order_relaxed);
+        for (auto& count : KindCounts)
+            count.store(0, std::memory_order_relaxed);
+        Next.store(0, std::memory_order_release);
+    }
+
+    // Per-kind totals, then the kept records grouped by call site
+    void WriteReport(FILE* file) const
+    {
+        const std::vector<DependencyViolationEvent> events = GetEvents();
+
+        fprintf(file, "DependencyInjected: %llu usage violations (%u kept)\n",
+            static_cast<unsigned long long>(GetTotalCount()), static_cast<unsigned>(events.size()));
+
+        for (unsigned i = 0; i < static_cast<unsigned>(DependencyViolationKind::Count); ++i)
+        {
+            const DependencyViolationKind kind = static_cast<DependencyViolationKind>(i);
+            const uint64_t count = GetCount(kind);
+            if (count > 0)
+                fprintf(file, "  %-20s %llu\n", GetViolationKindName(kind), static_cast<unsigned long long>(count));
+        }
+
+        std::vector<const DependencyViolationEvent*> sorted;
+        sorted.reserve(events.size());
+        for (const DependencyViolationEvent& event : events)
+            sorted.push_back(&event);
+
+        auto key = [](const DependencyViolationEvent* e) {
+            return std::make_tuple(e->CallSite, static_cast<unsigned>(e->Kind), e->TypeName, e->File, e->Line);
+        };
+        std::stable_sort(sorted.begin(), sorted.end(),
+            [&key](const DependencyViolationEvent* a, const DependencyViolationEvent* b) {
+                return key(a) < key(b);
+            });
+
+        for (size_t i = 0; i < sorted.size();)
+        {
+            size_t j = i + 1;
+            while (j < sorted.size() && key(sorted[j]) == key(sorted[i]))
+                ++j;
+
+            const DependencyViolationEvent& e = *sorted[i];
+            char site[512];
+            FormatCallSite(e.CallSite, site, sizeof(site));
+
+            fprintf(file, "  %ux %s %s: %s (%s:%d) called from %s, first on thread %u\n",
+                static_cast<unsigned>(j - i), GetViolationKindName(e.Kind),
+                e.TypeName ? e.TypeName : "?", e.Message ? e.Message : "",
+                e.File ? e.File : "?", e.Line, site, e.ThreadId);
+            i = j;
+        }
+    }
+
+protected:
+    static const uint64_t kBusyBit = 1ull << 63;
+
+    struct Slot
+    {
+        // Record sequence + 1 once written, with kBusyBit while being written
+        std::atomic<uint64_t> Sequence{ 0 };
+        std::atomic<const char*> TypeName{ nullptr };
+        std::atomic<const char*> Message{ nullptr };
+        std::atomic<const char*> File{ nullptr };
+        std::atomic<const void*> CallSite{ nullptr };
+        std::atomic<int> Line{ 0 };
+        std::atomic<uint32_t> ThreadId{ 0 };
+        std::atomic<uint8_t> Kind{ 0 };
+    };
+
+    std::atomic<bool> Enabled{
+#if defined(DI_TRACK_VIOLATIONS)
+        true
+#else // DI_TRACK_VIOLATIONS
+        false
+#endif // DI_TRACK_VIOLATIONS
+    };
+    std::atomic<bool> ReportAtExit{ true };
+    std::atomic<bool> ExitHookInstalled{ false };
+    std::atomic<uint64_t> Next{ 0 };
+    std::atomic<uint64_t> KindCounts[static_cast<unsigned>(DependencyViolationKind::Count)] = {};
+    Slot Slots[kCapacity];
+
+    void InstallExitHook()
+    {
+        if (ReportAtExit.load(std::memory_order_relaxed) &&
+            !ExitHookInstalled.exchange(true, std::memory_order_relaxed))
+        {
+            atexit(&DependencyViolationLog::ReportAtExitHook);
+        }
+    }
+
+    static void ReportAtExitHook()
+    {
+        const DependencyViolationLog& log = Get();
+        if (log.GetTotalCount() > 0)
+            log.WriteReport(stderr);
+    }
+
+    // "module+0xoffset (symbol)" where the platform can tell
+    static void FormatCallSite(const void* callSite, char* text, size_t bytes)
+    {
+#if !defined(_MSC_VER)
+        Dl_info info;
+        if (callSite && dladdr(callSite, &info) && info.dli_fname)
+        {
+            const char* module = strrchr(info.dli_fname, '/');
+            module = module ? module + 1 : info.dli_fname;
+
+            const unsigned long long offset = static_cast<unsigned long long>(
+                static_cast<const char*>(callSite) - static_cast<const char*>(info.dli_fbase));
+
+            if (info.dli_sname)
+                snprintf(text, bytes, "%s+0x%llx (%s)", module, offset, info.dli_sname);
+            else
+                snprintf(text, bytes, "%s+0x%llx", module, offset);
+            return;
+        }
+#endif // _MSC_VER
+        snprintf(text, bytes, "%p", callSite);
+    }
+};
+
+
+//------------------------------------------------------------------------------
+// Check hook
+
+namespace DependencyDetail {
+
+inline bool RecordViolation(
+    DependencyViolationKind kind,
+    const char* typeName,
+    const char* message,
+    const char* file,
+    int line,
+    const void* callSite)
+{
+    return DependencyViolationLog::Get().Record(kind, typeName, message, file, line, callSite);
+}
+
+#if defined(DI_DEBUG)
+// Installs the log before main() in any program that includes this header
+inline const bool ViolationLogInstalled = (GetViolationTracker().store(&RecordViolation, std::memory_order_release), true);
+#endif // DI_DEBUG
+
+} // namespace DependencyDetail
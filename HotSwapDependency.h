@@ -0,0 +1,414 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    HotSwapDependency
+
+    Replaces the implementation behind an interface at runtime while other
+    threads keep calling through it, e.g. to swap a cache backend.
+
+    HotSwapInjected<I> holds the current implementation in an atomic
+    pointer.  Consumers hold a HotSwapDependency<I> in their Dependencies
+    struct, and each call through it is a single atomic load.
+
+    Old implementations are reclaimed with quiescent-state based RCU:
+    Every thread that calls through a HotSwapDependency holds a
+    HotSwapReader and calls Quiesce() at points where it holds no
+    references into the implementation, such as the top of its work loop.
+    Swap() publishes the new implementation, waits until every reader has
+    quiesced, and then calls Shutdown() on the old one.
+
+    The reader side never blocks.  Swap() blocks until all registered
+    readers have quiesced or unregistered.  A thread that holds a
+    HotSwapReader may call Swap() itself: Its own readers count as
+    quiesced by the call, so it must not keep references into the old
+    implementation across it.
+*/
+
+/*
+    Example Usage:
+
+
+    HotSwapDomain domain;
+    HotSwapInjected<IMyInterface> backend(domain);
+    DependencyInjected<MyImplementation> first, second;
+    DependencyInjected<SwapUser> user;
+
+    first.SetDependencies({
+    });
+    first.Initialize(10);
+    backend.Swap(first);
+
+    user.SetDependencies({
+        backend // Dependencies member is a HotSwapDependency<IMyInterface>
+    });
+    user.Initialize();
+
+    // Worker threads:
+    HotSwapReader reader(domain);
+    while (running)
+    {
+        user->DoThing();
+        reader.Quiesce();
+    }
+
+    // Control thread:
+    second.SetDependencies({
+    });
+    second.Initialize(20);
+    backend.Swap(second); // Shuts down first after readers quiesce
+
+    ...
+
+    user.Shutdown();
+    backend.Shutdown(); // Shuts down second
+*/
+
+#include "DependencyInjected.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+
+//------------------------------------------------------------------------------
+// HotSwapDomain
+//
+// Tracks the quiescent states of reader threads
+
+class HotSwapDomain
+{
+public:
+    explicit HotSwapDomain(unsigned maxReaders = 64)
+        : Slots(maxReaders)
+    {
+    }
+    ~HotSwapDomain()
+    {
+        // Catch readers that outlive the domain in debug mode
+        for (const ReaderSlot& slot : Slots)
+        {
+            DI_DEBUG_ASSERT(slot.Epoch.load(std::memory_order_relaxed) == kOffline);
+            (void)slot;
+        }
+    }
+
+    // Registers the calling thread as a reader.  Prefer HotSwapReader
+    unsigned RegisterReader()
+    {
+        for (;;)
+        {
+            for (unsigned i = 0; i < static_cast<unsigned>(Slots.size()); ++i)
+            {
+                uint64_t expected = kOffline;
+                if (Slots[i].Epoch.compare_exchange_strong(expected,
+                    GlobalEpoch.load(std::memory_order_seq_cst),
+                    std::memory_order_seq_cst))
+                {
+                    Slots[i].Owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+                    GetReaderDepth()++;
+                    return i;
+                }
+            }
+
+            // Catch too many concurrent readers in debug mode
+            DI_DEBUG_ASSERT(false);
+            std::this_thread::yield();
+        }
+    }
+    void UnregisterReader(unsigned slot)
+    {
+        DI_DEBUG_ASSERT(slot < Slots.size());
+        GetReaderDepth()--;
+        Slots[slot].Owner.store(std::thread::id(), std::memory_order_relaxed);
+        Slots[slot].Epoch.store(kOffline, std::memory_order_release);
+    }
+
+    // Announce that the reader holds no references to old implementations
+    DI_FORCE_INLINE void Quiesce(unsigned slot)
+    {
+        Slots[slot].Epoch.store(GlobalEpoch.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // Waits until every registered reader has quiesced since the call.
+    // Readers held by the calling thread count as quiesced, since waiting
+    // on them would never return
+    void Synchronize()
+    {
+        const uint64_t target = GlobalEpoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+        const std::thread::id self = std::this_thread::get_id();
+
+        for (const ReaderSlot& slot : Slots)
+        {
+            // Only this thread stores its own id, and clears it before it
+            // releases the slot, so a match is one of its current readers
+            if (slot.Owner.load(std::memory_order_relaxed) == self)
+                continue;
+
+            for (;;)
+            {
+                const uint64_t epoch = slot.Epoch.load(std::memory_order_acquire);
+                if (epoch == kOffline || epoch >= target)
+                    break;
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Number of HotSwapReaders held by the calling thread
+    static int& GetReaderDepth()
+    {
+        static thread_local int depth = 0;
+        return depth;
+    }
+
+protected:
+    static const uint64_t kOffline = 0;
+
+    struct alignas(DI_CACHE_LINE_BYTES) ReaderSlot
+    {
+        std::atomic<uint64_t> Epoch{ kOffline };
+
+        // Thread holding the slot, set after it is claimed
+        std::atomic<std::thread::id> Owner{ std::thread::id() };
+    };
+
+    // Starts above kOffline
+    alignas(DI_CACHE_LINE_BYTES) std::atomic<uint64_t> GlobalEpoch{ 1 };
+
+    // One cache line per reader so quiescing does not false share
+    std::vector<ReaderSlot> Slots;
+
+    // Deleted methods
+    HotSwapDomain(const HotSwapDomain&) = delete;
+    HotSwapDomain& operator=(const HotSwapDomain&) = delete;
+};
+
+
+//------------------------------------------------------------------------------
+// HotSwapReader
+//
+// RAII registration of a reader thread
+
+class HotSwapReader
+{
+public:
+    explicit HotSwapReader(HotSwapDomain& domain)
+        : Domain(domain)
+        , Slot(domain.RegisterReader())
+    {
+    }
+    ~HotSwapReader()
+    {
+        Domain.UnregisterReader(Slot);
+    }
+
+    DI_FORCE_INLINE void Quiesce()
+    {
+        Domain.Quiesce(Slot);
+    }
+
+protected:
+    HotSwapDomain& Domain;
+    unsigned Slot;
+
+    // Deleted methods
+    HotSwapReader(const HotSwapReader&) = delete;
+    HotSwapReader& operator=(const HotSwapReader&) = delete;
+};
+
+
+//------------------------------------------------------------------------------
+// HotSwapInjected
+//
+// Owns the current implementation of interface I
+
+template<class I>
+class HotSwapInjected
+{
+public:
+    explicit HotSwapInjected(HotSwapDomain& domain)
+        : Domain(domain)
+    {
+    }
+    ~HotSwapInjected()
+    {
+        // Catch missing Shutdown() in debug mode
+        DI_DEBUG_ASSERT(!IsInitialized());
+    }
+
+    // Publishes an initialized implementation.  The previous one is shut
+    // down after all readers have quiesced, other than those of the
+    // calling thread
+    template<class S, class... P>
+    void Swap(DependencyInjected<S, P...>& next)
+    {
+        // Catch swapping in an uninitialized object in debug mode
+        DI_DEBUG_ASSERT(next.IsInitialized());
+
+        // Types must be convertible e.g. implementation to interface
+        I* instance = next.GetObjectPtr();
+
+        Replace(instance, [&next]() {
+            next.Shutdown();
+        });
+    }
+
+    // Unpublishes and shuts down the current implementation
+    void Shutdown()
+    {
+        Replace(nullptr, std::function<void()>());
+    }
+
+    DI_FORCE_INLINE bool IsInitialized() const
+    {
+        return Current.load(std::memory_order_acquire) != nullptr;
+    }
+
+    DI_FORCE_INLINE I* Get() const
+    {
+        return Current.load(std::memory_order_acquire);
+    }
+
+    DI_FORCE_INLINE const std::atomic<I*>* GetCurrentPtr() const
+    {
+        return &Current;
+    }
+
+protected:
+    HotSwapDomain& Domain;
+    std::atomic<I*> Current{ nullptr };
+
+    // Serializes writers
+    std::mutex SwapLock;
+
+    // Shuts down the implementation in Current
+    std::function<void()> ShutdownCurrent;
+
+    void Replace(I* instance, std::function<void()> shutdown)
+    {
+        std::lock_guard<std::mutex> locker(SwapLock);
+
+        Current.store(instance, std::memory_order_seq_cst);
+        Domain.Synchronize();
+
+        // No reader can still hold the old instance
+        if (ShutdownCurrent)
+            ShutdownCurrent();
+        ShutdownCurrent = std::move(shutdown);
+    }
+
+    // Deleted methods
+    HotSwapInjected(const HotSwapInjected&) = delete;
+    HotSwapInjected& operator=(const HotSwapInjected&) = delete;
+};
+
+
+//------------------------------------------------------------------------------
+// HotSwapDependency
+//
+// Use this in a Dependencies list to refer to a HotSwapInjected interface.
+
+/*
+    Example:
+
+    struct Dependencies
+    {
+        HotSwapDependency<IMyInterface> backend;
+    };
+*/
+
+template<class T>
+class HotSwapDependency
+{
+protected:
+    const std::atomic<T*>* Current;
+
+public:
+    HotSwapDependency()
+    {
+        Current = nullptr;
+    }
+    HotSwapDependency(HotSwapInjected<T>& swappable)
+    {
+        Current = swappable.GetCurrentPtr();
+    }
+    HotSwapDependency(HotSwapInjected<T>* swappable)
+    {
+        Current = swappable ? swappable->GetCurrentPtr() : nullptr;
+    }
+
+    DI_FORCE_INLINE bool IsInitialized() const
+    {
+        return Get() != nullptr;
+    }
+
+    DI_FORCE_INLINE T* operator->() const
+    {
+        return Resolve();
+    }
+    DI_FORCE_INLINE T& operator*() const
+    {
+        return *Resolve();
+    }
+
+    // Current implementation or nullptr
+    DI_FORCE_INLINE T* Get() const
+    {
+        return Current ? Current->load(std::memory_order_acquire) : nullptr;
+    }
+
+protected:
+    DI_FORCE_INLINE T* Resolve() const
+    {
+        DI_DEBUG_ASSERT(Current != nullptr); // Dependency must be set before use
+
+        // Calling thread must hold a HotSwapReader
+        DI_DEBUG_ASSERT(HotSwapDomain::GetReaderDepth() > 0);
+
+        T* instance = Current->load(std::memory_order_acquire);
+        DI_DEBUG_ASSERT(instance != nullptr); // Implementation must be published before use
+        return instance;
+    }
+};
+
+template<class T>
+struct DependencyMemberTraits<HotSwapDependency<T>>
+{
+    typedef T Type;
+
+    static const bool IsDependency = true;
+    static const bool IsRequired = false;
+    static const bool IsLateBound = false;
+};
@@ -0,0 +1,335 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    LazyDependencyInjected
+
+    Wrapper that initializes its object on first use from any thread.
+
+    Expensive objects that most processes never touch can be deferred
+    instead of being initialized eagerly at startup.  After the object is
+    up, operator-> is a single acquire load and a branch.  Only the first
+    callers contend on a mutex while Initialize() runs.
+
+    Consumers refer to a lazy object with a LazyDependency<T> member in
+    their Dependencies struct.  It has the same fast path and does not
+    constrain initialization order in a DependencyContainer or
+    DependencyGraph, since the object initializes itself on demand.
+
+    Shutdown() must not race with users of the object.
+*/
+
+/*
+    Example Usage:
+
+
+    LazyDependencyInjected<MyImplementation> branch;
+    DependencyInjected<InterfaceUser> user;
+
+    branch.SetDependencies({
+    });
+    branch.SetInitializeArgs(10); // Arguments for the deferred Initialize()
+
+    user.SetDependencies({
+        branch // Dependencies member is a LazyDependency<IMyInterface>
+    });
+    user.Initialize();
+
+    user->DoThing(); // MyImplementation::Initialize() runs here
+
+    user.Shutdown();
+    branch.Shutdown();
+*/
+
+#include "DependencyInjected.h"
+
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+
+//------------------------------------------------------------------------------
+// LazyDependencyState
+//
+// Shared by LazyDependencyInjected and LazyDependency
+
+class LazyDependencyState
+{
+public:
+    DI_FORCE_INLINE bool IsReady() const
+    {
+        return State.load(std::memory_order_acquire) == kReady;
+    }
+
+    // Runs the deferred Initialize() once.  Returns false if it failed
+    bool EnsureInitialized()
+    {
+        if (IsReady())
+            return true;
+
+        std::lock_guard<std::mutex> locker(Lock);
+
+        const uint8_t state = State.load(std::memory_order_relaxed);
+        if (state != kUninitialized)
+            return state == kReady;
+
+        // Catch a missing SetInitializeArgs() in debug mode
+        DI_DEBUG_ASSERT(Initializer);
+
+        const bool success = Initializer && Initializer();
+        State.store(success ? kReady : kFailed, std::memory_order_release);
+        return success;
+    }
+
+protected:
+    static const uint8_t kUninitialized = 0;
+    static const uint8_t kReady = 1;
+    static const uint8_t kFailed = 2;
+
+    std::atomic<uint8_t> State{ kUninitialized };
+    std::mutex Lock;
+
+    // Initialize() with the arguments from SetInitializeArgs()
+    std::function<bool()> Initializer;
+
+    ~LazyDependencyState() = default;
+};
+
+
+//------------------------------------------------------------------------------
+// LazyDependencyInjected
+
+template<class T, class... Policies>
+class LazyDependencyInjected : public LazyDependencyState
+{
+public:
+    typedef typename T::Dependencies DepsT;
+    typedef DependencyInjected<T, Policies...> WrapperT;
+
+    LazyDependencyInjected()
+    {
+        // Objects whose Initialize() only takes dependencies need no arguments
+        if constexpr (HasDefaultInitialize<T>::value)
+            SetInitializeArgs();
+    }
+    // For ArenaStorage: Object memory is allocated from the resource
+    template<class R, typename std::enable_if<std::is_constructible<WrapperT, R&>::value, int>::type = 0>
+    explicit LazyDependencyInjected(R& resource)
+        : Wrapper(resource)
+    {
+        if constexpr (HasDefaultInitialize<T>::value)
+            SetInitializeArgs();
+    }
+
+    // Set dependencies
+    DI_FORCE_INLINE void SetDependencies(const DepsT& deps)
+    {
+        Wrapper.SetDependencies(deps);
+    }
+
+    // Set the arguments for the Initialize() that runs on first use
+    template<typename... Args>
+    void SetInitializeArgs(Args&&... args)
+    {
+        // Catch changing arguments after first use in debug mode
+        DI_DEBUG_ASSERT(State.load(std::memory_order_relaxed) == kUninitialized);
+
+        auto boundArgs = std::make_tuple(std::forward<Args>(args)...);
+        Initializer = [this, boundArgs]() mutable -> bool {
+            return std::apply([this](auto&... a) {
+                return DependencyDetail::InvokeInitialize(Wrapper, a...);
+            }, boundArgs);
+        };
+    }
+
+    // Initialize now instead of on first use
+    DI_FORCE_INLINE bool Initialize()
+    {
+        return EnsureInitialized();
+    }
+
+    // Shutdown the object if it was initialized.  Must not race with users
+    template<typename... Args>
+    void Shutdown(Args&&... args)
+    {
+        Wrapper.Shutdown(std::forward<Args>(args)...);
+        State.store(kUninitialized, std::memory_order_relaxed);
+    }
+
+    DI_FORCE_INLINE bool IsInitialized() const
+    {
+        return IsReady();
+    }
+
+    DI_FORCE_INLINE T* operator->()
+    {
+        return Get();
+    }
+    DI_FORCE_INLINE T& operator*()
+    {
+        return *Get();
+    }
+
+    // Initializes on first use.  Returns nullptr if Initialize() failed
+    DI_FORCE_INLINE T* Get()
+    {
+        if (!IsReady() && !EnsureInitialized())
+        {
+            DI_DEBUG_ASSERT(false); // Initialize() failed
+            return nullptr;
+        }
+        return GetObjectPtr();
+    }
+
+    // Object memory, valid before initialization
+    DI_FORCE_INLINE T* GetObjectPtr()
+    {
+        return Wrapper.GetObjectPtr();
+    }
+
+protected:
+    WrapperT Wrapper;
+
+    template<class U, class = void>
+    struct HasDefaultInitialize : std::false_type {};
+
+    template<class U>
+    struct HasDefaultInitialize<U, std::void_t<decltype(
+        std::declval<U&>().Initialize(std::declval<const typename U::Dependencies&>()))>>
+        : std::true_type {};
+
+    // Deleted methods
+    LazyDependencyInjected(const LazyDependencyInjected&) = delete;
+    LazyDependencyInjected& operator=(const LazyDependencyInjected&) = delete;
+};
+
+
+//------------------------------------------------------------------------------
+// LazyDependency
+//
+// Use this in a Dependencies list to refer to a LazyDependencyInjected object.
+
+/*
+    Example:
+
+    struct Dependencies
+    {
+        LazyDependency<IMyInterface> branch;
+    };
+*/
+
+template<class T>
+class LazyDependency
+{
+protected:
+    T* Reference;
+    LazyDependencyState* Lazy;
+
+public:
+    LazyDependency()
+    {
+        Reference = nullptr;
+        Lazy = nullptr;
+    }
+    template<class S, class... P>
+    LazyDependency(LazyDependencyInjected<S, P...>& lazy)
+    {
+        Lazy = &lazy;
+
+        // Types must be convertible e.g. implementation to interface
+        Reference = lazy.GetObjectPtr();
+    }
+    template<class S, class... P>
+    LazyDependency(LazyDependencyInjected<S, P...>* lazy)
+    {
+        Lazy = lazy;
+        if (lazy)
+        {
+            // Types must be convertible e.g. implementation to interface
+            Reference = lazy->GetObjectPtr();
+        }
+        else
+            Reference = nullptr;
+    }
+
+    DI_FORCE_INLINE bool IsInitialized() const
+    {
+        return Lazy != nullptr && Lazy->IsReady();
+    }
+
+    // A LazyDependency is set if it refers to an object, which is
+    // initialized on first use
+    DI_FORCE_INLINE operator bool() const
+    {
+        return Reference != nullptr;
+    }
+
+    DI_FORCE_INLINE T* operator->() const
+    {
+        return Resolve();
+    }
+    DI_FORCE_INLINE T& operator*() const
+    {
+        return *Resolve();
+    }
+
+    // Referenced object without initializing it
+    DI_FORCE_INLINE T* Get() const
+    {
+        return Reference;
+    }
+
+protected:
+    DI_FORCE_INLINE T* Resolve() const
+    {
+        DI_DEBUG_ASSERT(Lazy != nullptr); // Dependency must be set before use
+
+        if (!Lazy->IsReady() && !Lazy->EnsureInitialized())
+        {
+            DI_DEBUG_ASSERT(false); // Initialize() failed
+            return nullptr;
+        }
+        return Reference;
+    }
+};
+
+template<class T>
+struct DependencyMemberTraits<LazyDependency<T>>
+{
+    typedef T Type;
+
+    static const bool IsDependency = true;
+    static const bool IsRequired = false;
+
+    // Lazy objects initialize themselves, so they never constrain ordering
+    static const bool IsLateBound = true;
+};
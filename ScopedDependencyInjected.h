@@ -0,0 +1,817 @@
+/*
+    Copyright (c) 2017 Christopher A. Taylor.  All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+    * Neither the name of DependencyInjected nor the names of its contributors may be
+      used to endorse or promote products derived from this software without
+      specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+/*
+    ScopedDependencyInjected
+
+    Components that exist once per worker thread or once per request,
+    instead of once per process.
+
+    ThreadLocalInjected<T> holds the shared Dependencies for T.  Each worker
+    thread calls Initialize() to create its own instance and Shutdown() to
+    destroy it.  Instances are allocated by the owning thread on their own
+    cache lines.
+
+    RequestInjected<T> holds the shared Dependencies for T.  Each request
+    runs inside a RequestScope, and Initialize() creates the instance for
+    the current request in the scope's RequestArena.  When the scope ends,
+    its objects are shut down in reverse order and the arena is rewound in
+    one step, without freeing each object.  The arena keeps its memory for
+    the next request.
+
+    Consumers refer to scoped components with ThreadLocalDependency<T> or
+    RequestDependency<T> members in their Dependencies struct.  These
+    resolve to the calling thread's instance, or to the current request's
+    instance, through a table that only the calling thread touches: no
+    locks, no atomics, and no shared cache lines.
+
+    Each ThreadLocalInjected and RequestInjected takes a table slot that is
+    never reused, so they are meant for long-lived components.
+*/
+
+/*
+    Example Usage:
+
+
+    ThreadLocalInjected<ScratchBuffer> scratch;
+    RequestInjected<RequestContext> context;
+    DependencyInjected<Handler> handler;
+
+    scratch.SetDependencies({
+        allocator // Shared singleton
+    });
+    context.SetDependencies({
+        scratch // Dependencies member is a ThreadLocalDependency<ScratchBuffer>
+    });
+    handler.SetDependencies({
+        scratch,
+        context // Dependencies member is a RequestDependency<RequestContext>
+    });
+    handler.Initialize();
+
+    // Worker threads:
+    scratch.Initialize();
+    RequestArena arena;
+
+    while (running)
+    {
+        RequestScope scope(arena);
+        context.Initialize(request.Id);
+        handler->Handle(request); // Uses this thread's scratch and this request's context
+    } // context shut down, arena rewound
+
+    scratch.Shutdown();
+
+    // Control thread, after the workers are joined:
+    handler.Shutdown();
+*/
+
+#include "DependencyInjected.h"
+
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+
+
+//------------------------------------------------------------------------------
+// Scope slots
+
+namespace DependencyDetail {
+
+static const unsigned kNoScopeSlot = UINT_MAX;
+
+// Slot indices are never reused, so a stale table entry can never alias
+// a newer component
+template<class Tag>
+unsigned AllocateScopeSlot()
+{
+    static std::atomic<unsigned> next{ 0 };
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+struct ThreadSlotTag {};
+struct RequestSlotTag {};
+
+// Per-thread table of T pointers, indexed by ThreadLocalInjected slot.
+// Trivial so that the fast path needs no thread_local init guard
+struct ThreadSlotTable
+{
+    void** Slots;
+    unsigned Count;
+};
+
+DI_FORCE_INLINE ThreadSlotTable& GetThreadSlots()
+{
+    static thread_local ThreadSlotTable table = { nullptr, 0 };
+    return table;
+}
+
+DI_FORCE_INLINE void* FindThreadSlot(unsigned slot)
+{
+    const ThreadSlotTable& table = GetThreadSlots();
+    return slot < table.Count ? table.Slots[slot] : nullptr;
+}
+
+// Frees the calling thread's table when the thread exits
+struct ThreadSlotReleaser
+{
+    ~ThreadSlotReleaser()
+    {
+        ThreadSlotTable& table = GetThreadSlots();
+        free(table.Slots);
+        table.Slots = nullptr;
+        table.Count = 0;
+    }
+};
+
+inline void SetThreadSlot(unsigned slot, void* instance)
+{
+    ThreadSlotTable& table = GetThreadSlots();
+
+    if (slot >= table.Count)
+    {
+        static thread_local ThreadSlotReleaser releaser;
+        (void)releaser;
+
+        unsigned count = table.Count ? table.Count * 2 : 8;
+        while (count <= slot)
+            count *= 2;
+
+        void** slots = static_cast<void**>(realloc(table.Slots, count * sizeof(void*)));
+        if (!slots)
+            throw std::bad_alloc();
+        memset(slots + table.Count, 0, (count - table.Count) * sizeof(void*));
+
+        table.Slots = slots;
+        table.Count = count;
+    }
+
+    table.Slots[slot] = instance;
+}
+
+} // namespace DependencyDetail
+
+
+//------------------------------------------------------------------------------
+// ThreadLocalInjected
+//
+// One instance of T per thread that calls Initialize()
+
+template<class T, class... Policies>
+class ThreadLocalInjected
+{
+public:
+    typedef DependencyInjected<T, Policies...> WrapperT;
+    typedef typename WrapperT::DepsT DepsT;
+
+    ThreadLocalInjected()
+        : Slot(DependencyDetail::AllocateScopeSlot<DependencyDetail::ThreadSlotTag>())
+    {
+    }
+    ~ThreadLocalInjected()
+    {
+        // Catch threads that never called Shutdown() in debug mode
+        DI_DEBUG_ASSERT(Instances.empty());
+
+        ShutdownAll();
+    }
+
+    // Dependencies shared by every thread's instance.  Set before any
+    // thread calls Initialize()
+    void SetDependencies(const DepsT& deps)
+    {
+        // Catch setting dependencies while instances exist in debug mode
+        DI_DEBUG_ASSERT(Instances.empty());
+
+        Deps = deps;
+        SetDeps = true;
+        DI_COUNT_EDGES(T, Deps);
+    }
+
+    // Creates and initializes the calling thread's instance.
+    // Returns false and leaves no instance if T::Initialize() fails
+    template<typename... Args>
+    bool Initialize(Args&&... args)
+    {
+        // Catch double-initialization on this thread in debug mode
+        DI_CHECK(SetDeps && !IsInitialized(),
+            IsInitialized() ? DependencyViolationKind::InitializeTwice : DependencyViolationKind::InitializeWithoutDependencies, T,
+            "Initialize() twice on a thread or without SetDependencies()");
+
+        // Allocated by this thread on its own cache lines
+        ThreadInstance* node = new ThreadInstance;
+        node->Wrapper.SetDependencies(Deps);
+
+        if (!DependencyDetail::CallSucceeded([&]() { return node->Wrapper.Initialize(std::forward<Args>(args)...); }))
+        {
+            node->Wrapper.Shutdown();
+            delete node;
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> locker(InstancesLock);
+            Instances.push_back(node);
+        }
+
+        DependencyDetail::SetThreadSlot(Slot, node->Wrapper.GetObjectPtr());
+        return true;
+    }
+
+    // Shuts down the calling thread's instance
+    void Shutdown()
+    {
+        T* instance = Get();
+        if (!instance)
+            return;
+
+        DependencyDetail::SetThreadSlot(Slot, nullptr);
+
+        ThreadInstance* node = nullptr;
+        {
+            std::lock_guard<std::mutex> locker(InstancesLock);
+            for (size_t i = 0; i < Instances.size(); ++i)
+            {
+                if (Instances[i]->Wrapper.GetObjectPtr() == instance)
+                {
+                    node = Instances[i];
+                    Instances[i] = Instances.back();
+                    Instances.pop_back();
+                    break;
+                }
+            }
+        }
+
+        node->Wrapper.Shutdown();
+        delete node;
+    }
+
+    // Shuts down every instance, including the calling thread's and those
+    // left behind by threads that exited without calling Shutdown().  Any
+    // other thread that had an instance must have exited: Its slot would be
+    // left pointing at the freed instance
+    void ShutdownAll()
+    {
+        std::vector<ThreadInstance*> instances;
+        {
+            std::lock_guard<std::mutex> locker(InstancesLock);
+            instances.swap(Instances);
+        }
+
+        if (Get())
+            DependencyDetail::SetThreadSlot(Slot, nullptr);
+
+        for (ThreadInstance* node : instances)
+        {
+            node->Wrapper.Shutdown();
+            delete node;
+        }
+    }
+
+    // Calling thread's instance
+    DI_FORCE_INLINE bool IsInitialized() const
+    {
+        return Get() != nullptr;
+    }
+    DI_FORCE_INLINE T* Get() const
+    {
+        return static_cast<T*>(DependencyDetail::FindThreadSlot(Slot));
+    }
+    DI_FORCE_INLINE T* operator->() const
+    {
+        T* instance = Get();
+        DI_CHECK(instance != nullptr, DependencyViolationKind::UseBeforeInitialize, T,
+            "Thread-local object used before Initialize() on this thread");
+        return instance;
+    }
+
+    DI_FORCE_INLINE unsigned GetSlot() const
+    {
+        return Slot;
+    }
+
+    // Number of threads with an instance
+    size_t GetInstanceCount() const
+    {
+        std::lock_guard<std::mutex> locker(InstancesLock);
+        return Instances.size();
+    }
+
+protected:
+    struct alignas(DI_CACHE_LINE_BYTES) ThreadInstance
+    {
+        WrapperT Wrapper;
+    };
+
+    const unsigned Slot;
+
+    DepsT Deps;
+    bool SetDeps = false;
+
+    // Only touched by Initialize() and Shutdown(), never on access
+    mutable std::mutex InstancesLock;
+    std::vector<ThreadInstance*> Instances;
+
+    // Deleted methods
+    ThreadLocalInjected(const ThreadLocalInjected&) = delete;
+    ThreadLocalInjected& operator=(const ThreadLocalInjected&) = delete;
+};
+
+
+//------------------------------------------------------------------------------
+// RequestArena
+//
+// Memory and instance table for one request at a time.  Keep one per
+// worker thread and reuse it across requests
+
+class RequestArena
+{
+public:
+    explicit RequestArena(size_t blockBytes = 64 * 1024)
+        : BlockBytes(blockBytes)
+    {
+    }
+    ~RequestArena()
+    {
+        // Catch destroying the arena inside a RequestScope in debug mode
+        DI_DEBUG_ASSERT(!Active);
+
+        while (Head)
+        {
+            Block* next = Head->Next;
+            ::operator delete(Head, std::align_val_t(DI_CACHE_LINE_BYTES));
+            Head = next;
+        }
+    }
+
+    // Returns memory that lives until the end of the current request
+    void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+    {
+        for (;;)
+        {
+            if (Current)
+            {
+                const uintptr_t base = reinterpret_cast<uintptr_t>(Current + 1);
+                const uintptr_t start = (base + Used + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+                if (start + bytes <= base + Current->Bytes)
+                {
+                    Used = static_cast<size_t>(start + bytes - base);
+                    return reinterpret_cast<void*>(start);
+                }
+                if (Current->Next && bytes + alignment <= Current->Next->Bytes)
+                {
+                    Current = Current->Next;
+                    Used = 0;
+                    continue;
+                }
+            }
+
+            AddBlock(bytes + alignment);
+        }
+    }
+
+    // Instance in a RequestInjected slot for the current request, or nullptr
+    DI_FORCE_INLINE void* FindSlot(unsigned slot) const
+    {
+        return slot < Slots.size() ? Slots[slot] : nullptr;
+    }
+
+    // Bytes held across requests
+    size_t GetReservedBytes() const
+    {
+        size_t bytes = 0;
+        for (const Block* block = Head; block; block = block->Next)
+            bytes += block->Bytes;
+        return bytes;
+    }
+
+protected:
+    friend class RequestScope;
+    template<class T, class... Policies> friend class RequestInjected;
+
+    struct alignas(DI_CACHE_LINE_BYTES) Block
+    {
+        Block* Next;
+        size_t Bytes;
+    };
+
+    // Shuts down one object at the end of the request
+    struct Cleanup
+    {
+        void (*Destroy)(void* object);
+        void* Object;
+        Cleanup* Previous;
+    };
+
+    const size_t BlockBytes;
+    Block* Head = nullptr;
+    Block* Current = nullptr;
+    size_t Used = 0;
+
+    // Instances for the current request, indexed by RequestInjected slot
+    std::vector<void*> Slots;
+    std::vector<unsigned> UsedSlots;
+
+    // Most recently initialized object first
+    Cleanup* LastCleanup = nullptr;
+
+    bool Active = false;
+
+    // Inserts a block after Current, keeping the blocks after it for reuse
+    void AddBlock(size_t minBytes)
+    {
+        const size_t bytes = minBytes > BlockBytes ? minBytes : BlockBytes;
+        Block* block = static_cast<Block*>(::operator new(sizeof(Block) + bytes, std::align_val_t(DI_CACHE_LINE_BYTES)));
+        block->Bytes = bytes;
+
+        if (Current)
+        {
+            block->Next = Current->Next;
+            Current->Next = block;
+        }
+        else
+        {
+            block->Next = Head;
+            Head = block;
+        }
+
+        Current = block;
+        Used = 0;
+    }
+
+    void SetSlot(unsigned slot, void* instance)
+    {
+        if (slot >= Slots.size())
+            Slots.resize(slot + 1, nullptr);
+        Slots[slot] = instance;
+        UsedSlots.push_back(slot);
+    }
+
+    // Shuts down every object and rewinds the memory
+    void Release()
+    {
+        for (Cleanup* cleanup = LastCleanup; cleanup; cleanup = cleanup->Previous)
+            cleanup->Destroy(cleanup->Object);
+        LastCleanup = nullptr;
+
+        for (unsigned slot : UsedSlots)
+            Slots[slot] = nullptr;
+        UsedSlots.clear();
+
+        Current = Head;
+        Used = 0;
+    }
+
+    // Deleted methods
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+};
+
+
+//------------------------------------------------------------------------------
+// RequestScope
+//
+// RAII scope of one request on the calling thread.  Scopes may nest, and
+// the innermost scope is the current one
+
+class RequestScope
+{
+public:
+    explicit RequestScope(RequestArena& arena)
+        : Arena(arena)
+        , Previous(GetCurrent())
+    {
+        // Catch sharing an arena between concurrent scopes in debug mode
+        DI_DEBUG_ASSERT(!arena.Active);
+
+        Arena.Active = true;
+        GetCurrent() = this;
+    }
+    ~RequestScope()
+    {
+        // Catch scopes ending out of order in debug mode
+        DI_DEBUG_ASSERT(GetCurrent() == this);
+
+        Arena.Release();
+        Arena.Active = false;
+        GetCurrent() = Previous;
+    }
+
+    DI_FORCE_INLINE RequestArena& GetArena() const
+    {
+        return Arena;
+    }
+
+    // Innermost scope on the calling thread, or nullptr
+    static DI_FORCE_INLINE RequestScope*& GetCurrent()
+    {
+        static thread_local RequestScope* current = nullptr;
+        return current;
+    }
+
+protected:
+    RequestArena& Arena;
+    RequestScope* Previous;
+
+    // Deleted methods
+    RequestScope(const RequestScope&) = delete;
+    RequestScope& operator=(const RequestScope&) = delete;
+};
+
+
+//------------------------------------------------------------------------------
+// RequestInjected
+//
+// One instance of T per request that calls Initialize()
+
+template<class T, class... Policies>
+class RequestInjected
+{
+public:
+    typedef DependencyInjected<T, Policies...> WrapperT;
+    typedef typename WrapperT::DepsT DepsT;
+
+    RequestInjected()
+        : Slot(DependencyDetail::AllocateScopeSlot<DependencyDetail::RequestSlotTag>())
+    {
+    }
+
+    // Dependencies shared by every request's instance
+    void SetDependencies(const DepsT& deps)
+    {
+        Deps = deps;
+        SetDeps = true;
+        DI_COUNT_EDGES(T, Deps);
+    }
+
+    // Creates and initializes the instance for the current RequestScope.
+    // It is shut down when the scope ends.
+    // Returns false and leaves no instance if T::Initialize() fails
+    template<typename... Args>
+    bool Initialize(Args&&... args)
+    {
+        RequestScope* scope = RequestScope::GetCurrent();
+
+        // Catch Initialize() outside a RequestScope or twice per request in debug mode
+        DI_CHECK(SetDeps && scope && !IsInitialized(),
+            !scope ? DependencyViolationKind::InitializeOutsideScope :
+                IsInitialized() ? DependencyViolationKind::InitializeTwice : DependencyViolationKind::InitializeWithoutDependencies, T,
+            "Initialize() outside a RequestScope, twice, or without SetDependencies()");
+
+        RequestArena& arena = scope->GetArena();
+        WrapperT* wrapper = new (arena.Allocate(sizeof(WrapperT), alignof(WrapperT))) WrapperT();
+        wrapper->SetDependencies(Deps);
+
+        if (!DependencyDetail::CallSucceeded([&]() { return wrapper->Initialize(std::forward<Args>(args)...); }))
+        {
+            // Memory is reclaimed with the rest of the request
+            wrapper->Shutdown();
+            wrapper->~WrapperT();
+            return false;
+        }
+
+        RequestArena::Cleanup* cleanup = static_cast<RequestArena::Cleanup*>(
+            arena.Allocate(sizeof(RequestArena::Cleanup), alignof(RequestArena::Cleanup)));
+        cleanup->Destroy = &RequestInjected::Destroy;
+        cleanup->Object = wrapper;
+        cleanup->Previous = arena.LastCleanup;
+        arena.LastCleanup = cleanup;
+
+        arena.SetSlot(Slot, wrapper->GetObjectPtr());
+        return true;
+    }
+
+    // Current request's instance
+    DI_FORCE_INLINE bool IsInitialized() const
+    {
+        return Get() != nullptr;
+    }
+    DI_FORCE_INLINE T* Get() const
+    {
+        RequestScope* scope = RequestScope::GetCurrent();
+        return scope ? static_cast<T*>(scope->GetArena().FindSlot(Slot)) : nullptr;
+    }
+    DI_FORCE_INLINE T* operator->() const
+    {
+        T* instance = Get();
+        DI_CHECK(instance != nullptr, DependencyViolationKind::UseBeforeInitialize, T,
+            "Request object used before Initialize() in this request");
+        return instance;
+    }
+
+    DI_FORCE_INLINE unsigned GetSlot() const
+    {
+        return Slot;
+    }
+
+protected:
+    const unsigned Slot;
+
+    DepsT Deps;
+    bool SetDeps = false;
+
+    static void Destroy(void* object)
+    {
+        WrapperT* wrapper = static_cast<WrapperT*>(object);
+        wrapper->Shutdown();
+        wrapper->~WrapperT();
+    }
+
+    // Deleted methods
+    RequestInjected(const RequestInjected&) = delete;
+    RequestInjected& operator=(const RequestInjected&) = delete;
+};
+
+
+//------------------------------------------------------------------------------
+// ThreadLocalDependency
+//
+// Use this in a Dependencies list to refer to a ThreadLocalInjected object.
+// Resolves to the calling thread's instance
+
+/*
+    Example:
+
+    struct Dependencies
+    {
+        ThreadLocalDependency<ScratchBuffer> scratch;
+    };
+*/
+
+template<class T>
+class ThreadLocalDependency
+{
+protected:
+    unsigned Slot;
+
+public:
+    ThreadLocalDependency()
+    {
+        Slot = DependencyDetail::kNoScopeSlot;
+    }
+    template<class... P>
+    ThreadLocalDependency(ThreadLocalInjected<T, P...>& scoped)
+    {
+        Slot = scoped.GetSlot();
+    }
+    template<class... P>
+    ThreadLocalDependency(ThreadLocalInjected<T, P...>* scoped)
+    {
+        Slot = scoped ? scoped->GetSlot() : DependencyDetail::kNoScopeSlot;
+    }
+
+    // Calling thread has an instance
+    DI_FORCE_INLINE bool IsInitialized() const
+    {
+        return Get() != nullptr;
+    }
+
+    DI_FORCE_INLINE T* operator->() const
+    {
+        return Resolve();
+    }
+    DI_FORCE_INLINE T& operator*() const
+    {
+        return *Resolve();
+    }
+
+    // Calling thread's instance or nullptr
+    DI_FORCE_INLINE T* Get() const
+    {
+        return static_cast<T*>(DependencyDetail::FindThreadSlot(Slot));
+    }
+
+protected:
+    DI_FORCE_INLINE T* Resolve() const
+    {
+        T* instance = Get();
+        DI_CHECK(instance != nullptr, DependencyViolationKind::UseBeforeInitialize, T,
+            "Thread-local dependency used before Initialize() on this thread");
+        return instance;
+    }
+};
+
+template<class T>
+struct DependencyMemberTraits<ThreadLocalDependency<T>>
+{
+    typedef T Type;
+
+    // Resolved per thread at the point of use, so not an ordering edge
+    static const bool IsDependency = true;
+    static const bool IsRequired = true;
+    static const bool IsLateBound = true;
+};
+
+
+//------------------------------------------------------------------------------
+// RequestDependency
+//
+// Use this in a Dependencies list to refer to a RequestInjected object.
+// Resolves to the instance of the calling thread's current RequestScope
+
+/*
+    Example:
+
+    struct Dependencies
+    {
+        RequestDependency<RequestContext> context;
+    };
+*/
+
+template<class T>
+class RequestDependency
+{
+protected:
+    unsigned Slot;
+
+public:
+    RequestDependency()
+    {
+        Slot = DependencyDetail::kNoScopeSlot;
+    }
+    template<class... P>
+    RequestDependency(RequestInjected<T, P...>& scoped)
+    {
+        Slot = scoped.GetSlot();
+    }
+    template<class... P>
+    RequestDependency(RequestInjected<T, P...>* scoped)
+    {
+        Slot = scoped ? scoped->GetSlot() : DependencyDetail::kNoScopeSlot;
+    }
+
+    // Current request has an instance
+    DI_FORCE_INLINE bool IsInitialized() const
+    {
+        return Get() != nullptr;
+    }
+
+    DI_FORCE_INLINE T* operator->() const
+    {
+        return Resolve();
+    }
+    DI_FORCE_INLINE T& operator*() const
+    {
+        return *Resolve();
+    }
+
+    // Current request's instance or nullptr
+    DI_FORCE_INLINE T* Get() const
+    {
+        RequestScope* scope = RequestScope::GetCurrent();
+        return scope ? static_cast<T*>(scope->GetArena().FindSlot(Slot)) : nullptr;
+    }
+
+protected:
+    DI_FORCE_INLINE T* Resolve() const
+    {
+        T* instance = Get();
+        DI_CHECK(instance != nullptr, DependencyViolationKind::UseBeforeInitialize, T,
+            "Request dependency used outside a RequestScope or before Initialize()");
+        return instance;
+    }
+};
+
+template<class T>
+struct DependencyMemberTraits<RequestDependency<T>>
+{
+    typedef T Type;
+
+    // Resolved per request at the point of use, so not an ordering edge
+    static const bool IsDependency = true;
+    static const bool IsRequired = true;
+    static const bool IsLateBound = true;
+};
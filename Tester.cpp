@@ -2,11 +2,59 @@
     Unit Tester for DependencyInjected Pattern
 */
 
+// Exercise the tracing hooks in every test
+#define DI_TRACE
+
+// The light headers come first, so the build checks that they stand alone
+#include "DependencyInjectedFwd.h"
+#include "DependencyMembers.h"
 #include "DependencyInjected.h"
+#include "DependencyArenaStorage.h"
+#include "DependencyContainer.h"
+#include "DependencyGraph.h"
+#include "DependencyInjectedPool.h"
+#include "LazyDependencyInjected.h"
+#include "HotSwapDependency.h"
+#include "DependencyInjectedBatch.h"
+#include "DependencySnapshot.h"
+#include "DependencyAsync.h"
+#include "ScopedDependencyInjected.h"
+#include "DependencyRegistry.h"
+#include "DependencyNuma.h"
+#include "DependencyViolationLog.h"
 
 #include <iostream>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <memory_resource>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <algorithm>
+
+#if !defined(_WIN32)
+    #include <unistd.h>
+    #include <sys/wait.h>
+    #include <cerrno>
+#endif // _WIN32
 using namespace std;
 
+DI_TRACE_ALLOCATION_HOOKS();
+
+
+// Fails the test even outside of debug mode
+#if defined(_WIN32)
+    #define TEST_CHECK(cond) { if (!(cond)) { __debugbreak(); } }
+#else // _WIN32
+    #define TEST_CHECK(cond) { if (!(cond)) { __builtin_trap(); } }
+#endif // _WIN32
+
 
 class Cog;
 class Widget;
@@ -309,221 +357,3280 @@ private:
 
 
 //------------------------------------------------------------------------------
-// Tests
+// ChainObject
 
-void Test_ThirdPartyObject()
+class ChainObject
 {
-    // Verifies that we can also inject code from third party developers
-    DependencyInjected<ThirdPartyClassUser> user;
-    ThirdPartyClass third;
+public:
+    struct Dependencies
+    {
+        OptionalDependency<ChainObject> previous;
+    };
 
-    user.SetDependencies({
-        &third
-    });
+    bool Initialize(const Dependencies& deps)
+    {
+        Deps = deps;
 
-    user.Initialize();
+        // Previous link must already be up
+        Depth = Deps.previous ? Deps.previous->GetDepth() + 1 : 0;
+        Ready = true;
+        return true;
+    }
+    void Shutdown()
+    {
+        Ready = false;
+    }
 
-    user->DoThing();
+    int GetDepth() const
+    {
+        TEST_CHECK(Ready);
+        return Depth;
+    }
 
-    user.Shutdown();
-}
+private:
+    Dependencies Deps;
+    int Depth = -1;
+    bool Ready = false;
+};
 
-void Test_PeerObjects()
+
+//------------------------------------------------------------------------------
+// FanInObject
+
+class FanInObject
 {
-    DependencyInjected<Cog> cog;
-    DependencyInjected<Widget> widget;
+public:
+    struct Dependencies
+    {
+        RequiredDependency<ChainObject> a;
+        RequiredDependency<ChainObject> b;
+        RequiredDependency<ChainObject> c;
+    };
 
-    cog.SetDependencies({
-        &widget,
-        nullptr // optional dependency
-    });
-    widget.SetDependencies({
-        cog
-    });
+    bool Initialize(const Dependencies& deps, int bias)
+    {
+        Deps = deps;
+        Sum = Deps.a->GetDepth() + Deps.b->GetDepth() + Deps.c->GetDepth() + bias;
+        return true;
+    }
+    void Shutdown()
+    {
+    }
 
-    cog.Initialize();
-    widget.Initialize(15);
+    int GetSum() const
+    {
+        return Sum;
+    }
 
-    cog->DoCogThing();
+private:
+    Dependencies Deps;
+    int Sum = 0;
+};
 
-    widget.Shutdown();
-    cog.Shutdown();
-}
 
-void Test_NestedDeps()
-{
-    DependencyInjected<BranchObject> branch;
+//------------------------------------------------------------------------------
+// Pulley and Belt: Peer objects with the cycle broken by a LateBound edge
 
-    branch.SetDependencies({
-    });
+class Belt;
 
-    branch.Initialize(10);
+class Pulley
+{
+public:
+    struct Dependencies
+    {
+        // Only used after both objects are initialized
+        LateBound<RequiredDependency<Belt>> belt;
+    };
 
-    cout << "branch->DoThing() = " << branch->DoThing() << endl;
-    cout << "branch->DoThing() = " << branch->DoThing() << endl;
-    cout << "branch->DoThing() = " << branch->DoThing() << endl;
+    bool Initialize(const Dependencies& deps)
+    {
+        cout << "Pulley::Initialize()" << endl;
+        Deps = deps;
+        return true;
+    }
+    void Shutdown()
+    {
+        cout << "Pulley::Shutdown()" << endl;
+    }
 
-    branch.Shutdown();
-}
+    int Turn();
 
-void Test_DerivedClass()
+private:
+    Dependencies Deps;
+};
+
+class Belt
 {
-    DependencyInjected<MyImplementation> branch;
-    DependencyInjected<InterfaceUser> user;
+public:
+    struct Dependencies
+    {
+        RequiredDependency<Pulley> pulley;
+    };
 
-    branch.SetDependencies({
-    });
-    user.SetDependencies({
-        branch
-    });
+    bool Initialize(const Dependencies& deps, int teeth)
+    {
+        cout << "Belt::Initialize()" << endl;
+        Deps = deps;
+        Teeth = teeth;
+        return true;
+    }
+    void Shutdown()
+    {
+        cout << "Belt::Shutdown()" << endl;
+    }
 
-    branch.Initialize(10);
-    user.Initialize();
+    int GetTeeth() const
+    {
+        return Teeth;
+    }
 
-    cout << "user->DoThing() = " << user->DoThing() << endl;
-    cout << "user->DoThing() = " << user->DoThing() << endl;
-    cout << "user->DoThing() = " << user->DoThing() << endl;
+private:
+    Dependencies Deps;
+    int Teeth = 0;
+};
 
-    branch.Shutdown();
-    user.Shutdown();
+int Pulley::Turn()
+{
+    return Deps.belt->GetTeeth();
 }
 
-void Test_Forget_SetDep()
+
+//------------------------------------------------------------------------------
+// WideObject: Over-aligned like an object with SIMD members
+
+class WideObject
 {
-    DependencyInjected<Cog> cog;
-    DependencyInjected<Widget> widget;
+public:
+    struct Dependencies
+    {
+    };
 
-    DependencyInjected<Widget>* nullWidget = nullptr;
+    bool Initialize(const Dependencies& deps)
+    {
+        for (int i = 0; i < 8; ++i)
+            Lanes[i] = static_cast<float>(i);
+        return true;
+    }
+    void Shutdown()
+    {
+    }
 
-    // Note: It will actually fail to compile if nullptr is passed directly here
-    cog.SetDependencies({
-        nullWidget, // &widget
-        nullptr
-    });
-#if 0
-    widget.SetDependencies({
-        cog
-    });
+    float Sum() const
+    {
+        float sum = 0.f;
+        for (int i = 0; i < 8; ++i)
+            sum += Lanes[i];
+        return sum;
+    }
 
-    cog.Initialize();
-    widget.Initialize(15);
+private:
+    alignas(32) float Lanes[8];
+};
 
-    cog->DoCogThing();
 
-    widget.Shutdown();
-    cog.Shutdown();
-#endif
-}
+//------------------------------------------------------------------------------
+// TableObject: Takes large and move-only arguments
 
-void Test_Forget_InitCog()
+class TableObject
 {
-    DependencyInjected<Cog> cog;
-    DependencyInjected<Widget> widget;
+public:
+    struct Dependencies
+    {
+        OptionalDependency<LeafObject> leaf;
 
-    cog.SetDependencies({
-        &widget,
-        nullptr
-    });
-    widget.SetDependencies({
-        cog
-    });
+        // Large configuration that should be moved rather than copied
+        std::vector<int> weights;
+    };
 
-    //cog.Initialize();
-    widget.Initialize(15);
+    bool Initialize(Dependencies&& deps, std::unique_ptr<std::vector<int>> table, std::vector<int>&& extra)
+    {
+        Deps = std::move(deps);
+        Table = std::move(table);
+        Extra = std::move(extra);
+        return Table != nullptr;
+    }
+    bool Initialize(const Dependencies& deps, std::unique_ptr<std::vector<int>> table, std::vector<int>&& extra)
+    {
+        Dependencies copy = deps;
+        return Initialize(std::move(copy), std::move(table), std::move(extra));
+    }
+    void Shutdown()
+    {
+    }
 
-    cog->DoCogThing();
+    size_t GetSize() const
+    {
+        return Deps.weights.size() + Table->size() + Extra.size();
+    }
+    const int* GetWeightsData() const
+    {
+        return Deps.weights.data();
+    }
+    const int* GetExtraData() const
+    {
+        return Extra.data();
+    }
 
-    widget.Shutdown();
-    cog.Shutdown();
-}
+private:
+    Dependencies Deps;
+    std::unique_ptr<std::vector<int>> Table;
+    std::vector<int> Extra;
+};
 
-void Test_Forget_InitWidget()
+
+//------------------------------------------------------------------------------
+// ScratchObject: Large inline buffer that its constructor does not clear
+
+class ScratchObject
 {
-    DependencyInjected<Cog> cog;
-    DependencyInjected<Widget> widget;
+public:
+    struct Dependencies
+    {
+    };
 
-    cog.SetDependencies({
-        &widget,
-        nullptr
-    });
-    widget.SetDependencies({
-        cog
-    });
+    ScratchObject()
+    {
+    }
 
-    cog.Initialize();
-    //widget.Initialize(15);
+    bool Initialize(const Dependencies& deps, unsigned char fill)
+    {
+        memset(Scratch, fill, sizeof(Scratch));
+        return true;
+    }
+    void Shutdown()
+    {
+    }
 
-    cog->DoCogThing();
+private:
+    unsigned char Scratch[16384];
+};
 
-    widget.Shutdown();
-    cog.Shutdown();
+// True if every byte of object memory left by Shutdown() equals value
+static bool ObjectMemoryIs(void* memory, size_t bytes, unsigned char value)
+{
+    const unsigned char* bytePtr = static_cast<const unsigned char*>(memory);
+    for (size_t i = 0; i < bytes; ++i)
+        if (bytePtr[i] != value)
+            return false;
+    return true;
 }
 
-void Test_Forget_ShutdownWidget()
+#if defined(DI_SANITIZER) && !defined(DI_DEBUG)
+// True if FastReset filled the object memory with DI_POISON_BYTE, and under
+// ASan also poisoned it
+static bool ObjectMemoryIsPoisoned(void* memory, size_t bytes)
 {
-    DependencyInjected<Cog> cog;
-    DependencyInjected<Widget> widget;
-
-    cog.SetDependencies({
-        &widget,
-        nullptr
-    });
-    widget.SetDependencies({
-        cog
-    });
+#if defined(DI_ASAN)
+    unsigned char* bytePtr = static_cast<unsigned char*>(memory);
+    if (!__asan_address_is_poisoned(bytePtr) || !__asan_address_is_poisoned(bytePtr + bytes - 1))
+        return false;
+
+    DI_ASAN_UNPOISON(memory, bytes);
+    const bool filled = ObjectMemoryIs(memory, bytes, DI_POISON_BYTE);
+    DI_ASAN_POISON(memory, bytes);
+    return filled;
+#else // DI_ASAN
+    return ObjectMemoryIs(memory, bytes, DI_POISON_BYTE);
+#endif // DI_ASAN
+}
+#endif // DI_SANITIZER && !DI_DEBUG
 
-    cog.Initialize();
-    widget.Initialize(15);
 
-    cog->DoCogThing();
+//------------------------------------------------------------------------------
+// Session: One per client connection
 
-    //widget.Shutdown();
-    cog.Shutdown();
+class Session
+{
+public:
+    struct Dependencies
+    {
+        RequiredDependency<LeafObject> leaf;
+    };
+
+    bool Initialize(const Dependencies& deps, int clientId)
+    {
+        Deps = deps;
+        ClientId = clientId;
+
+        // Client ids below zero are rejected
+        return clientId >= 0;
+    }
+    void Shutdown()
+    {
+        ClientId = -1;
+    }
+
+    int GetClientId() const
+    {
+        return ClientId;
+    }
+    int Tick()
+    {
+        return Deps.leaf->DoThing();
+    }
+
+private:
+    Dependencies Deps;
+    int ClientId = -1;
+};
+
+
+//------------------------------------------------------------------------------
+// LazyUser
+
+class CountedService
+{
+public:
+    struct Dependencies
+    {
+    };
+
+    static std::atomic<int> InitializeCount;
+
+    bool Initialize(const Dependencies& deps)
+    {
+        (void)deps;
+        InitializeCount++;
+        Value = 42;
+        return true;
+    }
+    void Shutdown()
+    {
+        Value = 0;
+    }
+
+    int GetValue() const
+    {
+        return Value;
+    }
+
+private:
+    int Value = 0;
+};
+
+std::atomic<int> CountedService::InitializeCount{ 0 };
+
+class LazyUser
+{
+public:
+    struct Dependencies
+    {
+        LazyDependency<IMyInterface> Branch;
+    };
+
+    bool Initialize(const Dependencies& deps)
+    {
+        Deps = deps;
+        return true;
+    }
+    void Shutdown()
+    {
+    }
+
+    int DoThing()
+    {
+        return Deps.Branch->DoThing();
+    }
+
+private:
+    Dependencies Deps;
+};
+
+
+//------------------------------------------------------------------------------
+// SwapUser
+
+class ConstantImplementation : public IMyInterface
+{
+public:
+    struct Dependencies
+    {
+    };
+
+    bool Initialize(const Dependencies& deps, int value)
+    {
+        (void)deps;
+        Value = value;
+        return true;
+    }
+    void Shutdown()
+    {
+        Value = -1;
+    }
+
+    int DoThing() override
+    {
+        return Value;
+    }
+
+private:
+    int Value = -1;
+};
+
+class SwapUser
+{
+public:
+    struct Dependencies
+    {
+        HotSwapDependency<IMyInterface> Backend;
+    };
+
+    bool Initialize(const Dependencies& deps)
+    {
+        Deps = deps;
+        return true;
+    }
+    void Shutdown()
+    {
+    }
+
+    int DoThing()
+    {
+        return Deps.Backend->DoThing();
+    }
+
+private:
+    Dependencies Deps;
+};
+
+
+//------------------------------------------------------------------------------
+// AdderUser
+
+class IAdder
+{
+public:
+    virtual ~IAdder() {}
+
+    virtual int Add(int x) = 0;
+};
+
+class Adder final : public IAdder
+{
+public:
+    struct Dependencies
+    {
+    };
+
+    bool Initialize(const Dependencies& deps, int offset)
+    {
+        (void)deps;
+        Offset = offset;
+        return true;
+    }
+    void Shutdown()
+    {
+    }
+
+    int Add(int x) override
+    {
+        return x + Offset;
+    }
+
+private:
+    int Offset = 0;
+};
+
+class MockAdder : public IAdder
+{
+public:
+    struct Dependencies
+    {
+    };
+
+    bool Initialize(const Dependencies& deps)
+    {
+        (void)deps;
+        return true;
+    }
+    void Shutdown()
+    {
+    }
+
+    int Add(int x) override
+    {
+        return x;
+    }
+};
+
+// Production builds would declare this in a shared bindings header
+DI_BIND_IMPLEMENTATION(IAdder, Adder);
+
+class AdderUser
+{
+public:
+    struct Dependencies
+    {
+        RequiredDependency<IAdder> adder;
+    };
+
+    bool Initialize(const Dependencies& deps)
+    {
+        Deps = deps;
+        return true;
+    }
+    void Shutdown()
+    {
+    }
+
+    int Sum(int count)
+    {
+        int sum = 0;
+        for (int i = 0; i < count; ++i)
+            sum = Deps.adder->Add(sum); // Direct call to Adder::Add()
+        return sum;
+    }
+
+private:
+    Dependencies Deps;
+};
+
+static_assert(std::is_same<decltype(std::declval<RequiredDependency<IAdder>&>().operator->()), Adder*>::value,
+    "Bound interface must call through the implementation");
+static_assert(std::is_same<decltype(std::declval<RequiredDependency<IMyInterface>&>().operator->()), IMyInterface*>::value,
+    "Unbound interface must call through the interface");
+
+
+//------------------------------------------------------------------------------
+// ForwardUser
+//
+// Declares its Dependencies against a type that is only forward declared,
+// like a component header that includes just DependencyMembers.h
+
+class ForwardTarget;
+
+class ForwardUser
+{
+public:
+    struct Dependencies
+    {
+        RequiredDependency<ForwardTarget> target;
+        OptionalDependency<ForwardTarget> optionalTarget;
+    };
+
+    bool Initialize(const Dependencies& deps);
+    void Shutdown()
+    {
+    }
+
+    int GetTargetValue() const;
+
+private:
+    Dependencies Deps;
+};
+
+class ForwardTarget
+{
+public:
+    struct Dependencies
+    {
+    };
+
+    void Initialize(const Dependencies& deps, int value)
+    {
+        (void)deps;
+        Value = value;
+    }
+    void Shutdown()
+    {
+    }
+
+    int Value = 0;
+};
+
+// Would live in ForwardUser.cpp, the one file that includes the target
+bool ForwardUser::Initialize(const Dependencies& deps)
+{
+    Deps = deps;
+    return !Deps.optionalTarget;
+}
+
+int ForwardUser::GetTargetValue() const
+{
+    return Deps.target->Value;
+}
+
+
+//------------------------------------------------------------------------------
+// BufferObject
+
+class BufferObject
+{
+public:
+    struct Dependencies
+    {
+        RequiredDependency<IMyInterface> Branch;
+    };
+
+    bool Initialize(const Dependencies& deps)
+    {
+        Deps = deps;
+        Buffer.resize(256);
+        return true;
+    }
+    void Shutdown()
+    {
+        Buffer.clear();
+    }
+
+private:
+    Dependencies Deps;
+    std::vector<int> Buffer;
+};
+
+
+//------------------------------------------------------------------------------
+// DrainingObject
+
+class DrainingObject
+{
+public:
+    struct Dependencies
+    {
+        OptionalDependency<DrainingObject> Downstream;
+    };
+
+    static std::atomic<int> ShutdownCount;
+
+    bool Initialize(const Dependencies& deps, int shutdownMsec)
+    {
+        Deps = deps;
+        ShutdownMsec = shutdownMsec;
+        return true;
+    }
+    void Drain()
+    {
+        // Dependencies are still up while draining
+        if (Deps.Downstream)
+            TEST_CHECK(Deps.Downstream->ShutdownsBeforeDrain < 0);
+
+        ShutdownsBeforeDrain = ShutdownCount;
+    }
+    void Shutdown()
+    {
+        TEST_CHECK(ShutdownsBeforeDrain >= 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(ShutdownMsec));
+        ShutdownCount++;
+    }
+
+    int ShutdownsBeforeDrain = -1;
+
+private:
+    Dependencies Deps;
+    int ShutdownMsec = 0;
+};
+
+std::atomic<int> DrainingObject::ShutdownCount{ 0 };
+
+
+//------------------------------------------------------------------------------
+// SlowStartObject
+
+// Takes a given time to initialize
+class SlowStartObject
+{
+public:
+    struct Dependencies
+    {
+        OptionalDependency<SlowStartObject> First;
+        OptionalDependency<SlowStartObject> Second;
+    };
+
+    bool Initialize(const Dependencies& deps, int startMsec)
+    {
+        if (deps.First)
+            TEST_CHECK(deps.First->Started);
+        if (deps.Second)
+            TEST_CHECK(deps.Second->Started);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(startMsec));
+        Started = true;
+        return true;
+    }
+    void Shutdown()
+    {
+    }
+
+    bool Started = false;
+};
+
+
+//------------------------------------------------------------------------------
+// FlakyObject
+
+// Outlives the objects, which are cleared on each Initialize()
+struct FlakyBackend
+{
+    int FailuresLeft = 0;
+    int Initializes = 0;
+    std::vector<int>* ShutdownLog = nullptr;
+};
+
+// Fails Initialize() while its backend has failures left
+class FlakyObject
+{
+public:
+    struct Dependencies
+    {
+        OptionalDependency<FlakyObject> Upstream;
+    };
+
+    bool Initialize(const Dependencies& deps, int id, FlakyBackend* backend)
+    {
+        if (deps.Upstream)
+            TEST_CHECK(deps.Upstream->Up);
+
+        Id = id;
+        Backend = backend;
+        ++Backend->Initializes;
+
+        if (Backend->FailuresLeft > 0)
+        {
+            --Backend->FailuresLeft;
+            return false;
+        }
+
+        Up = true;
+        return true;
+    }
+    void Shutdown()
+    {
+        Backend->ShutdownLog->push_back(Id);
+    }
+
+    int Id = 0;
+    FlakyBackend* Backend = nullptr;
+    bool Up = false;
+};
+
+
+//------------------------------------------------------------------------------
+// LeafBank
+
+// Many LeafObjects stored column-wise
+class LeafBank
+{
+public:
+    struct Dependencies
+    {
+    };
+
+    struct Row
+    {
+        int ParameterX;
+        int Counter;
+    };
+
+    bool Initialize(const Dependencies& deps, DependencyColumns<Row>& rows, const int* parameterX)
+    {
+        (void)deps;
+        Rows = &rows;
+
+        int* DI_RESTRICT x = rows.Column(&Row::ParameterX);
+        for (size_t i = 0; i < rows.GetCount(); ++i)
+            x[i] = parameterX[i];
+        return true;
+    }
+    void Shutdown()
+    {
+    }
+
+    // LeafObject::DoThing() for every instance
+    void DoThing(int* DI_RESTRICT results)
+    {
+        const int* DI_RESTRICT x = Rows->Column(&Row::ParameterX);
+        int* DI_RESTRICT counter = Rows->Column(&Row::Counter);
+        const size_t count = Rows->GetCount();
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            counter[i]++;
+            results[i] = x[i] + counter[i];
+        }
+    }
+
+private:
+    DependencyColumns<Row>* Rows = nullptr;
+};
+
+
+//------------------------------------------------------------------------------
+// SquareTable
+
+class SquareTable
+{
+public:
+    struct Dependencies
+    {
+    };
+
+    static int InitializeCount;
+
+    bool Initialize(const Dependencies& deps, uint32_t count)
+    {
+        (void)deps;
+        ++InitializeCount;
+
+        Storage.resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+            Storage[i] = i * i;
+
+        Table = Storage.data();
+        Count = count;
+        return true;
+    }
+    void SaveSnapshot(DependencySnapshotWriter& writer) const
+    {
+        writer.WriteArray(Table, Count);
+    }
+    bool RestoreSnapshot(const Dependencies& deps, DependencySnapshotReader& reader)
+    {
+        (void)deps;
+
+        // Refers to the mapped file instead of copying
+        Table = reader.ReadArray<uint32_t>(Count);
+        return Table != nullptr;
+    }
+    void Shutdown()
+    {
+    }
+
+    uint32_t Lookup(size_t i) const
+    {
+        return Table[i];
+    }
+    const uint32_t* GetTable() const
+    {
+        return Table;
+    }
+
+private:
+    std::vector<uint32_t> Storage;
+    const uint32_t* Table = nullptr;
+    size_t Count = 0;
+};
+
+int SquareTable::InitializeCount = 0;
+
+class TableIndex
+{
+public:
+    struct Dependencies
+    {
+        RequiredDependency<SquareTable> table;
+    };
+
+    bool Initialize(const Dependencies& deps, int offset)
+    {
+        Deps = deps;
+        Offset = offset;
+        Cached = deps.table.Get();
+        return true;
+    }
+    void SaveSnapshot(DependencySnapshotWriter& writer) const
+    {
+        writer.WriteValue(Offset);
+        writer.WritePointer(Cached);
+    }
+    bool RestoreSnapshot(const Dependencies& deps, DependencySnapshotReader& reader)
+    {
+        Deps = deps;
+        if (!reader.ReadValue(Offset))
+            return false;
+
+        // Relocated to the SquareTable of this process
+        Cached = static_cast<SquareTable*>(reader.ReadPointer());
+        return Cached != nullptr;
+    }
+    void Shutdown()
+    {
+    }
+
+    uint32_t Lookup(size_t i) const
+    {
+        return Cached->Lookup(i) + Offset;
+    }
+    const SquareTable* GetCached() const
+    {
+        return Cached;
+    }
+
+private:
+    Dependencies Deps;
+    SquareTable* Cached = nullptr;
+    int Offset = 0;
+};
+
+
+#if defined(DI_COROUTINES)
+
+//------------------------------------------------------------------------------
+// AsyncConnection
+
+// Resumes the awaiting coroutine on another thread after a delay, like I/O
+struct DelayAwaitable
+{
+    int Msec;
+
+    bool await_ready() const
+    {
+        return false;
+    }
+    void await_suspend(std::coroutine_handle<> handle) const
+    {
+        const int msec = Msec;
+        std::thread([handle, msec]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(msec));
+            handle.resume();
+        }).detach();
+    }
+    void await_resume() const
+    {
+    }
+};
+
+class AsyncConnection
+{
+public:
+    struct Dependencies
+    {
+        OptionalDependency<AsyncConnection> Upstream;
+    };
+
+    DependencyTask<bool> Initialize(const Dependencies& deps, int delayMsec, bool succeed)
+    {
+        Deps = deps;
+
+        // Dependencies are ready before dependents start
+        if (Deps.Upstream)
+            TEST_CHECK(Deps.Upstream->IsConnected());
+
+        co_await DelayAwaitable{ delayMsec };
+
+        Connected = succeed;
+        co_return succeed;
+    }
+    DependencyTask<void> Shutdown()
+    {
+        co_await DelayAwaitable{ 1 };
+        Connected = false;
+    }
+
+    bool IsConnected() const
+    {
+        return Connected;
+    }
+
+private:
+    Dependencies Deps;
+    std::atomic<bool> Connected{ false };
+};
+
+class ConnectionUser
+{
+public:
+    struct Dependencies
+    {
+        RequiredDependency<AsyncConnection> Connection;
+    };
+
+    bool Initialize(const Dependencies& deps)
+    {
+        Deps = deps;
+        TEST_CHECK(Deps.Connection->IsConnected());
+        return true;
+    }
+    void Shutdown()
+    {
+    }
+
+private:
+    Dependencies Deps;
+};
+
+#endif // DI_COROUTINES
+
+
+//------------------------------------------------------------------------------
+// RequestHandler
+
+class WorkerScratch
+{
+public:
+    struct Dependencies
+    {
+    };
+
+    static std::atomic<int> ShutdownCount;
+
+    bool Initialize(const Dependencies& deps, int worker)
+    {
+        (void)deps;
+        Worker = worker;
+        Owner = std::this_thread::get_id();
+        return true;
+    }
+    void Shutdown()
+    {
+        ShutdownCount++;
+    }
+
+    int Worker = -1;
+    std::thread::id Owner;
+};
+
+std::atomic<int> WorkerScratch::ShutdownCount{ 0 };
+
+class RequestContext
+{
+public:
+    struct Dependencies
+    {
+        ThreadLocalDependency<WorkerScratch> Scratch;
+    };
+
+    static int ShutdownCount;
+
+    // Negative ids fail
+    bool Initialize(const Dependencies& deps, int id)
+    {
+        Id = id;
+        Worker = deps.Scratch->Worker;
+        return id >= 0;
+    }
+    void Shutdown()
+    {
+        ShutdownCount++;
+    }
+
+    int Id = -1;
+    int Worker = -1;
+};
+
+int RequestContext::ShutdownCount = 0;
+
+class RequestHandler
+{
+public:
+    struct Dependencies
+    {
+        ThreadLocalDependency<WorkerScratch> Scratch;
+        RequestDependency<RequestContext> Context;
+    };
+
+    bool Initialize(const Dependencies& deps)
+    {
+        Deps = deps;
+        return true;
+    }
+    void Shutdown()
+    {
+    }
+
+    // Returns -1 if the scratch buffer belongs to another thread
+    int Handle() const
+    {
+        if (Deps.Scratch->Owner != std::this_thread::get_id())
+            return -1;
+        return Deps.Context->Id * 100 + Deps.Context->Worker;
+    }
+
+private:
+    Dependencies Deps;
+};
+
+
+//------------------------------------------------------------------------------
+// StressNode
+
+class StressNode
+{
+public:
+    struct Dependencies
+    {
+        OptionalDependency<StressNode> A;
+        OptionalDependency<StressNode> B;
+        OptionalDependency<StressNode> C;
+    };
+
+    bool Initialize(const Dependencies& deps)
+    {
+        Deps = deps;
+
+        // Plain fields, so TSan checks that dependencies are published
+        // to this thread before it initializes
+        Depth = 0;
+        VisitDeps([this](const StressNode& dep) {
+            TEST_CHECK(dep.Ready);
+            if (Depth <= dep.Depth)
+                Depth = dep.Depth + 1;
+        });
+
+        Ready = true;
+        return true;
+    }
+    void Shutdown()
+    {
+        // Dependencies must outlive their users
+        VisitDeps([](const StressNode& dep) {
+            TEST_CHECK(dep.Ready);
+        });
+
+        Ready = false;
+    }
+
+    int GetDepth() const
+    {
+        return Depth;
+    }
+
+private:
+    Dependencies Deps;
+    bool Ready = false;
+    int Depth = 0;
+
+    template<class F>
+    void VisitDeps(F&& f) const
+    {
+        if (Deps.A)
+            f(*Deps.A);
+        if (Deps.B)
+            f(*Deps.B);
+        if (Deps.C)
+            f(*Deps.C);
+    }
+};
+
+
+//------------------------------------------------------------------------------
+// NumaProbe
+
+// Records where it was initialized and touches a buffer of its own there
+class NumaProbe
+{
+public:
+    struct Dependencies
+    {
+    };
+
+    bool Initialize(const Dependencies& deps)
+    {
+        (void)deps;
+        Owner = std::this_thread::get_id();
+        Buffer.assign(4096, 1);
+        return true;
+    }
+    void Shutdown()
+    {
+        Buffer.clear();
+    }
+
+    std::thread::id Owner;
+    std::vector<uint8_t> Buffer;
+};
+
+
+//------------------------------------------------------------------------------
+// Layout checks
+
+struct SixDependencies
+{
+    RequiredDependency<Cog> a;
+    RequiredDependency<Cog> b;
+    RequiredDependency<Widget> c;
+    OptionalDependency<Widget> d;
+    OptionalDependency<Widget> e;
+    LateBound<OptionalDependency<Widget>> f;
+};
+
+static_assert(std::is_trivially_copyable<OptionalDependency<Widget>>::value, "Must be memcpy-able");
+static_assert(std::is_trivially_copyable<RequiredDependency<Widget>>::value, "Must be memcpy-able");
+static_assert(std::is_trivially_copyable<SixDependencies>::value, "Must be memcpy-able");
+static_assert(!std::is_polymorphic<DependencyInjected<Widget>>::value, "Must not have a vtable");
+
+
+//------------------------------------------------------------------------------
+// Tests
+
+void Test_ThirdPartyObject()
+{
+    // Verifies that we can also inject code from third party developers
+    DependencyInjected<ThirdPartyClassUser> user;
+    ThirdPartyClass third;
+
+    user.SetDependencies({
+        &third
+    });
+
+    user.Initialize();
+
+    user->DoThing();
+
+    user.Shutdown();
+}
+
+void Test_PeerObjects()
+{
+    DependencyInjected<Cog> cog;
+    DependencyInjected<Widget> widget;
+
+    cog.SetDependencies({
+        &widget,
+        nullptr // optional dependency
+    });
+    widget.SetDependencies({
+        cog
+    });
+
+    cog.Initialize();
+    widget.Initialize(15);
+
+    cog->DoCogThing();
+
+    widget.Shutdown();
+    cog.Shutdown();
+}
+
+void Test_NestedDeps()
+{
+    DependencyInjected<BranchObject> branch;
+
+    branch.SetDependencies({
+    });
+
+    branch.Initialize(10);
+
+    cout << "branch->DoThing() = " << branch->DoThing() << endl;
+    cout << "branch->DoThing() = " << branch->DoThing() << endl;
+    cout << "branch->DoThing() = " << branch->DoThing() << endl;
+
+    branch.Shutdown();
+}
+
+void Test_DerivedClass()
+{
+    DependencyInjected<MyImplementation> branch;
+    DependencyInjected<InterfaceUser> user;
+
+    branch.SetDependencies({
+    });
+    user.SetDependencies({
+        branch
+    });
+
+    branch.Initialize(10);
+    user.Initialize();
+
+    cout << "user->DoThing() = " << user->DoThing() << endl;
+    cout << "user->DoThing() = " << user->DoThing() << endl;
+    cout << "user->DoThing() = " << user->DoThing() << endl;
+
+    branch.Shutdown();
+    user.Shutdown();
+}
+
+void Test_Forget_SetDep()
+{
+    DependencyInjected<Cog> cog;
+    DependencyInjected<Widget> widget;
+
+    DependencyInjected<Widget>* nullWidget = nullptr;
+
+    // Note: It will actually fail to compile if nullptr is passed directly here
+    cog.SetDependencies({
+        nullWidget, // &widget
+        nullptr
+    });
+#if 0
+    widget.SetDependencies({
+        cog
+    });
+
+    cog.Initialize();
+    widget.Initialize(15);
+
+    cog->DoCogThing();
+
+    widget.Shutdown();
+    cog.Shutdown();
+#endif
+}
+
+void Test_Forget_InitCog()
+{
+    DependencyInjected<Cog> cog;
+    DependencyInjected<Widget> widget;
+
+    cog.SetDependencies({
+        &widget,
+        nullptr
+    });
+    widget.SetDependencies({
+        cog
+    });
+
+    //cog.Initialize();
+    widget.Initialize(15);
+
+    cog->DoCogThing();
+
+    widget.Shutdown();
+    cog.Shutdown();
+}
+
+void Test_Forget_InitWidget()
+{
+    DependencyInjected<Cog> cog;
+    DependencyInjected<Widget> widget;
+
+    cog.SetDependencies({
+        &widget,
+        nullptr
+    });
+    widget.SetDependencies({
+        cog
+    });
+
+    cog.Initialize();
+    //widget.Initialize(15);
+
+    cog->DoCogThing();
+
+    widget.Shutdown();
+    cog.Shutdown();
+}
+
+void Test_Forget_ShutdownWidget()
+{
+    DependencyInjected<Cog> cog;
+    DependencyInjected<Widget> widget;
+
+    cog.SetDependencies({
+        &widget,
+        nullptr
+    });
+    widget.SetDependencies({
+        cog
+    });
+
+    cog.Initialize();
+    widget.Initialize(15);
+
+    cog->DoCogThing();
+
+    //widget.Shutdown();
+    cog.Shutdown();
+}
+
+void Test_Forget_ShutdownCog()
+{
+    DependencyInjected<Cog> cog;
+    DependencyInjected<Widget> widget;
+
+    cog.SetDependencies({
+        &widget,
+        nullptr
+    });
+    widget.SetDependencies({
+        cog
+    });
+
+    cog.Initialize();
+    widget.Initialize(15);
+
+    cog->DoCogThing();
+
+    widget.Shutdown();
+    //cog.Shutdown();
+}
+
+void Test_Optional_StoppedWrapper()
+{
+    DependencyInjected<ChainObject> first;
+    DependencyInjected<ChainObject> second;
+
+    first.SetDependencies({
+        nullptr
+    });
+    second.SetDependencies({
+        first
+    });
+
+    // An optional bound to a wrapper that is not initialized tests false
+    second.Initialize();
+    TEST_CHECK(second->GetDepth() == 0);
+    second.Shutdown();
+
+    // The stored dependencies keep the binding for the next Initialize()
+    first.Initialize();
+    second.Initialize();
+    TEST_CHECK(second->GetDepth() == 1);
+    second.Shutdown();
+
+    // Cleared again once the wrapper is shut down
+    first.Shutdown();
+    second.Initialize();
+    TEST_CHECK(second->GetDepth() == 0);
+    second.Shutdown();
+}
+
+void Test_Container_ParallelInit()
+{
+    static const int kChains = 3;
+    static const int kLength = 4;
+
+    DependencyInjected<ChainObject> chains[kChains][kLength];
+    DependencyInjected<FanInObject> fanIn;
+
+    DependencyContainer container(4);
+
+    // Register in reverse order so the container has to sort them
+    container.Add(fanIn, 100);
+    for (int i = 0; i < kChains; ++i)
+    {
+        for (int j = kLength - 1; j >= 0; --j)
+        {
+            DependencyInjected<ChainObject>* previous = j > 0 ? &chains[i][j - 1] : nullptr;
+            chains[i][j].SetDependencies({
+                previous
+            });
+            container.Add(chains[i][j]);
+        }
+    }
+    fanIn.SetDependencies({
+        chains[0][kLength - 1],
+        chains[1][kLength - 1],
+        chains[2][kLength - 1]
+    });
+
+    // Objects can be initialized and shutdown repeatedly, cleanly:
+    for (int i = 0; i < 100; ++i)
+    {
+        TEST_CHECK(container.InitializeAll());
+        TEST_CHECK(container.GetLevelCount() == kLength + 1);
+        TEST_CHECK(fanIn->GetSum() == 100 + kChains * (kLength - 1));
+
+        container.ShutdownAll();
+        TEST_CHECK(!fanIn.IsInitialized());
+    }
+
+    cout << "Levels = " << container.GetLevelCount() << endl;
+}
+
+void Test_Container_Cycle()
+{
+    DependencyInjected<Cog> cog;
+    DependencyInjected<Widget> widget;
+
+    cog.SetDependencies({
+        &widget,
+        nullptr
+    });
+    widget.SetDependencies({
+        cog
+    });
+
+    DependencyContainer container;
+    container.Add(cog);
+    container.Add(widget, 15);
+
+    // Cog and Widget depend on each other so they cannot be ordered
+    container.InitializeAll();
+
+    container.ShutdownAll();
+}
+
+void Test_Graph_LateBoundPeers()
+{
+    typedef DependencyGraph<Belt, Pulley, InterfaceUser, MyImplementation> GraphT;
+
+    // Order is computed at compile time
+    static_assert(GraphT::GetInitializeOrder<Pulley>() < GraphT::GetInitializeOrder<Belt>(), "Order");
+    static_assert(GraphT::GetInitializeOrder<MyImplementation>() < GraphT::GetInitializeOrder<InterfaceUser>(), "Order");
+
+    // Listing a second implementation of IMyInterface would not compile
+    static_assert(DependencyDetail::ProviderCount<IMyInterface, Belt, MyImplementation>() == 1, "Provider");
+    static_assert(DependencyDetail::ProviderCount<IMyInterface, MyImplementation, ConstantImplementation>() == 2, "Ambiguous");
+    static_assert(DependencyDetail::ProviderCount<MyImplementation, MyImplementation, IMyInterface>() == 1, "Exact");
+
+    GraphT graph;
+
+    graph.Get<Pulley>().SetDependencies({
+        graph.Get<Belt>()
+    });
+    graph.Get<Belt>().SetDependencies({
+        graph.Get<Pulley>()
+    });
+    graph.Get<MyImplementation>().SetDependencies({
+    });
+    graph.Get<InterfaceUser>().SetDependencies({
+        graph.Get<MyImplementation>()
+    });
+
+    TEST_CHECK(graph.InitializeAll(
+        InitializeArgs<Belt>(3),
+        InitializeArgs<MyImplementation>(10)));
+
+    TEST_CHECK(graph.Get<Pulley>()->Turn() == 3);
+    TEST_CHECK(graph.Get<InterfaceUser>()->DoThing() == 11);
+
+    graph.ShutdownAll();
+}
+
+void Test_Alignment()
+{
+    static_assert(alignof(DependencyInjected<WideObject>) >= alignof(WideObject), "Alignment");
+    static_assert(alignof(DependencyInjected<LeafObject, CacheLineAligned>) == DI_CACHE_LINE_BYTES, "Alignment");
+    static_assert(sizeof(DependencyInjected<LeafObject, CacheLineAligned>) % DI_CACHE_LINE_BYTES == 0, "Padding");
+
+    struct Owner
+    {
+        char Misalign;
+        DependencyInjected<WideObject> Wide[2];
+        DependencyInjected<LeafObject, CacheLineAligned> Leaves[2];
+    };
+    Owner owner;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        owner.Wide[i].SetDependencies({
+        });
+        owner.Wide[i].Initialize();
+        TEST_CHECK(reinterpret_cast<uintptr_t>(owner.Wide[i].GetObjectPtr()) % alignof(WideObject) == 0);
+        TEST_CHECK(owner.Wide[i]->Sum() == 28.f);
+        owner.Wide[i].Shutdown();
+
+        owner.Leaves[i].SetDependencies({
+        });
+        owner.Leaves[i].Initialize(i);
+        TEST_CHECK(reinterpret_cast<uintptr_t>(owner.Leaves[i].GetObjectPtr()) % DI_CACHE_LINE_BYTES == 0);
+    }
+
+    // Neighboring objects never share a cache line
+    const uintptr_t first = reinterpret_cast<uintptr_t>(owner.Leaves[0].GetObjectPtr());
+    const uintptr_t second = reinterpret_cast<uintptr_t>(owner.Leaves[1].GetObjectPtr());
+    TEST_CHECK(second - first >= DI_CACHE_LINE_BYTES);
+
+    // Policies do not change how dependencies are bound
+    DependencyInjected<InterfaceUser> user;
+    DependencyInjected<MyImplementation, CacheLineAligned> branch;
+    branch.SetDependencies({
+    });
+    user.SetDependencies({
+        branch
+    });
+    branch.Initialize(10);
+    user.Initialize();
+    TEST_CHECK(user->DoThing() == 11);
+    user.Shutdown();
+    branch.Shutdown();
+
+    owner.Leaves[0].Shutdown();
+    owner.Leaves[1].Shutdown();
+}
+
+void Test_MoveOnlyArguments()
+{
+    DependencyInjected<TableObject> table;
+
+    std::vector<int> weights(1000, 1);
+    const int* weightsData = weights.data();
+
+    table.SetDependencies({
+        nullptr,
+        std::move(weights)
+    });
+
+    std::vector<int> extra(10, 2);
+    const int* extraData = extra.data();
+
+    TEST_CHECK(table.InitializeAndMoveDependencies(
+        std::unique_ptr<std::vector<int>>(new std::vector<int>(100)),
+        std::move(extra)));
+
+    // Nothing was copied along the way
+    TEST_CHECK(table->GetSize() == 1110);
+    TEST_CHECK(weights.empty() && table->GetWeightsData() == weightsData);
+    TEST_CHECK(extra.empty() && table->GetExtraData() == extraData);
+    TEST_CHECK(!table.HasDependencies());
+    TEST_CHECK(table.GetDependencies().weights.empty());
+
+    table.Shutdown();
+
+    // Graph arguments are moved out of rvalue InitializeArgs
+    DependencyGraph<TableObject, LeafObject> graph;
+    graph.Get<LeafObject>().SetDependencies({
+    });
+    graph.Get<TableObject>().SetDependencies({
+        graph.Get<LeafObject>(),
+        std::vector<int>(5)
+    });
+
+    std::unique_ptr<std::vector<int>> table2(new std::vector<int>(50));
+
+    TEST_CHECK(graph.InitializeAll(
+        InitializeArgs<LeafObject>(1),
+        InitializeArgs<TableObject>(std::move(table2), std::vector<int>(5))));
+    TEST_CHECK(graph.Get<TableObject>()->GetSize() == 60);
+
+    graph.ShutdownAll();
+}
+
+void Test_FastReset()
+{
+    DependencyInjected<ScratchObject> safe;
+    DependencyInjected<ScratchObject, FastReset, CacheLineAligned> fast;
+
+    safe.SetDependencies({
+    });
+    fast.SetDependencies({
+    });
+
+    for (int i = 0; i < 100; ++i)
+    {
+        const unsigned char fill = static_cast<unsigned char>(i + 1);
+        safe.Initialize(fill);
+        fast.Initialize(fill);
+        safe.Shutdown();
+        fast.Shutdown();
+
+        // Default policy never leaks state between instances
+        TEST_CHECK(ObjectMemoryIs(safe.GetObjectPtr(), sizeof(ScratchObject), 0));
+
+#if defined(DI_DEBUG)
+        // FastReset still clears memory in debug mode
+        TEST_CHECK(ObjectMemoryIs(fast.GetObjectPtr(), sizeof(ScratchObject), 0));
+#elif defined(DI_SANITIZER)
+        // Sanitizer builds poison it so stale reads stand out
+        TEST_CHECK(ObjectMemoryIsPoisoned(fast.GetObjectPtr(), sizeof(ScratchObject)));
+#else // DI_SANITIZER
+        // Release builds leave the last instance in place
+        TEST_CHECK(ObjectMemoryIs(fast.GetObjectPtr(), sizeof(ScratchObject), fill));
+#endif // DI_SANITIZER
+    }
+}
+
+void Test_Pool()
+{
+    DependencyInjected<LeafObject> leaf;
+    leaf.SetDependencies({
+    });
+    leaf.Initialize(0);
+
+    static const size_t kCapacity = 130;
+    DependencyInjectedPool<Session, CacheLineAligned> sessions(kCapacity);
+
+    sessions.SetDependencies({
+        leaf
+    });
+
+    std::vector<Session*> live;
+    for (size_t i = 0; i < kCapacity; ++i)
+    {
+        Session* session = sessions.Acquire(static_cast<int>(i));
+        TEST_CHECK(session != nullptr);
+        TEST_CHECK(reinterpret_cast<uintptr_t>(session) % DI_CACHE_LINE_BYTES == 0);
+        live.push_back(session);
+    }
+
+    // Pool is full, and failed initialization gives the slot back
+    TEST_CHECK(sessions.Acquire(1000) == nullptr);
+    sessions.Release(live[5]);
+    TEST_CHECK(sessions.Acquire(-1) == nullptr);
+    TEST_CHECK(sessions.GetLiveCount() == kCapacity - 1);
+
+    // Released slots are recycled without reallocation
+    Session* reused = sessions.Acquire(5);
+    TEST_CHECK(reused == live[5]);
+
+    for (size_t i = 0; i < kCapacity; i += 2)
+        sessions.Release(live[i]);
+
+    int visited = 0;
+    int lastId = -1;
+    sessions.ForEach([&](Session& session) {
+        // Iterates in slot order over odd client ids only
+        TEST_CHECK(session.GetClientId() % 2 == 1);
+        TEST_CHECK(session.GetClientId() > lastId);
+        lastId = session.GetClientId();
+        session.Tick();
+        ++visited;
+    });
+    TEST_CHECK(visited == static_cast<int>(kCapacity / 2));
+    TEST_CHECK(leaf->DoThing() == visited + 1);
+
+    for (size_t i = 1; i < kCapacity; i += 2)
+        sessions.Release(live[i]);
+    TEST_CHECK(sessions.GetLiveCount() == 0);
+
+    leaf.Shutdown();
+}
+
+void Test_StoragePolicies()
+{
+    // Heap storage keeps the owner small no matter how big the object is
+    static_assert(sizeof(DependencyInjected<ScratchObject>) > sizeof(ScratchObject), "Inline");
+    static_assert(sizeof(DependencyInjected<ScratchObject, HeapStorage>) < 256, "Heap");
+
+    DependencyInjected<ScratchObject, HeapStorage> scratch;
+    scratch.SetDependencies({
+    });
+    for (int i = 0; i < 10; ++i)
+    {
+        scratch.Initialize(static_cast<unsigned char>(i + 1));
+        scratch.Shutdown();
+        TEST_CHECK(ObjectMemoryIs(scratch.GetObjectPtr(), sizeof(ScratchObject), 0));
+    }
+
+    // Arena storage colocates a subsystem in one buffer
+    alignas(64) static unsigned char buffer[64 * 1024];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+
+    {
+        DependencyInjected<MyImplementation, ArenaStorage> branch(arena);
+        DependencyInjected<InterfaceUser, ArenaStorage, CacheLineAligned> user(arena);
+
+        const unsigned char* branchPtr = reinterpret_cast<unsigned char*>(branch.GetObjectPtr());
+        const unsigned char* userPtr = reinterpret_cast<unsigned char*>(user.GetObjectPtr());
+        TEST_CHECK(branchPtr >= buffer && branchPtr < buffer + sizeof(buffer));
+        TEST_CHECK(userPtr >= buffer && userPtr < buffer + sizeof(buffer));
+        TEST_CHECK(reinterpret_cast<uintptr_t>(userPtr) % DI_CACHE_LINE_BYTES == 0);
+
+        branch.SetDependencies({
+        });
+        user.SetDependencies({
+            branch
+        });
+
+        // Container ordering works the same way for any storage
+        DependencyContainer container(2);
+        container.Add(user);
+        container.Add(branch, 10);
+        TEST_CHECK(container.InitializeAll());
+        TEST_CHECK(user->DoThing() == 11);
+        container.ShutdownAll();
+    }
+
+    // Single reset for the whole subsystem
+    arena.release();
+}
+
+void Test_LazyInit()
+{
+    // Racing first use runs Initialize() exactly once
+    LazyDependencyInjected<CountedService> service;
+    service.SetDependencies({
+    });
+    TEST_CHECK(!service.IsInitialized());
+
+    std::atomic<bool> go{ false };
+    std::atomic<int> good{ 0 };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i)
+    {
+        threads.emplace_back([&]() {
+            while (!go.load())
+                std::this_thread::yield();
+            if (service->GetValue() == 42)
+                good++;
+        });
+    }
+    go = true;
+    for (auto& t : threads)
+        t.join();
+
+    TEST_CHECK(good == 8);
+    TEST_CHECK(CountedService::InitializeCount == 1);
+    TEST_CHECK(service.IsInitialized());
+    service.Shutdown();
+
+    // Consumers defer initialization until they touch the dependency
+    LazyDependencyInjected<MyImplementation> branch;
+    DependencyInjected<LazyUser> user;
+
+    branch.SetDependencies({
+    });
+    branch.SetInitializeArgs(10);
+    user.SetDependencies({
+        branch
+    });
+
+    // Lazy edges do not order initialization, so the user may come first
+    DependencyContainer container;
+    container.Add(user);
+    TEST_CHECK(container.InitializeAll());
+    TEST_CHECK(!branch.IsInitialized());
+
+    TEST_CHECK(user->DoThing() == 11);
+    TEST_CHECK(branch.IsInitialized());
+    TEST_CHECK(user->DoThing() == 12);
+
+    container.ShutdownAll();
+    branch.Shutdown();
+}
+
+void Test_HotSwap()
+{
+    HotSwapDomain domain;
+    HotSwapInjected<IMyInterface> backend(domain);
+    DependencyInjected<ConstantImplementation> first, second;
+    DependencyInjected<SwapUser> user;
+
+    first.SetDependencies({
+    });
+    first.Initialize(1);
+    backend.Swap(first);
+
+    user.SetDependencies({
+        backend
+    });
+    user.Initialize();
+
+    // Readers never see a shut down implementation while swaps happen
+    std::atomic<bool> stop{ false };
+    std::atomic<int> bad{ 0 };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([&]() {
+            HotSwapReader reader(domain);
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                for (int j = 0; j < 100; ++j)
+                {
+                    if (user->DoThing() <= 0)
+                        bad++;
+                }
+                reader.Quiesce();
+            }
+        });
+    }
+
+    for (int i = 2; i < 200; ++i)
+    {
+        // Alternate between the two wrappers, shutting down one per swap
+        DependencyInjected<ConstantImplementation>& next = (i % 2 == 0) ? second : first;
+        next.SetDependencies({
+        });
+        next.Initialize(i);
+        backend.Swap(next);
+        TEST_CHECK(!((i % 2 == 0) ? first : second).IsInitialized());
+    }
+
+    stop = true;
+    for (auto& t : threads)
+        t.join();
+    TEST_CHECK(bad == 0);
+
+    {
+        HotSwapReader reader(domain);
+        TEST_CHECK(user->DoThing() == 199);
+
+        // A reader thread can swap without waiting on its own reader
+        second.SetDependencies({
+        });
+        second.Initialize(200);
+        backend.Swap(second);
+        TEST_CHECK(!first.IsInitialized());
+        TEST_CHECK(user->DoThing() == 200);
+    }
+
+    user.Shutdown();
+    backend.Shutdown();
+    TEST_CHECK(!first.IsInitialized() && !second.IsInitialized());
+}
+
+void Test_BoundInterface()
+{
+    DependencyInjected<Adder> adder;
+    DependencyInjected<AdderUser> user;
+
+    adder.SetDependencies({
+    });
+    user.SetDependencies({
+        adder
+    });
+
+    adder.Initialize(3);
+    user.Initialize();
+
+    TEST_CHECK(user->Sum(10) == 30);
+
+    user.Shutdown();
+    adder.Shutdown();
+
+    // Explicit binding on a single dependency
+    DependencyInjected<MyImplementation> branch;
+    branch.SetDependencies({
+    });
+    branch.Initialize(10);
+
+    RequiredDependency<IMyInterface, MyImplementation> bound(branch);
+    TEST_CHECK(bound->DoThing() == 11);
+
+    branch.Shutdown();
+}
+
+void Test_BoundInterface_Mock()
+{
+    DependencyInjected<MockAdder> mock;
+    DependencyInjected<AdderUser> user;
+
+    mock.SetDependencies({
+    });
+    user.SetDependencies({
+        mock
+    });
+
+    mock.Initialize();
+    user.Initialize();
+
+    // Should fire: IAdder is bound to Adder in this build
+    user->Sum(10);
+
+    user.Shutdown();
+    mock.Shutdown();
+}
+
+void Test_ForwardDeclaredDependency()
+{
+    DependencyInjected<ForwardTarget> target;
+    DependencyInjected<ForwardUser> user;
+
+    target.SetDependencies({
+    });
+    user.SetDependencies({
+        target,
+        nullptr
+    });
+
+    target.Initialize(42);
+    TEST_CHECK(user.Initialize());
+    TEST_CHECK(user->GetTargetValue() == 42);
+
+    user.Shutdown();
+    target.Shutdown();
+}
+
+void Test_Container_ShutdownDeadline()
+{
+    DependencyInjected<DrainingObject> sink, fast, slow;
+
+    sink.SetDependencies({
+    });
+    fast.SetDependencies({
+        sink
+    });
+    slow.SetDependencies({
+        sink
+    });
+
+    DependencyContainer container(4);
+    container.Add(sink, 0);
+    container.Add(fast, 100);
+    container.Add(slow, 100);
+    container.SetDefaultShutdownDeadline(std::chrono::seconds(10));
+    container.SetShutdownDeadline(slow, std::chrono::milliseconds(20));
+
+    TEST_CHECK(container.InitializeAll());
+
+    DrainingObject::ShutdownCount = 0;
+    const DependencyShutdownReport report = container.ShutdownAll();
+
+    // Only the object with the short deadline overran
+    TEST_CHECK(report.Overruns.size() == 1);
+    TEST_CHECK(report.Overruns[0].Wrapper == &slow);
+    TEST_CHECK(std::string(report.Overruns[0].TypeName) == "DrainingObject");
+    TEST_CHECK(report.Overruns[0].Elapsed >= std::chrono::milliseconds(100));
+
+    // Both users shut down concurrently
+    TEST_CHECK(report.Elapsed < std::chrono::milliseconds(190));
+
+    TEST_CHECK(DrainingObject::ShutdownCount == 3);
+    TEST_CHECK(!sink.IsInitialized() && !fast.IsInitialized() && !slow.IsInitialized());
+}
+
+void Test_Container_ShutdownByDependents()
+{
+    DependencyInjected<DrainingObject> sinkA, sinkB, userA, userB;
+
+    sinkA.SetDependencies({
+    });
+    sinkB.SetDependencies({
+    });
+    userA.SetDependencies({
+        sinkA
+    });
+    userB.SetDependencies({
+        sinkB
+    });
+
+    // One slow object in each level, on unrelated chains
+    DependencyContainer container(4);
+    container.Add(sinkA, 0);
+    container.Add(sinkB, 100);
+    container.Add(userA, 100);
+    container.Add(userB, 0);
+
+    TEST_CHECK(container.InitializeAll());
+    TEST_CHECK(container.GetLevelCount() == 2);
+
+    DrainingObject::ShutdownCount = 0;
+    const DependencyShutdownReport report = container.ShutdownAll();
+
+    // sinkB does not wait for userA, so the slow objects overlap
+    TEST_CHECK(report.Elapsed < std::chrono::milliseconds(190));
+
+    TEST_CHECK(DrainingObject::ShutdownCount == 4);
+    TEST_CHECK(!sinkA.IsInitialized() && !sinkB.IsInitialized());
+    TEST_CHECK(!userA.IsInitialized() && !userB.IsInitialized());
+}
+
+void Test_Batch()
+{
+    static const size_t kCount = 1000;
+
+    std::vector<int> params(kCount), results(kCount);
+    for (size_t i = 0; i < kCount; ++i)
+        params[i] = static_cast<int>(i);
+
+    DependencyInjectedBatch<LeafBank> bank(kCount);
+    bank.SetDependencies({
+    });
+
+    for (int cycle = 0; cycle < 3; ++cycle)
+    {
+        TEST_CHECK(bank.InitializeAll(kCount, params.data()));
+        TEST_CHECK(bank.GetCount() == kCount);
+
+        bank->DoThing(results.data());
+        bank->DoThing(results.data());
+
+        // Counters start from zero again after each InitializeAll()
+        for (size_t i = 0; i < kCount; ++i)
+            TEST_CHECK(results[i] == static_cast<int>(i) + 2);
+
+        bank.Shutdown();
+    }
+
+    TEST_CHECK(bank.InitializeAll(10, params.data()));
+
+    DependencyColumns<LeafBank::Row>& rows = bank.GetColumns();
+    TEST_CHECK(rows.Column<0>() == rows.Column(&LeafBank::Row::ParameterX));
+    TEST_CHECK(rows.Column<1>() == rows.Column(&LeafBank::Row::Counter));
+    TEST_CHECK(reinterpret_cast<uintptr_t>(rows.Column<1>()) % DI_CACHE_LINE_BYTES == 0);
+
+    rows.SetRow(3, { 100, 5 });
+    const LeafBank::Row row = rows.GetRow(3);
+    TEST_CHECK(row.ParameterX == 100 && row.Counter == 5);
+
+    bank->DoThing(results.data());
+    TEST_CHECK(results[3] == 106);
+
+    bank.Shutdown();
+}
+
+void Test_Snapshot()
+{
+    const char* path = "Tester_Snapshot.bin";
+
+    {
+        DependencyInjected<SquareTable> table;
+        DependencyInjected<TableIndex> index;
+        table.SetDependencies({
+        });
+        index.SetDependencies({
+            table
+        });
+
+        DependencySnapshot snapshot;
+        snapshot.SetVersion(1);
+        snapshot.Add(table);
+        snapshot.Add(index);
+
+        // Cold start
+        SquareTable::InitializeCount = 0;
+        remove(path);
+        TEST_CHECK(!snapshot.Restore(path));
+
+        table.Initialize(100000);
+        index.Initialize(7);
+        TEST_CHECK(snapshot.Save(path));
+
+        index.Shutdown();
+        table.Shutdown();
+    }
+
+    // Warm start into wrappers at different addresses
+    std::unique_ptr<DependencyInjected<SquareTable>> table(new DependencyInjected<SquareTable>);
+    std::unique_ptr<DependencyInjected<TableIndex>> index(new DependencyInjected<TableIndex>);
+    (*table).SetDependencies({
+    });
+    (*index).SetDependencies({
+        *table
+    });
+
+    {
+        DependencySnapshot snapshot;
+        snapshot.SetVersion(1);
+        snapshot.Add(*table);
+        snapshot.Add(*index);
+
+        TEST_CHECK(snapshot.Restore(path));
+        TEST_CHECK(SquareTable::InitializeCount == 1);
+        TEST_CHECK(snapshot.IsMapped());
+
+        TEST_CHECK((*index)->GetCached() == table->GetObjectPtr());
+        TEST_CHECK((*index)->Lookup(300) == 90007);
+        TEST_CHECK(reinterpret_cast<uintptr_t>((*table)->GetTable()) % DI_CACHE_LINE_BYTES == 0);
+
+        index->Shutdown();
+        table->Shutdown();
+    }
+
+    // Version mismatch falls back to a cold start
+    {
+        DependencySnapshot snapshot;
+        snapshot.SetVersion(2);
+        snapshot.Add(*table);
+        snapshot.Add(*index);
+        TEST_CHECK(!snapshot.Restore(path));
+        TEST_CHECK(!table->IsInitialized() && !index->IsInitialized());
+    }
+
+    // Different wiring falls back to a cold start
+    {
+        DependencyInjected<SquareTable> other;
+        other.SetDependencies({
+        });
+        (*index).SetDependencies({
+            other
+        });
+
+        DependencySnapshot snapshot;
+        snapshot.SetVersion(1);
+        snapshot.Add(*table);
+        snapshot.Add(*index);
+        TEST_CHECK(!snapshot.Restore(path));
+        TEST_CHECK(!table->IsInitialized() && !index->IsInitialized());
+    }
+
+    remove(path);
+}
+
+void Test_AsyncInit()
+{
+#if defined(DI_COROUTINES)
+    static const int kConnections = 4;
+
+    // Independent I/O overlaps even with a single thread
+    {
+        DependencyInjected<AsyncConnection> connections[kConnections];
+        DependencyInjected<AsyncConnection> replica;
+        DependencyInjected<ConnectionUser> user;
+
+        DependencyContainer container(1);
+        for (int i = 0; i < kConnections; ++i)
+        {
+            connections[i].SetDependencies({
+            });
+            container.Add(connections[i], 100, true);
+        }
+        replica.SetDependencies({
+            connections[0]
+        });
+        user.SetDependencies({
+            replica
+        });
+        container.Add(user);
+        container.Add(replica, 100, true);
+
+        const auto t0 = std::chrono::steady_clock::now();
+        TEST_CHECK(container.InitializeAll());
+        const auto elapsed = std::chrono::steady_clock::now() - t0;
+
+        // Two rounds of I/O instead of five
+        TEST_CHECK(elapsed < std::chrono::milliseconds(350));
+
+        // Awaited I/O counts toward the critical path
+        const DependencyStartupReport report = container.GetStartupReport();
+        TEST_CHECK(report.CriticalPath.size() == 3);
+        TEST_CHECK(report.CriticalPath[0] == 0 && report.CriticalPath[1] == 5 && report.CriticalPath[2] == 4);
+        TEST_CHECK(report.CriticalPathElapsed >= std::chrono::milliseconds(200));
+        for (int i = 0; i < kConnections; ++i)
+            TEST_CHECK(connections[i]->IsConnected());
+        TEST_CHECK(replica->IsConnected());
+        TEST_CHECK(user.IsInitialized());
+
+        container.ShutdownAll();
+        TEST_CHECK(!replica.IsInitialized() && !user.IsInitialized());
+    }
+
+    // Dependents of a failed connection are never started
+    {
+        DependencyInjected<AsyncConnection> primary, replica;
+        DependencyInjected<ConnectionUser> user;
+
+        primary.SetDependencies({
+        });
+        replica.SetDependencies({
+            primary
+        });
+        user.SetDependencies({
+            replica
+        });
+
+        DependencyContainer container(2);
+        container.Add(primary, 10, false);
+        container.Add(replica, 10, true);
+        container.Add(user);
+
+        TEST_CHECK(!container.InitializeAll());
+        TEST_CHECK(primary.IsInitialized() && !primary->IsConnected());
+        TEST_CHECK(!replica.IsInitialized() && !user.IsInitialized());
+
+        container.ShutdownAll();
+        TEST_CHECK(!primary.IsInitialized());
+    }
+#endif // DI_COROUTINES
+}
+
+#if defined(DI_HARDENED) && !defined(DI_DEBUG)
+struct HardenedViolation
+{
+    const char* Message;
+};
+
+static void ThrowViolation(const char* message, const char* file, int line)
+{
+    cout << "Violation: " << message << endl;
+    throw HardenedViolation{ message };
+}
+#endif // DI_HARDENED
+
+void Test_HardenedChecks()
+{
+#if defined(DI_HARDENED) && !defined(DI_DEBUG)
+    const DependencyViolationHandler previous = SetDependencyViolationHandler(&ThrowViolation);
+    int violations = 0;
+
+    {
+        DependencyInjected<MyImplementation> branch;
+
+        branch.SetDependencies({
+        });
+
+        // Use before Initialize() is reported instead of crashing
+        try
+        {
+            branch->DoThing();
+        }
+        catch (const HardenedViolation&)
+        {
+            ++violations;
+        }
+        TEST_CHECK(violations == 1);
+
+        branch.Initialize(10);
+        TEST_CHECK(branch->DoThing() == 11);
+
+        try
+        {
+            branch.SetDependencies({
+            });
+        }
+        catch (const HardenedViolation&)
+        {
+            ++violations;
+        }
+        TEST_CHECK(violations == 2);
+
+        branch.Shutdown();
+    }
+
+    {
+        DependencyInjected<MyImplementation> branch;
+        DependencyInjected<InterfaceUser> user;
+
+        branch.SetDependencies({
+        });
+        user.SetDependencies({
+            branch
+        });
+        user.Initialize();
+
+        // Dependency on an object that is not initialized yet
+        try
+        {
+            user->DoThing();
+        }
+        catch (const HardenedViolation&)
+        {
+            ++violations;
+        }
+        TEST_CHECK(violations == 3);
+
+        branch.Initialize(10);
+        TEST_CHECK(user->DoThing() == 11);
+
+        user.Shutdown();
+        branch.Shutdown();
+    }
+
+    SetDependencyViolationHandler(previous);
+#endif // DI_HARDENED
+}
+
+void Test_ViolationLog()
+{
+#if defined(DI_DEBUG)
+    DependencyViolationLog& log = DependencyViolationLog::Get();
+    log.Clear();
+    log.Enable(false);
+
+    {
+        DependencyInjected<LeafObject> leaf;
+        DependencyInjected<LeafObject> other;
+
+        leaf.SetDependencies({
+        });
+        other.SetDependencies({
+        });
+
+        // Each of these would trap without the log
+        leaf->DoThing();
+        leaf.Initialize(10);
+        leaf.SetDependencies({
+        });
+        leaf.Shutdown();
+        leaf->DoThing();
+        leaf.Initialize(10);
+
+        OptionalDependency<LeafObject> dep(other);
+        dep->DoThing();
+
+        // leaf is destroyed without Shutdown()
+    }
+
+    const std::vector<DependencyViolationEvent> events = log.GetEvents();
+    TEST_CHECK(events.size() == 5);
+    TEST_CHECK(events[0].Kind == DependencyViolationKind::UseBeforeInitialize);
+    TEST_CHECK(events[1].Kind == DependencyViolationKind::SetDependenciesAfterInitialize);
+    TEST_CHECK(events[2].Kind == DependencyViolationKind::UseAfterShutdown);
+    TEST_CHECK(events[3].Kind == DependencyViolationKind::UseBeforeInitialize);
+    TEST_CHECK(events[4].Kind == DependencyViolationKind::MissedShutdown);
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        TEST_CHECK(events[i].Sequence == i);
+        TEST_CHECK(strstr(events[i].TypeName, "LeafObject") != nullptr);
+        TEST_CHECK(events[i].CallSite != nullptr && events[i].Line > 0);
+    }
+
+    // Concurrent violations wrap the ring but every one is counted
+    static const int kThreads = 4;
+    static const int kPerThread = 3000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back([] {
+            for (int i = 0; i < kPerThread; ++i)
+                RequiredDependency<LeafObject> required(static_cast<LeafObject*>(nullptr));
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    log.Disable();
+
+    TEST_CHECK(log.GetTotalCount() == 5 + kThreads * kPerThread);
+    TEST_CHECK(log.GetCount(DependencyViolationKind::RequiredDependencyNull) == kThreads * kPerThread);
+    TEST_CHECK(log.GetEvents().size() == DependencyViolationLog::kCapacity);
+    TEST_CHECK(log.GetEvents().back().Kind == DependencyViolationKind::RequiredDependencyNull);
+
+    FILE* report = tmpfile();
+    TEST_CHECK(report != nullptr);
+    log.WriteReport(report);
+    rewind(report);
+    std::string text;
+    char buffer[1024];
+    while (fgets(buffer, sizeof(buffer), report))
+        text += buffer;
+    fclose(report);
+
+    TEST_CHECK(text.find("12005 usage violations") != std::string::npos);
+    TEST_CHECK(text.find("required-null") != std::string::npos);
+    TEST_CHECK(text.find("4096x required-null") != std::string::npos);
+
+    log.Clear();
+    TEST_CHECK(log.GetTotalCount() == 0 && log.GetEvents().empty());
+#endif // DI_DEBUG
+}
+
+void Test_AccessCounters()
+{
+#if defined(DI_COUNT_ACCESSES)
+    static const int kCalls = 1000;
+
+    DependencyAccessCounters& counters = DependencyAccessCounters::Get();
+    counters.Reset();
+
+    DependencyInjected<MyImplementation> branch;
+    DependencyInjected<InterfaceUser> user;
+
+    branch.SetDependencies({
+    });
+    user.SetDependencies({
+        branch
+    });
+
+    branch.Initialize(10);
+    user.Initialize();
+
+    for (int i = 0; i < kCalls; ++i)
+        user->DoThing();
+
+    // Counts from threads that exited are kept
+    std::thread worker([&] {
+        for (int i = 0; i < kCalls; ++i)
+            user->DoThing();
+    });
+    worker.join();
+
+    // Not set through a wrapper, so the edge is unknown
+    RequiredDependency<IMyInterface> direct(branch);
+    direct->DoThing();
+
+    auto findCount = [&](const char* consumer, const char* dependency) -> uint64_t {
+        for (const DependencyAccessCount& edge : counters.GetCounts())
+        {
+            if (!consumer && !edge.ConsumerType)
+                return edge.Count;
+            if (consumer && edge.ConsumerType && strcmp(edge.ConsumerType, consumer) == 0 &&
+                strcmp(edge.DependencyType, dependency) == 0)
+                return edge.Count;
+        }
+        return 0;
+    };
+
+    TEST_CHECK(findCount("InterfaceUser", "IMyInterface") == 2 * kCalls);
+    TEST_CHECK(findCount(nullptr, nullptr) == 1);
+    TEST_CHECK(counters.GetCounts().front().Count == 2 * kCalls);
+
+    counters.WriteReport(stdout);
+
+    counters.Reset();
+    TEST_CHECK(findCount("InterfaceUser", "IMyInterface") == 0);
+
+    user.Shutdown();
+    branch.Shutdown();
+#endif // DI_COUNT_ACCESSES
+}
+
+void Test_ThreadLocal()
+{
+    static const int kWorkers = 4;
+
+    WorkerScratch::ShutdownCount = 0;
+
+    ThreadLocalInjected<WorkerScratch> scratch;
+    RequestInjected<RequestContext> context;
+    DependencyInjected<RequestHandler> handler;
+
+    scratch.SetDependencies({
+    });
+    context.SetDependencies({
+        scratch
+    });
+    handler.SetDependencies({
+        scratch,
+        context
+    });
+    handler.Initialize();
+
+    // The shared handler resolves to each worker's own instance
+    std::atomic<int> good{ 0 };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kWorkers; ++i)
+    {
+        threads.emplace_back([&, i]() {
+            if (!scratch.Initialize(i))
+                return;
+
+            RequestArena arena;
+            bool match = true;
+            for (int id = 0; id < 100; ++id)
+            {
+                RequestScope scope(arena);
+                match &= context.Initialize(id);
+                match &= handler->Handle() == id * 100 + i;
+            }
+            if (match)
+                good++;
+
+            // The last worker leaves its instance for ShutdownAll()
+            if (i != kWorkers - 1)
+                scratch.Shutdown();
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    TEST_CHECK(good == kWorkers);
+    TEST_CHECK(WorkerScratch::ShutdownCount == kWorkers - 1);
+    TEST_CHECK(scratch.GetInstanceCount() == 1);
+    TEST_CHECK(!scratch.IsInitialized());
+
+    scratch.ShutdownAll();
+    TEST_CHECK(WorkerScratch::ShutdownCount == kWorkers);
+    TEST_CHECK(scratch.GetInstanceCount() == 0);
+
+    // ShutdownAll() also clears the calling thread's instance
+    TEST_CHECK(scratch.Initialize(-1));
+    TEST_CHECK(scratch.IsInitialized());
+    scratch.ShutdownAll();
+    TEST_CHECK(!scratch.IsInitialized());
+    TEST_CHECK(WorkerScratch::ShutdownCount == kWorkers + 1);
+    TEST_CHECK(scratch.Initialize(-1));
+    scratch.Shutdown();
+
+    handler.Shutdown();
+}
+
+void Test_RequestScope()
+{
+    RequestContext::ShutdownCount = 0;
+
+    ThreadLocalInjected<WorkerScratch> scratch;
+    RequestInjected<RequestContext> context;
+    DependencyInjected<RequestHandler> handler;
+
+    scratch.SetDependencies({
+    });
+    context.SetDependencies({
+        scratch
+    });
+    handler.SetDependencies({
+        scratch,
+        context
+    });
+    handler.Initialize();
+    TEST_CHECK(scratch.Initialize(7));
+
+    RequestArena arena(1024);
+    TEST_CHECK(!context.IsInitialized());
+
+    size_t reserved = 0;
+    for (int id = 1; id <= 3; ++id)
+    {
+        RequestScope scope(arena);
+        TEST_CHECK(!context.IsInitialized());
+        TEST_CHECK(context.Initialize(id));
+        TEST_CHECK(handler->Handle() == id * 100 + 7);
+
+        // Later requests reuse the memory of the first
+        if (id == 1)
+            reserved = arena.GetReservedBytes();
+        TEST_CHECK(arena.GetReservedBytes() == reserved);
+    }
+    TEST_CHECK(!context.IsInitialized());
+    TEST_CHECK(RequestContext::ShutdownCount == 3);
+
+    {
+        RequestScope outer(arena);
+        TEST_CHECK(context.Initialize(1));
+
+        // Nested scopes see only their own instances
+        RequestArena nestedArena;
+        {
+            RequestScope inner(nestedArena);
+            TEST_CHECK(!context.IsInitialized());
+            TEST_CHECK(context.Initialize(2));
+            TEST_CHECK(handler->Handle() == 207);
+        }
+        TEST_CHECK(RequestContext::ShutdownCount == 4);
+        TEST_CHECK(handler->Handle() == 107);
+
+        // Allocations larger than a block get their own block
+        TEST_CHECK(arena.Allocate(4096, 64) != nullptr);
+        TEST_CHECK(arena.GetReservedBytes() >= reserved + 4096);
+    }
+    TEST_CHECK(RequestContext::ShutdownCount == 5);
+
+    // A failed Initialize() leaves no instance behind
+    {
+        RequestScope scope(arena);
+        TEST_CHECK(!context.Initialize(-1));
+        TEST_CHECK(!context.IsInitialized());
+        TEST_CHECK(RequestContext::ShutdownCount == 6);
+    }
+    TEST_CHECK(RequestContext::ShutdownCount == 6);
+
+    scratch.Shutdown();
+    handler.Shutdown();
+}
+
+void Test_Stress_RandomGraph()
+{
+    static const int kNodes = 4000;
+
+    for (unsigned seed = 1; seed <= 3; ++seed)
+    {
+        std::mt19937 rng(seed);
+        std::unique_ptr<DependencyInjected<StressNode>[]> nodes(new DependencyInjected<StressNode>[kNodes]);
+
+        // Each node depends on up to three earlier nodes, some left empty
+        for (int i = 0; i < kNodes; ++i)
+        {
+            DependencyInjected<StressNode>* picks[3] = { nullptr, nullptr, nullptr };
+            for (int j = 0; j < 3 && i > 0; ++j)
+                if (rng() % 4 != 0)
+                    picks[j] = &nodes[rng() % i];
+
+            nodes[i].SetDependencies({
+                picks[0],
+                picks[1],
+                picks[2]
+            });
+        }
+
+        // Added in random order, so the container has to sort them
+        std::vector<int> order(kNodes);
+        for (int i = 0; i < kNodes; ++i)
+            order[i] = i;
+        std::shuffle(order.begin(), order.end(), rng);
+
+        DependencyContainer container(4);
+        for (int i : order)
+            container.Add(nodes[i]);
+
+        TEST_CHECK(container.InitializeAll());
+        for (int i = 0; i < kNodes; ++i)
+            TEST_CHECK(nodes[i].IsInitialized());
+
+        container.ShutdownAll();
+        for (int i = 0; i < kNodes; ++i)
+            TEST_CHECK(!nodes[i].IsInitialized());
+    }
 }
 
-void Test_Forget_ShutdownCog()
+void Test_Stress_ThreadCycles()
 {
-    DependencyInjected<Cog> cog;
-    DependencyInjected<Widget> widget;
+    static const int kThreads = 8;
+    static const int kCycles = 200;
+    static const int kChain = 16;
 
-    cog.SetDependencies({
-        &widget,
-        nullptr
-    });
-    widget.SetDependencies({
-        cog
+    DependencyInjected<StressNode> root;
+    root.SetDependencies({
     });
+    root.Initialize();
+
+    // Each thread cycles its own chain on top of the shared root
+    std::atomic<int> good{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back([&]() {
+            DependencyInjected<StressNode> chain[kChain];
+            bool match = true;
+
+            for (int cycle = 0; cycle < kCycles; ++cycle)
+            {
+                for (int i = 0; i < kChain; ++i)
+                {
+                    chain[i].SetDependencies({
+                        root,
+                        i > 0 ? &chain[i - 1] : nullptr,
+                        nullptr
+                    });
+                    chain[i].Initialize();
+                }
+
+                match &= chain[kChain - 1]->GetDepth() == kChain;
+
+                for (int i = kChain - 1; i >= 0; --i)
+                    chain[i].Shutdown();
+            }
+
+            if (match)
+                good++;
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    TEST_CHECK(good == kThreads);
+    root.Shutdown();
+}
+
+void Test_Registry()
+{
+    DependencyRegistry<Widget, Cog, MyImplementation, InterfaceUser> registry;
+    DependencyInjected<Widget> widget;
+    DependencyInjected<Cog> cog;
+    DependencyInjected<MyImplementation> branch;
+    DependencyInjected<InterfaceUser> user;
+
+    TEST_CHECK(registry.Get<Cog>() == nullptr);
+
+    registry.Add(widget);
+    registry.Add(cog);
+    registry.Add(branch);
+    registry.Add(user);
+
+    // Peers and interfaces are wired without naming them
+    registry.AutoWire(widget);
+    registry.AutoWire(cog);
+    registry.AutoWire(branch);
+    registry.AutoWire(user);
+
+    TEST_CHECK(cog.GetDependencies().widget.Get() == widget.GetObjectPtr());
+    TEST_CHECK(cog.GetDependencies().optionalWidget.Get() == widget.GetObjectPtr());
+    TEST_CHECK(widget.GetDependencies().cog.Get() == cog.GetObjectPtr());
+    TEST_CHECK(user.GetDependencies().Branch.Get() == branch.GetObjectPtr());
+
+    TEST_CHECK(registry.Get<IMyInterface>() == branch.GetObjectPtr());
+    TEST_CHECK(!registry.IsInitialized<IMyInterface>());
 
     cog.Initialize();
     widget.Initialize(15);
+    branch.Initialize(10);
+    user.Initialize();
 
-    cog->DoCogThing();
+    TEST_CHECK(registry.IsInitialized<IMyInterface>());
+    TEST_CHECK(registry.Get<InterfaceUser>()->DoThing() == 11);
+    TEST_CHECK(registry.Get<IMyInterface>()->DoThing() == 12);
 
+    user.Shutdown();
+    branch.Shutdown();
     widget.Shutdown();
-    //cog.Shutdown();
+    cog.Shutdown();
+
+    registry.Remove<InterfaceUser>();
+    TEST_CHECK(registry.Get<InterfaceUser>() == nullptr);
+}
+
+void Test_Graph_AutoWire()
+{
+    {
+        DependencyGraph<InterfaceUser, MyImplementation> graph;
+
+        graph.AutoWireAll();
+        TEST_CHECK(graph.Get<InterfaceUser>().GetDependencies().Branch.Get() == graph.Get<MyImplementation>().GetObjectPtr());
+
+        TEST_CHECK(graph.InitializeAll(
+            InitializeArgs<MyImplementation>(10)));
+        TEST_CHECK(graph.Get<InterfaceUser>()->DoThing() == 11);
+        graph.ShutdownAll();
+    }
+
+    // Dependencies outside of the graph are set by hand
+    {
+        ThirdPartyClass third;
+        DependencyGraph<ThirdPartyClassUser, InterfaceUser, MyImplementation> graph;
+
+        ThirdPartyClassUser::Dependencies deps = graph.Wire<ThirdPartyClassUser>();
+        TEST_CHECK(deps.Third.Get() == nullptr);
+        deps.Third = &third;
+        graph.Get<ThirdPartyClassUser>().SetDependencies(deps);
+        graph.Get<InterfaceUser>().SetDependencies(graph.Wire<InterfaceUser>());
+        graph.Get<MyImplementation>().SetDependencies(graph.Wire<MyImplementation>());
+
+        TEST_CHECK(graph.InitializeAll(
+            InitializeArgs<MyImplementation>(10)));
+        graph.Get<ThirdPartyClassUser>()->DoThing();
+        graph.ShutdownAll();
+    }
+}
+
+void Test_Container_AutoWire()
+{
+    DependencyInjected<ChainObject> head;
+    DependencyInjected<FanInObject> fanIn;
+    DependencyInjected<MyImplementation> branch;
+    DependencyInjected<InterfaceUser> user;
+
+    // Handwritten dependencies are kept
+    head.SetDependencies({
+        nullptr
+    });
+
+    DependencyContainer container(2);
+    container.Add(user);
+    container.Add(fanIn, 5);
+    container.Add(branch, 10);
+    container.Add(head);
+
+    // InterfaceUser needs IMyInterface, which nothing provides yet
+    TEST_CHECK(!container.AutoWireAll());
+    TEST_CHECK(fanIn.HasDependencies() && !user.HasDependencies());
+
+    container.Provide<IMyInterface>(branch);
+    TEST_CHECK(container.AutoWireAll());
+
+    TEST_CHECK(fanIn.GetDependencies().a.Get() == head.GetObjectPtr());
+    TEST_CHECK(fanIn.GetDependencies().c.Get() == head.GetObjectPtr());
+    TEST_CHECK(head.GetDependencies().previous.Get() == nullptr);
+    TEST_CHECK(user.GetDependencies().Branch.Get() == branch.GetObjectPtr());
+
+    TEST_CHECK(container.InitializeAll());
+    TEST_CHECK(container.GetLevelCount() == 2);
+    TEST_CHECK(fanIn->GetSum() == 5);
+    TEST_CHECK(user->DoThing() == 11);
+
+    container.ShutdownAll();
+
+    // Two objects of one type only matter to members of that type
+    DependencyInjected<MyImplementation> first, second;
+    DependencyInjected<InterfaceUser> other;
+
+    DependencyContainer twins(2);
+    twins.Add(first, 1);
+    twins.Add(second, 2);
+    twins.Add(other);
+    twins.Provide<IMyInterface>(second);
+
+    TEST_CHECK(twins.AutoWireAll());
+    TEST_CHECK(other.GetDependencies().Branch.Get() == second.GetObjectPtr());
+
+    // Required members that cannot be wired from a provider fail the wiring
+    DependencyInjected<RequestHandler> handler;
+
+    DependencyContainer scoped(1);
+    scoped.Add(handler);
+
+    TEST_CHECK(!scoped.AutoWireAll());
+    TEST_CHECK(!handler.HasDependencies());
+
+#if !defined(DI_DEBUG)
+    // A member that matches both is left unwired instead of picking one
+    DependencyInjected<InterfaceUser> unsure;
+    twins.Add(unsure);
+    twins.Provide<IMyInterface>(first);
+
+    TEST_CHECK(!twins.AutoWireAll());
+    TEST_CHECK(!unsure.HasDependencies());
+#endif // DI_DEBUG
+}
+
+void Test_Container_Reinitialize()
+{
+    DependencyInjected<ChainObject> chain[3];
+    DependencyInjected<FanInObject> fanIn;
+    DependencyInjected<MyImplementation> branch;
+    DependencyInjected<InterfaceUser> user;
+
+    chain[0].SetDependencies({
+        nullptr
+    });
+    chain[1].SetDependencies({
+        chain[0]
+    });
+    chain[2].SetDependencies({
+        chain[1]
+    });
+    fanIn.SetDependencies({
+        chain[2],
+        chain[0],
+        chain[0]
+    });
+    branch.SetDependencies({
+    });
+    user.SetDependencies({
+        branch
+    });
+
+    DependencyContainer container(2);
+    container.Add(fanIn, 1);
+    container.Add(chain[2]);
+    container.Add(chain[1]);
+    container.Add(chain[0]);
+    container.Add(user);
+    container.Add(branch, 10);
+
+    TEST_CHECK(container.InitializeAll());
+    TEST_CHECK(fanIn->GetSum() == 3);
+    TEST_CHECK(user->DoThing() == 11);
+
+    const std::vector<IDependencyInjected*> dependents = container.GetDependents(chain[1]);
+    TEST_CHECK(dependents.size() == 2);
+    TEST_CHECK(dependents[0] == &chain[2] && dependents[1] == &fanIn);
+
+    // Only chain[1] and its users restart.  ChainObject checks that its
+    // previous link is up, so the order is verified too
+    TEST_CHECK(container.Reinitialize(chain[1]));
+    TEST_CHECK(chain[2]->GetDepth() == 2);
+    TEST_CHECK(fanIn->GetSum() == 3);
+    TEST_CHECK(user->DoThing() == 12);
+
+    // New arguments replace the ones from Add()
+    TEST_CHECK(container.Reinitialize(fanIn, 100));
+    TEST_CHECK(fanIn->GetSum() == 102);
+    TEST_CHECK(container.GetDependents(fanIn).empty());
+
+    TEST_CHECK(container.Reinitialize(chain[0]));
+    TEST_CHECK(fanIn->GetSum() == 102);
+    TEST_CHECK(user->DoThing() == 13);
+
+    container.ShutdownAll();
+    TEST_CHECK(!fanIn.IsInitialized() && !chain[0].IsInitialized() && !branch.IsInitialized());
+}
+
+void Test_NumaPlacement()
+{
+    const unsigned nodeCount = GetNumaNodeCount();
+    TEST_CHECK(nodeCount >= 1);
+    TEST_CHECK(!BindThreadToNumaNode(nodeCount + 1000));
+
+    NumaArena arena(0);
+    TEST_CHECK(arena.GetNode() == 0 && arena.GetReservedBytes() == 0);
+
+    DependencyInjected<NumaProbe, ArenaStorage> placed(arena);
+    DependencyInjected<NumaProbe, ArenaStorage> placed2(arena);
+    DependencyInjected<NumaProbe> unplaced;
+    TEST_CHECK(arena.GetReservedBytes() >= sizeof(NumaProbe) * 2);
+    TEST_CHECK(placed.GetObjectPtr() != placed2.GetObjectPtr());
+
+    // Oversized allocations get a block of their own
+    void* big = arena.allocate(256 * 1024, 64);
+    TEST_CHECK(big != nullptr && reinterpret_cast<uintptr_t>(big) % 64 == 0);
+    memset(big, 0, 256 * 1024);
+    TEST_CHECK(arena.GetReservedBytes() >= 256 * 1024);
+
+    placed.SetDependencies({
+    });
+    placed2.SetDependencies({
+    });
+    unplaced.SetDependencies({
+    });
+
+    DependencyContainer container(2);
+    container.Add(placed);
+    container.Add(placed2);
+    container.Add(unplaced);
+    container.SetNumaNode(placed, 0);
+    container.SetNumaNode(placed2, 0);
+
+    TEST_CHECK(container.InitializeAll());
+    TEST_CHECK(placed->Buffer.size() == 4096 && unplaced->Buffer.size() == 4096);
+
+    // Both placed objects ran on the one thread bound to node 0
+    TEST_CHECK(placed->Owner != std::this_thread::get_id());
+    TEST_CHECK(placed->Owner == placed2->Owner);
+
+    // Restarts keep the placement
+    TEST_CHECK(container.Reinitialize(placed));
+    TEST_CHECK(placed->Owner != std::this_thread::get_id());
+
+    container.ShutdownAll();
+    TEST_CHECK(!placed.IsInitialized() && !unplaced.IsInitialized());
+
+    std::cout << "NUMA nodes: " << nodeCount
+        << ", arena placed by OS: " << (arena.IsPlaced() ? "yes" : "no") << std::endl;
+}
+
+void Test_Container_StartupReport()
+{
+    // base -> slow -> top is the critical path, base -> fast -> top is not
+    DependencyInjected<SlowStartObject> base, slow, fast, top;
+
+    base.SetDependencies({
+        nullptr,
+        nullptr
+    });
+    slow.SetDependencies({
+        base,
+        nullptr
+    });
+    fast.SetDependencies({
+        base,
+        nullptr
+    });
+    top.SetDependencies({
+        slow,
+        fast
+    });
+
+    DependencyContainer container(2);
+    container.Add(base, 5);
+    container.Add(slow, 30);
+    container.Add(fast, 1);
+    container.Add(top, 2);
+
+    TEST_CHECK(container.InitializeAll());
+
+    const DependencyStartupReport report = container.GetStartupReport();
+    TEST_CHECK(report.Nodes.size() == 4);
+    TEST_CHECK(report.Nodes[0].Wrapper == &base && report.Nodes[0].Level == 0);
+    TEST_CHECK(report.Nodes[3].Level == 2 && report.Nodes[3].DependsOn.size() == 2);
+    TEST_CHECK(report.Nodes[1].Elapsed >= std::chrono::milliseconds(30));
+    TEST_CHECK(report.Nodes[1].Start >= report.Nodes[0].Start + report.Nodes[0].Elapsed);
+
+    TEST_CHECK(report.CriticalPath.size() == 3);
+    TEST_CHECK(report.CriticalPath[0] == 0 && report.CriticalPath[1] == 1 && report.CriticalPath[2] == 3);
+    TEST_CHECK(!report.Nodes[2].OnCriticalPath && report.Nodes[3].OnCriticalPath);
+    TEST_CHECK(report.CriticalPathElapsed >= std::chrono::milliseconds(37));
+    TEST_CHECK(report.CriticalPathElapsed == report.Nodes[3].EarliestFinish);
+    TEST_CHECK(report.Elapsed >= report.CriticalPathElapsed);
+
+    std::ostringstream dot;
+    report.WriteDot(dot);
+    TEST_CHECK(dot.str().find("digraph") == 0);
+    TEST_CHECK(dot.str().find("n0 [label=\"SlowStartObject\\n") != std::string::npos);
+    TEST_CHECK(dot.str().find("n3 -> n1 [color=red") != std::string::npos);
+    TEST_CHECK(dot.str().find("n3 -> n2;") != std::string::npos);
+
+    std::ostringstream json;
+    report.WriteJson(json);
+    TEST_CHECK(json.str().find("\"criticalPath\":[0,1,3]") != std::string::npos);
+    TEST_CHECK(json.str().find("\"dependsOn\":[1,2]") != std::string::npos);
+
+    container.ShutdownAll();
+}
+
+void Test_Container_Rollback()
+{
+    std::vector<int> shutdownLog;
+    FlakyBackend backends[4];
+    for (FlakyBackend& backend : backends)
+        backend.ShutdownLog = &shutdownLog;
+
+    // a <- b <- c, plus d on its own
+    DependencyInjected<FlakyObject> a, b, c, d;
+    a.SetDependencies({
+        nullptr
+    });
+    b.SetDependencies({
+        a
+    });
+    c.SetDependencies({
+        b
+    });
+    d.SetDependencies({
+        nullptr
+    });
+
+    DependencyContainer container(2);
+    container.Add(c, 2, &backends[2]);
+    container.Add(b, 1, &backends[1]);
+    container.Add(a, 0, &backends[0]);
+    container.Add(d, 3, &backends[3]);
+
+    DependencyRetryPolicy retry;
+    retry.MaxAttempts = 3;
+    retry.InitialBackoff = std::chrono::milliseconds(1);
+    container.SetRetryPolicy(retry);
+
+    // Only b is retried, and it is shut down after each failure
+    backends[1].FailuresLeft = 2;
+    TEST_CHECK(container.InitializeAllOrRollback());
+    TEST_CHECK(a->Up && b->Up && c->Up && d->Up);
+    TEST_CHECK(backends[0].Initializes == 1 && backends[1].Initializes == 3 && backends[2].Initializes == 1);
+    TEST_CHECK(shutdownLog == std::vector<int>({ 1, 1 }));
+
+    const DependencyStartupReport report = container.GetStartupReport();
+    TEST_CHECK(report.Nodes[1].Attempts == 3 && !report.Nodes[1].Failed);
+    TEST_CHECK(report.Nodes[0].Attempts == 1 && report.Nodes[2].Attempts == 1);
+
+    // Reinitialize() retries too
+    backends[1].FailuresLeft = 1;
+    TEST_CHECK(container.Reinitialize(b));
+    TEST_CHECK(b->Up && c->Up);
+    TEST_CHECK(container.GetStartupReport().Nodes[1].Attempts == 2);
+
+    container.ShutdownAll();
+    TEST_CHECK(!a.IsInitialized() && !b.IsInitialized() && !c.IsInitialized() && !d.IsInitialized());
+
+    // Out of attempts: Everything that came up is shut down again
+    for (FlakyBackend& backend : backends)
+        backend.Initializes = 0;
+    backends[1].FailuresLeft = 3;
+    shutdownLog.clear();
+
+    TEST_CHECK(!container.InitializeAllOrRollback());
+    TEST_CHECK(!a.IsInitialized() && !b.IsInitialized() && !c.IsInitialized() && !d.IsInitialized());
+    TEST_CHECK(backends[1].Initializes == 3 && backends[2].Initializes == 0);
+    TEST_CHECK(shutdownLog.size() == 5);
+    TEST_CHECK(shutdownLog[0] == 1 && shutdownLog[1] == 1 && shutdownLog[2] == 1);
+    TEST_CHECK(container.GetStartupReport().Nodes[1].Failed);
+
+    // The container can be initialized again once the backend is back
+    TEST_CHECK(container.InitializeAllOrRollback());
+    TEST_CHECK(c->Up);
+    container.ShutdownAll();
+}
+
+void Test_Registry_MissingProvider()
+{
+    DependencyRegistry<MyImplementation, InterfaceUser> registry;
+    DependencyInjected<InterfaceUser> user;
+
+    registry.Add(user);
+
+    // MyImplementation was never added, so the required Branch is null
+    registry.AutoWire(user);
+}
+
+void Test_Trace()
+{
+    DependencyTracer::Get().Clear();
+
+    DependencyInjected<MyImplementation> branch;
+    DependencyInjected<BufferObject> buffer;
+
+    branch.SetDependencies({
+    });
+    buffer.SetDependencies({
+        branch
+    });
+
+    branch.Initialize(10);
+    buffer.Initialize();
+    buffer.Shutdown();
+    branch.Shutdown();
+
+    const std::vector<DependencyTraceEvent> events = DependencyTracer::Get().GetEvents();
+
+    // Nested LeafObject is traced inside MyImplementation
+    TEST_CHECK(events.size() == 6);
+
+    bool foundBuffer = false;
+    for (const DependencyTraceEvent& e : events)
+    {
+        if (std::string(e.TypeName) == "BufferObject" && std::string(e.Phase) == "Initialize")
+        {
+            foundBuffer = true;
+            TEST_CHECK(e.Allocations >= 1);
+            TEST_CHECK(e.AllocatedBytes >= 256 * sizeof(int));
+            TEST_CHECK(e.Edges.size() == 1 && e.Edges[0] == branch.GetObjectPtr());
+        }
+    }
+    TEST_CHECK(foundBuffer);
+
+    std::ostringstream json;
+    DependencyTracer::Get().WriteChromeTrace(json);
+    const std::string trace = json.str();
+    TEST_CHECK(trace.find("\"traceEvents\"") != std::string::npos);
+    TEST_CHECK(trace.find("\"name\":\"BufferObject\",\"cat\":\"Initialize\"") != std::string::npos);
+    TEST_CHECK(trace.find("\"dependsOn\":[\"MyImplementation\"]") != std::string::npos);
+
+    // Array and over-aligned allocations are counted too
+    struct alignas(128) AlignedBlock
+    {
+        char Bytes[128];
+    };
+
+    const DependencyDetail::TraceAllocationCounters before = DependencyDetail::GetTraceAllocationCounters();
+    int* array = new int[64];
+    AlignedBlock* aligned = new AlignedBlock;
+    AlignedBlock* alignedArray = new AlignedBlock[2];
+    const DependencyDetail::TraceAllocationCounters after = DependencyDetail::GetTraceAllocationCounters();
+
+    TEST_CHECK(reinterpret_cast<uintptr_t>(aligned) % alignof(AlignedBlock) == 0);
+    TEST_CHECK(reinterpret_cast<uintptr_t>(alignedArray) % alignof(AlignedBlock) == 0);
+    TEST_CHECK(after.Count == before.Count + 3);
+    TEST_CHECK(after.Bytes >= before.Bytes + 64 * sizeof(int) + 3 * sizeof(AlignedBlock));
+
+    delete[] alignedArray;
+    delete aligned;
+    delete[] array;
+}
+
+
+// Only runs the test named on the command line, if any
+static const char* TestFilter = nullptr;
+static int TestsRun = 0;
+
+static bool TestSelected(const char* name)
+{
+    if (TestFilter && strcmp(TestFilter, name) != 0)
+        return false;
+    TestsRun++;
+    return true;
 }
 
+#if defined(_WIN32)
+
+#define TEST_EXPECT_NOASSERT(function) \
+    if (TestSelected(#function)) { \
+        __try { \
+            function(); \
+            cout << "*** " #function "() succeeded" << endl << endl; \
+        } \
+        __except (true) { \
+            cout << "!!! Unexpected assertion in " #function "()" << endl; \
+            return false; \
+        } \
+    }
+
+#define TEST_EXPECT_ASSERT(function) \
+    if (TestSelected(#function)) { \
+        __try { \
+            function(); \
+            cout << "!!! Assertion not fired in " #function "()" << endl; \
+            return false; \
+        } \
+        __except (true) { \
+            cout << "*** Expected assertion fired in " #function "()" << endl << endl; \
+        } \
+    }
+
+#else // _WIN32
+
+// Runs the test in a child process so that an assertion shows up as the
+// child dying from a signal.  Returns true if the child exited normally
+static bool RunIsolated(void (*function)())
+{
+    cout.flush();
+    fflush(stdout);
+
+    const pid_t pid = fork();
+    if (pid < 0)
+    {
+        cout << "!!! fork() failed" << endl;
+        return false;
+    }
+    if (pid == 0)
+    {
+        function();
+        cout.flush();
+        fflush(stdout);
+        _exit(0);
+    }
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0)
+    {
+        if (errno != EINTR)
+            return false;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
 
 #define TEST_EXPECT_NOASSERT(function) \
-    __try { \
-        function(); \
-        cout << "*** " #function "() succeeded" << endl << endl; \
-    } \
-    __except (true) { \
-        cout << "!!! Unexpected assertion in " #function "()" << endl; \
-        return false; \
+    if (TestSelected(#function)) { \
+        if (RunIsolated(&function)) { \
+            cout << "*** " #function "() succeeded" << endl << endl; \
+        } \
+        else { \
+            cout << "!!! Unexpected assertion in " #function "()" << endl; \
+            return false; \
+        } \
     }
 
 #define TEST_EXPECT_ASSERT(function) \
-    __try { \
-        function(); \
-        cout << "!!! Assertion not fired in " #function "()" << endl; \
-        return false; \
-    } \
-    __except (true) { \
-        cout << "*** Expected assertion fired in " #function "()" << endl << endl; \
+    if (TestSelected(#function)) { \
+        if (RunIsolated(&function)) { \
+            cout << "!!! Assertion not fired in " #function "()" << endl; \
+            return false; \
+        } \
+        else { \
+            cout << "*** Expected assertion fired in " #function "()" << endl << endl; \
+        } \
     }
 
+#endif // _WIN32
+
 bool RunTests()
 {
     TEST_EXPECT_NOASSERT(Test_ThirdPartyObject);
@@ -535,6 +3642,41 @@ bool RunTests()
     TEST_EXPECT_ASSERT(Test_Forget_InitWidget);
     TEST_EXPECT_ASSERT(Test_Forget_ShutdownWidget);
     TEST_EXPECT_ASSERT(Test_Forget_ShutdownCog);
+    TEST_EXPECT_NOASSERT(Test_Optional_StoppedWrapper);
+    TEST_EXPECT_NOASSERT(Test_Container_ParallelInit);
+    TEST_EXPECT_ASSERT(Test_Container_Cycle);
+    TEST_EXPECT_NOASSERT(Test_Graph_LateBoundPeers);
+    TEST_EXPECT_NOASSERT(Test_Alignment);
+    TEST_EXPECT_NOASSERT(Test_MoveOnlyArguments);
+    TEST_EXPECT_NOASSERT(Test_FastReset);
+    TEST_EXPECT_NOASSERT(Test_Pool);
+    TEST_EXPECT_NOASSERT(Test_StoragePolicies);
+    TEST_EXPECT_NOASSERT(Test_LazyInit);
+    TEST_EXPECT_NOASSERT(Test_HotSwap);
+    TEST_EXPECT_NOASSERT(Test_BoundInterface);
+    TEST_EXPECT_ASSERT(Test_BoundInterface_Mock);
+    TEST_EXPECT_NOASSERT(Test_ForwardDeclaredDependency);
+    TEST_EXPECT_NOASSERT(Test_Trace);
+    TEST_EXPECT_NOASSERT(Test_Container_ShutdownDeadline);
+    TEST_EXPECT_NOASSERT(Test_Container_ShutdownByDependents);
+    TEST_EXPECT_NOASSERT(Test_Batch);
+    TEST_EXPECT_NOASSERT(Test_Snapshot);
+    TEST_EXPECT_NOASSERT(Test_AsyncInit);
+    TEST_EXPECT_NOASSERT(Test_HardenedChecks);
+    TEST_EXPECT_NOASSERT(Test_ViolationLog);
+    TEST_EXPECT_NOASSERT(Test_AccessCounters);
+    TEST_EXPECT_NOASSERT(Test_ThreadLocal);
+    TEST_EXPECT_NOASSERT(Test_RequestScope);
+    TEST_EXPECT_NOASSERT(Test_Stress_RandomGraph);
+    TEST_EXPECT_NOASSERT(Test_Stress_ThreadCycles);
+    TEST_EXPECT_NOASSERT(Test_Registry);
+    TEST_EXPECT_ASSERT(Test_Registry_MissingProvider);
+    TEST_EXPECT_NOASSERT(Test_Graph_AutoWire);
+    TEST_EXPECT_NOASSERT(Test_Container_AutoWire);
+    TEST_EXPECT_NOASSERT(Test_Container_Reinitialize);
+    TEST_EXPECT_NOASSERT(Test_NumaPlacement);
+    TEST_EXPECT_NOASSERT(Test_Container_StartupReport);
+    TEST_EXPECT_NOASSERT(Test_Container_Rollback);
 
     return true;
 }
@@ -543,26 +3685,31 @@ bool RunTests()
 //------------------------------------------------------------------------------
 // Entrypoint
 
-int main()
+// Usage: DependencyInjectedTester [Test_Name]
+int main(int argc, char* argv[])
 {
-    if (RunTests())
+    if (argc > 1)
+        TestFilter = argv[1];
+
+    if (!RunTests())
     {
-        cout << "Tests PASSED" << endl;
+        cout << "!!! Tests FAILED !!!" << endl;
+        return 1;
     }
-    else
+    if (TestsRun == 0)
     {
-        cout << "!!! Tests FAILED !!!" << endl;
+        cout << "!!! No test named " << TestFilter << endl;
+        return 1;
     }
 
-    int x;
-    cin >> x;
-
+    cout << "Tests PASSED" << endl;
     return 0;
 }
 
 /*
 Note: Must be built in Debug mode.
-Note: Must be run with debugger DETACHED so assertions can be handled.
+Note: On Windows, must be run with debugger DETACHED so assertions can be handled.
+Note: Elsewhere, each test runs in a forked child and assertions are signals.
 
 Expected Output:
 
@@ -626,5 +3773,125 @@ Cog::DoCogThing2()
 Widget::Shutdown()
 *** Expected assertion fired in Test_Forget_ShutdownCog()
 
+*** Test_Optional_StoppedWrapper() succeeded
+
+Levels = 5
+*** Test_Container_ParallelInit() succeeded
+
+*** Expected assertion fired in Test_Container_Cycle()
+
+Pulley::Initialize()
+MyImplementation::Initialize()
+LeafObject::Initialize()
+Belt::Initialize()
+InterfaceUser::Initialize()
+InterfaceUser::Shutdown()
+Belt::Shutdown()
+MyImplementation::Shutdown()
+LeafObject::Shutdown()
+Pulley::Shutdown()
+*** Test_Graph_LateBoundPeers() succeeded
+
+LeafObject::Initialize()
+LeafObject::Initialize()
+MyImplementation::Initialize()
+LeafObject::Initialize()
+InterfaceUser::Initialize()
+InterfaceUser::Shutdown()
+MyImplementation::Shutdown()
+LeafObject::Shutdown()
+LeafObject::Shutdown()
+LeafObject::Shutdown()
+*** Test_Alignment() succeeded
+
+LeafObject::Initialize()
+LeafObject::Shutdown()
+*** Test_MoveOnlyArguments() succeeded
+
+*** Test_FastReset() succeeded
+
+LeafObject::Initialize()
+LeafObject::Shutdown()
+*** Test_Pool() succeeded
+
+MyImplementation::Initialize()
+LeafObject::Initialize()
+InterfaceUser::Initialize()
+InterfaceUser::Shutdown()
+MyImplementation::Shutdown()
+LeafObject::Shutdown()
+*** Test_StoragePolicies() succeeded
+
+MyImplementation::Initialize()
+LeafObject::Initialize()
+MyImplementation::Shutdown()
+LeafObject::Shutdown()
+*** Test_LazyInit() succeeded
+
+*** Test_HotSwap() succeeded
+
+MyImplementation::Initialize()
+LeafObject::Initialize()
+MyImplementation::Shutdown()
+LeafObject::Shutdown()
+*** Test_BoundInterface() succeeded
+
+*** Expected assertion fired in Test_BoundInterface_Mock()
+
+*** Test_ForwardDeclaredDependency() succeeded
+
+MyImplementation::Initialize()
+LeafObject::Initialize()
+MyImplementation::Shutdown()
+LeafObject::Shutdown()
+*** Test_Trace() succeeded
+
+*** Test_Container_ShutdownDeadline() succeeded
+
+*** Test_Container_ShutdownByDependents() succeeded
+
+*** Test_Batch() succeeded
+
+*** Test_Snapshot() succeeded
+
+*** Test_AsyncInit() succeeded
+
+*** Test_HardenedChecks() succeeded
+
+LeafObject::Initialize()
+LeafObject::Shutdown()
+LeafObject::Initialize()
+LeafObject::Shutdown()
+
+*** Test_ViolationLog() succeeded
+
+*** Test_AccessCounters() succeeded
+
+*** Test_ThreadLocal() succeeded
+
+*** Test_RequestScope() succeeded
+
+*** Test_Stress_RandomGraph() succeeded
+
+*** Test_Stress_ThreadCycles() succeeded
+
+*** Test_Registry() succeeded
+
+*** Expected assertion fired in Test_Registry_MissingProvider()
+
+*** Test_Graph_AutoWire() succeeded
+
+*** Test_Container_AutoWire() succeeded
+
+*** Test_Container_Reinitialize() succeeded
+
+NUMA nodes: 1, arena placed by OS: yes
+
+*** Test_NumaPlacement() succeeded
+
+*** Test_Container_StartupReport() succeeded
+
+*** Test_Container_Rollback() succeeded
+
 Tests PASSED
 */